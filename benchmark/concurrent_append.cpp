@@ -0,0 +1,126 @@
+#include "ColumnStore.hpp"
+#include "RowStore.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <mutable/mutable.hpp>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace {
+
+#ifndef NDEBUG
+constexpr std::size_t NUM_ROWS = 1UL << 20;
+#else
+constexpr std::size_t NUM_ROWS = 1UL << 24;
+#endif
+/* Rows a writer appends at once, e.g. the records of a parsed chunk of a CSV file. */
+constexpr std::size_t BATCH_ROWS = 256;
+
+/** Creates the table `events` with an integer key, a timestamp and a short tag, in a new catalog. */
+m::Table &create_events()
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    auto &DB = C.add_database(C.pool("dbsys20"));
+    auto &T = DB.add_table(C.pool("events"));
+    T.push_back(C.pool("id"),   m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    T.push_back(C.pool("time"), m::Type::Get_Integer(m::Type::TY_Vector, 8));
+    T.push_back(C.pool("tag"),  m::Type::Get_Char(m::Type::TY_Vector, 16));
+    return T;
+}
+
+void store_value(const BitAddress &location, const void *value, std::size_t bytes) {
+    memcpy(location.base + location.bit / 8, value, bytes);
+}
+
+/** Writes the row `row` of event `i`, the same way for both stores. */
+template<typename Location>
+void write_row(Location &&value_location, std::size_t row, std::size_t i)
+{
+    const int32_t id = int32_t(i);
+    const int64_t time = int64_t(i) * 1000;
+    char tag[16] = "event";
+    tag[5] = char('0' + i % 10);
+    store_value(value_location(0, row), &id, sizeof(id));
+    store_value(value_location(1, row), &time, sizeof(time));
+    store_value(value_location(2, row), tag, sizeof(tag));
+}
+
+/** Appends `NUM_ROWS` rows on `num_threads` threads, in batches of `BATCH_ROWS`, and returns the seconds it takes.
+ * Lock-free writers claim and publish their batches, the others append and write them while holding a mutex. */
+template<typename Store, typename Location>
+double append_rows(Store &store, Location &&value_location, unsigned num_threads, bool lock_free)
+{
+    std::mutex mutex;
+    auto writer = [&](unsigned thread) {
+        const std::size_t begin = NUM_ROWS * thread / num_threads, end = NUM_ROWS * (thread + 1) / num_threads;
+        for (std::size_t i = begin; i < end; i += BATCH_ROWS) {
+            const std::size_t n = std::min(BATCH_ROWS, end - i);
+            if (lock_free) {
+                const auto first = store.claim_rows(n);
+                for (std::size_t j = 0; j != n; ++j) write_row(value_location, first + j, i + j);
+                store.publish_rows(first, n);
+            } else {
+                std::lock_guard<std::mutex> lock(mutex);
+                const auto first = store.num_rows();
+                store.append(n);
+                for (std::size_t j = 0; j != n; ++j) write_row(value_location, first + j, i + j);
+            }
+        }
+    };
+
+    using namespace std::chrono;
+    auto t_begin = steady_clock::now();
+    if (lock_free) store.begin_concurrent_appends();
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t != num_threads; ++t)
+        threads.emplace_back(writer, t);
+    for (auto &t : threads)
+        t.join();
+    if (lock_free) store.end_concurrent_appends();
+    auto t_end = steady_clock::now();
+    return duration<double>(t_end - t_begin).count();
+}
+
+}
+
+/** Appends `NUM_ROWS` rows to a chunked Row Store and to a segmented Column Store from a growing number of threads,
+ * with lock-free concurrent appends and with writers serialized behind a mutex, and reports the rows appended per
+ * second. */
+int main()
+{
+    const unsigned max_threads = std::max(1U, std::thread::hardware_concurrency());
+    for (unsigned num_threads = 1;; num_threads = std::min(2 * num_threads, max_threads)) {
+        for (bool lock_free : { false, true }) {
+            const char *variant = lock_free ? "lock_free" : "mutex";
+            {
+                auto &T = create_events();
+                RowStore::Options options;
+                options.chunked = true;
+                RowStore store(T, options);
+                const auto seconds = append_rows(store, [&](std::size_t id, std::size_t row) {
+                    return store.value_location(row, id);
+                }, num_threads, lock_free);
+                std::cout << "concurrent_append,row_" << variant << "_threads_" << num_threads << ",rows_per_second,"
+                          << NUM_ROWS / seconds << '\n';
+            }
+            {
+                auto &T = create_events();
+                ColumnStore::Options options;
+                options.segmented = true;
+                ColumnStore store(T, options);
+                const auto seconds = append_rows(store, [&](std::size_t id, std::size_t row) {
+                    return store.value_location(id, row);
+                }, num_threads, lock_free);
+                std::cout << "concurrent_append,column_" << variant << "_threads_" << num_threads
+                          << ",rows_per_second," << NUM_ROWS / seconds << '\n';
+            }
+        }
+        if (num_threads == max_threads) break;
+    }
+    return 0;
+}
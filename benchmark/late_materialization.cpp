@@ -0,0 +1,145 @@
+#include "ColumnStore.hpp"
+#include "Loader.hpp"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutable/mutable.hpp>
+#include <sstream>
+
+
+namespace {
+
+#ifndef NDEBUG
+constexpr int NUM_COPIES = 10;
+#else
+constexpr int NUM_COPIES = 100;
+#endif
+constexpr int NUM_REPETITIONS = 10;
+
+/* The filter of `query.sql`. */
+constexpr int64_t MIN_SIZE = 1024 * 1024 * 1024;
+
+}
+
+/** Answers `query.sql` on the packages with mutable's `execute_query()`, by materializing every row before filtering
+ * it, and by filtering `size` first and gathering `id` and `pkg_name` of the qualifying rows only.  Reports the time
+ * per query and the bytes of the columns each strategy touches. */
+int main(int argc, const char **argv)
+{
+    const char *path = argc > 1 ? argv[1] : "resource/arch-packages.csv";
+    const char *query_path = argc > 2 ? argv[2] : "query.sql";
+
+    auto &C = m::Catalog::Get();
+    m::Diagnostic diag(true, std::cout, std::cerr);
+
+    C.register_store<ColumnStore>(C.pool("MyColStore"));
+    C.default_store(C.pool("MyColStore"));
+
+    auto &DB = C.add_database(C.pool("dbsys20"));
+    C.set_database_in_use(DB);
+
+    auto &T = DB.add_table(C.pool("packages"));
+    T.push_back(C.pool("id"),           m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    T.push_back(C.pool("repo"),         m::Type::Get_Char(m::Type::TY_Vector, 10));
+    T.push_back(C.pool("pkg_name"),     m::Type::Get_Char(m::Type::TY_Vector, 32));
+    T.push_back(C.pool("pkg_ver"),      m::Type::Get_Char(m::Type::TY_Vector, 20));
+    T.push_back(C.pool("description"),  m::Type::Get_Char(m::Type::TY_Vector, 80));
+    T.push_back(C.pool("licenses"),     m::Type::Get_Char(m::Type::TY_Vector, 32));
+    T.push_back(C.pool("size"),         m::Type::Get_Integer(m::Type::TY_Vector, 8));
+    T.push_back(C.pool("packager"),     m::Type::Get_Char(m::Type::TY_Vector, 32));
+    T.store(C.create_store(T));
+
+    /* Load the packages several times, so that the columns do not fit into the caches. */
+    for (int i = 0; i != NUM_COPIES; ++i)
+        load_CSV_or_snapshot(diag, T, path);
+    if (diag.num_errors()) return 1;
+
+    std::string query;
+    {
+        std::ifstream in(query_path);
+        std::stringstream sql;
+        sql << in.rdbuf();
+        query = sql.str();
+    }
+
+    auto &store = static_cast<ColumnStore&>(T.store());
+    const auto id = T[C.pool("id")].id;
+    const auto pkg_name = T[C.pool("pkg_name")].id;
+    const auto size = T[C.pool("size")].id;
+    const std::size_t num_rows = store.num_rows();
+    const std::size_t id_bytes = T[id].type->size() / 8;
+    const std::size_t pkg_name_bytes = T[pkg_name].type->size() / 8;
+    const std::size_t size_bytes = T[size].type->size() / 8;
+
+    using namespace std::chrono;
+    auto seconds_per_query = [](auto begin, auto end) {
+        return duration<double>(end - begin).count() / NUM_REPETITIONS;
+    };
+
+    /* mutable's interpretation of the query. */
+    std::size_t num_results_query = 0;
+    auto t_query_begin = steady_clock::now();
+    for (int i = 0; i != NUM_REPETITIONS; ++i) {
+        auto stmt = m::statement_from_string(diag, query);
+        std::unique_ptr<m::SelectStmt> select(static_cast<m::SelectStmt*>(stmt.release()));
+        auto op = std::make_unique<m::CallbackOperator>([&](const m::Schema&, const m::Tuple&) {
+            ++num_results_query;
+        });
+        m::execute_query(diag, *select, std::move(op));
+    }
+    auto t_query_end = steady_clock::now();
+
+    /* Early materialization: every row is copied whole before the filter looks at it. */
+    std::size_t row_bytes = 0;
+    for (const auto &attr : T)
+        row_bytes += (attr.type->size() + 7) / 8;
+    std::vector<uint8_t> row(row_bytes);
+    std::vector<std::pair<int32_t, std::string>> results;
+    auto t_early_begin = steady_clock::now();
+    for (int i = 0; i != NUM_REPETITIONS; ++i) {
+        results.clear();
+        for (std::size_t r = 0; r != num_rows; ++r) {
+            std::size_t offset = 0, size_offset = 0, pkg_name_offset = 0;
+            for (const auto &attr : T) {
+                const std::size_t bytes = (attr.type->size() + 7) / 8;
+                if (attr.id == size) size_offset = offset;
+                if (attr.id == pkg_name) pkg_name_offset = offset;
+                memcpy(row.data() + offset, store.values(attr.id, r), bytes);
+                offset += bytes;
+            }
+            int64_t value;
+            memcpy(&value, row.data() + size_offset, sizeof(value));
+            if (value <= MIN_SIZE) continue;
+            int32_t value_id;
+            memcpy(&value_id, row.data(), id_bytes); // `id` comes first
+            auto name = reinterpret_cast<const char *>(row.data() + pkg_name_offset);
+            results.emplace_back(value_id, std::string(name, strnlen(name, pkg_name_bytes)));
+        }
+    }
+    auto t_early_end = steady_clock::now();
+
+    /* Late materialization: filter the predicate column, then gather the projected columns of the hits. */
+    std::size_t num_results_late = 0;
+    auto t_late_begin = steady_clock::now();
+    for (int i = 0; i != NUM_REPETITIONS; ++i) {
+        const auto projection = store.project(store.filter(size, predicate::Comparison::Greater, MIN_SIZE),
+                                              { id, pkg_name });
+        num_results_late = projection.rows.size();
+    }
+    auto t_late_end = steady_clock::now();
+
+    if (num_results_query != NUM_REPETITIONS * num_results_late or results.size() != num_results_late) {
+        std::cerr << "strategies disagree on the number of results\n";
+        return 1;
+    }
+
+    const std::size_t early_bytes = num_rows * row_bytes;
+    const std::size_t late_bytes = num_rows * size_bytes + num_results_late * (id_bytes + pkg_name_bytes);
+    std::cout << "late_materialization,execute_query,seconds," << seconds_per_query(t_query_begin, t_query_end) << '\n'
+              << "late_materialization,early,seconds," << seconds_per_query(t_early_begin, t_early_end) << '\n'
+              << "late_materialization,early,bytes_touched," << early_bytes << '\n'
+              << "late_materialization,late,seconds," << seconds_per_query(t_late_begin, t_late_end) << '\n'
+              << "late_materialization,late,bytes_touched," << late_bytes << '\n'
+              << "late_materialization,late,selectivity," << double(num_results_late) / num_rows << '\n';
+}
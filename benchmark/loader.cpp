@@ -0,0 +1,93 @@
+#include "ColumnStore.hpp"
+#include "Loader.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutable/mutable.hpp>
+#include <sstream>
+#include <thread>
+
+
+namespace {
+
+#ifndef NDEBUG
+constexpr int NUM_COPIES = 10;
+#else
+constexpr int NUM_COPIES = 100;
+#endif
+
+/** Creates the empty table `packages` in a new catalog. */
+m::Table &create_packages()
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    C.register_store<ColumnStore>(C.pool("MyColStore"));
+    C.default_store(C.pool("MyColStore"));
+
+    auto &DB = C.add_database(C.pool("dbsys20"));
+    C.set_database_in_use(DB);
+
+    auto &T = DB.add_table(C.pool("packages"));
+    T.push_back(C.pool("id"),           m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    T.push_back(C.pool("repo"),         m::Type::Get_Char(m::Type::TY_Vector, 10));
+    T.push_back(C.pool("pkg_name"),     m::Type::Get_Char(m::Type::TY_Vector, 32));
+    T.push_back(C.pool("pkg_ver"),      m::Type::Get_Char(m::Type::TY_Vector, 20));
+    T.push_back(C.pool("description"),  m::Type::Get_Char(m::Type::TY_Vector, 80));
+    T.push_back(C.pool("licenses"),     m::Type::Get_Char(m::Type::TY_Vector, 32));
+    T.push_back(C.pool("size"),         m::Type::Get_Integer(m::Type::TY_Vector, 8));
+    T.push_back(C.pool("packager"),     m::Type::Get_Char(m::Type::TY_Vector, 32));
+    T.store(C.create_store(T));
+    return T;
+}
+
+}
+
+/** Loads `NUM_COPIES` copies of the packages with mutable's loader and with `load_CSV_parallel()` on a growing number
+ * of threads, and reports the seconds each load takes. */
+int main(int argc, const char **argv)
+{
+    const char *path = argc > 1 ? argv[1] : "resource/arch-packages.csv";
+    m::Diagnostic diag(true, std::cout, std::cerr);
+
+    /* Write the copies into one file with a single header. */
+    const auto copies = (std::filesystem::temp_directory_path() / "loader_bench.csv").string();
+    {
+        std::ifstream in(path);
+        std::string header;
+        std::getline(in, header);
+        std::stringstream records;
+        records << in.rdbuf();
+
+        std::ofstream out(copies);
+        out << header << '\n';
+        for (int i = 0; i != NUM_COPIES; ++i)
+            out << records.str();
+    }
+
+    using namespace std::chrono;
+
+    {
+        auto &T = create_packages();
+        auto t_begin = steady_clock::now();
+        load_CSV_presized(diag, T, copies.c_str());
+        auto t_end = steady_clock::now();
+        std::cout << "loader,load_from_CSV,seconds," << duration<double>(t_end - t_begin).count() << '\n';
+    }
+
+    const unsigned max_threads = std::max(1U, std::thread::hardware_concurrency());
+    for (unsigned num_threads = 1;; num_threads = std::min(2 * num_threads, max_threads)) {
+        auto &T = create_packages();
+        auto t_begin = steady_clock::now();
+        load_CSV_parallel(diag, T, copies.c_str(), true, num_threads);
+        auto t_end = steady_clock::now();
+        std::cout << "loader,threads_" << num_threads << ",seconds," << duration<double>(t_end - t_begin).count()
+                  << '\n';
+        if (num_threads == max_threads) break;
+    }
+
+    std::filesystem::remove(copies);
+    return diag.num_errors() != 0;
+}
@@ -1,14 +1,17 @@
 #include "RowStore.hpp"
 #include "ColumnStore.hpp"
+#include "Configured.hpp"
+#include "PaxStore.hpp"
 #include <cassert>
 #include <chrono>
 #include <iostream>
 #include <mutable/util/macro.hpp>
+#include <sys/resource.h>
 
 
 namespace {
 
-#define store_t(X) X(row), X(column),
+#define store_t(X) X(row), X(row_hot), X(row_minpad), X(row_cacheline), X(row_chunked), X(row_mmap), X(row_huge), X(column), X(column_mmap), X(column_huge), X(column_packed), X(column_segmented), X(pax),
 DECLARE_ENUM(store_t);
 const char *store2str[] = { ENUM_TO_STR(store_t) };
 #undef STORE
@@ -19,9 +22,65 @@ constexpr int32_t NUM_TUPLES_RW = 2e6;
 constexpr int32_t NUM_TUPLES_RW = 2e7;
 #endif
 
+/* Attributes filtered together, to be placed first in a row. */
+const std::vector<std::string> HOT_ATTRIBUTES = { "b_b", "e_d", "id_b" };
+const RowStore::Options ROW_HOT = [] { RowStore::Options o; o.layout.hot_attributes = HOT_ATTRIBUTES; return o; }();
+const RowStore::Options ROW_MINPAD = [] {
+    RowStore::Options o;
+    o.layout.policy = LayoutPolicy::MinimalPadding;
+    o.layout.hot_attributes = HOT_ATTRIBUTES;
+    return o;
+}();
+const RowStore::Options ROW_CACHELINE = [] {
+    RowStore::Options o;
+    o.layout.policy = LayoutPolicy::MinimalPadding;
+    o.layout.max_cache_line_padding = 16;
+    return o;
+}();
+const RowStore::Options ROW_CHUNKED = [] { RowStore::Options o; o.chunked = true; return o; }();
+const RowStore::Options ROW_MMAP = [] { RowStore::Options o; o.allocation.backend = memory::Backend::Mmap; return o; }();
+const RowStore::Options ROW_HUGE = [] {
+    RowStore::Options o;
+    o.allocation.backend = memory::Backend::Mmap;
+    o.allocation.huge_pages = true;
+    return o;
+}();
+const ColumnStore::Options COLUMN_MMAP = [] {
+    ColumnStore::Options o;
+    o.allocation.backend = memory::Backend::Mmap;
+    return o;
+}();
+const ColumnStore::Options COLUMN_HUGE = [] {
+    ColumnStore::Options o;
+    o.allocation.backend = memory::Backend::Mmap;
+    o.allocation.huge_pages = true;
+    return o;
+}();
+
+const ColumnStore::Options COLUMN_PACKED = [] {
+    ColumnStore::Options o;
+    o.packed_attributes = { "id_a", "id_b" };
+    return o;
+}();
+
+const ColumnStore::Options COLUMN_SEGMENTED = [] {
+    ColumnStore::Options o;
+    o.segmented = true;
+    return o;
+}();
+
+/** Returns the number of page faults of this process so far. */
+long page_faults()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_minflt + usage.ru_majflt;
+}
+
 }
 
-void benchmark_store(store_t st)
+/** Runs the benchmark on store `st`.  Returns false if the store scans wrong results. */
+bool benchmark_store(store_t st)
 {
     /* Clear the catalog before starting a new benchmark. */
     m::Catalog::Clear();
@@ -36,9 +95,42 @@ void benchmark_store(store_t st)
     if (st == store_t::row) {
         C.register_store<RowStore>(C.pool("MyRowStore"));
         C.default_store(C.pool("MyRowStore"));
+    } else if (st == store_t::row_hot) {
+        C.register_store<Configured<RowStore, ROW_HOT>>(C.pool("MyHotRowStore"));
+        C.default_store(C.pool("MyHotRowStore"));
+    } else if (st == store_t::row_minpad) {
+        C.register_store<Configured<RowStore, ROW_MINPAD>>(C.pool("MyMinPadRowStore"));
+        C.default_store(C.pool("MyMinPadRowStore"));
+    } else if (st == store_t::row_cacheline) {
+        C.register_store<Configured<RowStore, ROW_CACHELINE>>(C.pool("MyCacheLineRowStore"));
+        C.default_store(C.pool("MyCacheLineRowStore"));
+    } else if (st == store_t::row_chunked) {
+        C.register_store<Configured<RowStore, ROW_CHUNKED>>(C.pool("MyChunkedRowStore"));
+        C.default_store(C.pool("MyChunkedRowStore"));
+    } else if (st == store_t::row_mmap) {
+        C.register_store<Configured<RowStore, ROW_MMAP>>(C.pool("MyMmapRowStore"));
+        C.default_store(C.pool("MyMmapRowStore"));
+    } else if (st == store_t::row_huge) {
+        C.register_store<Configured<RowStore, ROW_HUGE>>(C.pool("MyHugeRowStore"));
+        C.default_store(C.pool("MyHugeRowStore"));
     } else if (st == store_t::column) {
         C.register_store<ColumnStore>(C.pool("MyColumnStore"));
         C.default_store(C.pool("MyColumnStore"));
+    } else if (st == store_t::column_mmap) {
+        C.register_store<Configured<ColumnStore, COLUMN_MMAP>>(C.pool("MyMmapColumnStore"));
+        C.default_store(C.pool("MyMmapColumnStore"));
+    } else if (st == store_t::column_huge) {
+        C.register_store<Configured<ColumnStore, COLUMN_HUGE>>(C.pool("MyHugeColumnStore"));
+        C.default_store(C.pool("MyHugeColumnStore"));
+    } else if (st == store_t::column_packed) {
+        C.register_store<Configured<ColumnStore, COLUMN_PACKED>>(C.pool("MyPackedColumnStore"));
+        C.default_store(C.pool("MyPackedColumnStore"));
+    } else if (st == store_t::column_segmented) {
+        C.register_store<Configured<ColumnStore, COLUMN_SEGMENTED>>(C.pool("MySegmentedColumnStore"));
+        C.default_store(C.pool("MySegmentedColumnStore"));
+    } else if (st == store_t::pax) {
+        C.register_store<PaxStore>(C.pool("MyPaxStore"));
+        C.default_store(C.pool("MyPaxStore"));
     } else {
         assert(false and "invalid store");
     }
@@ -97,6 +189,7 @@ void benchmark_store(store_t st)
 
         using namespace std::chrono;
 
+        auto faults_write_begin = page_faults();
         auto t_write_begin = steady_clock::now();
         for (int32_t i = 0; i != NUM_TUPLES_RW; ++i) {
             /* Set tuple data (i, 2*i). */
@@ -105,23 +198,52 @@ void benchmark_store(store_t st)
             W.append(tup);
         }
         auto t_write_end = steady_clock::now();
+        auto faults_write_end = page_faults();
 
         auto stmt = m::statement_from_string(diag, "SELECT id_a, id_b FROM short;");
         std::unique_ptr<m::SelectStmt> query(static_cast<m::SelectStmt*>(stmt.release()));
 
         auto op = std::make_unique<m::CallbackOperator>([](const m::Schema&, const m::Tuple&){});
 
+        auto faults_read_begin = page_faults();
         auto t_read_begin = steady_clock::now();
         m::execute_query(diag, *query, std::move(op));
         auto t_read_end = steady_clock::now();
+        auto faults_read_end = page_faults();
 
         std::cout << "milestone1," << store2str[st] << ",write," << duration_cast<milliseconds>(t_write_end - t_write_begin).count() << '\n'
-                  << "milestone1," << store2str[st] << ",read," << duration_cast<milliseconds>(t_read_end - t_read_begin).count() << '\n';
+                  << "milestone1," << store2str[st] << ",read," << duration_cast<milliseconds>(t_read_end - t_read_begin).count() << '\n'
+                  << "milestone1," << store2str[st] << ",write_faults," << faults_write_end - faults_write_begin << '\n'
+                  << "milestone1," << store2str[st] << ",read_faults," << faults_read_end - faults_read_begin << '\n';
+
+        /* Scan both columns through the store itself, bit-packed columns are unpacked block by block. */
+        if (auto column_store = dynamic_cast<ColumnStore*>(&store)) {
+            column_store->encode(); // pack outside of the measurement, like a load would
+
+            int64_t sum = 0;
+            auto t_scan_begin = steady_clock::now();
+            for (std::size_t id = 0; id != 2; ++id) {
+                column_store->scan(id, [&](std::size_t, const int64_t *values, std::size_t n) {
+                    for (std::size_t i = 0; i != n; ++i) sum += values[i];
+                });
+            }
+            auto t_scan_end = steady_clock::now();
+            if (sum != 3 * (int64_t(NUM_TUPLES_RW) * (NUM_TUPLES_RW - 1) / 2)) {
+                std::cerr << "scan of " << store2str[st] << " sums up to the wrong value\n";
+                return false;
+            }
+
+            std::cout << "milestone1," << store2str[st] << ",scan," << duration_cast<milliseconds>(t_scan_end - t_scan_begin).count() << '\n';
+        }
     }
+    return true;
 }
 
 int main()
 {
-    benchmark_store(store_t::row);
-    benchmark_store(store_t::column);
+    for (auto st : { store_t::row, store_t::row_hot, store_t::row_minpad, store_t::row_cacheline, store_t::row_chunked,
+                     store_t::row_mmap, store_t::row_huge, store_t::column, store_t::column_mmap, store_t::column_huge,
+                     store_t::column_packed, store_t::column_segmented, store_t::pax }) {
+        if (not benchmark_store(st)) return 1;
+    }
 }
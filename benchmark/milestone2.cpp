@@ -1,8 +1,10 @@
+#include "Allocator.hpp"
 #include "BPlusTree.hpp"
 #include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <iostream>
+#include <memory>
 #include <random>
 #include <vector>
 
@@ -105,6 +107,26 @@ int main()
     std::cout << "milestone2,bulkload," << duration_cast<milliseconds>(t_bulkload_end - t_bulkload_begin).count()
               << '\n';
 
+    /* Evaluate bulkload performance with the nodes in an arena, and dropping the tree with the arena. */
+    {
+        auto arena = std::make_shared<memory::ArenaAllocator>();
+        auto t_arena_begin = steady_clock::now();
+        auto arena_tree = btree_type::Bulkload(data, arena);
+        auto t_arena_end = steady_clock::now();
+        std::cout << "milestone2,bulkload_arena," << duration_cast<milliseconds>(t_arena_end - t_arena_begin).count()
+                  << '\n';
+        const auto stats = arena->statistics();
+        std::cout << "milestone2,bulkload_arena_bytes," << stats.allocated_bytes << '\n'
+                  << "milestone2,bulkload_arena_fragmentation," << stats.fragmentation() << '\n';
+
+        auto t_drop_begin = steady_clock::now();
+        { auto dropped = std::move(arena_tree); }
+        arena.reset();
+        auto t_drop_end = steady_clock::now();
+        std::cout << "milestone2,drop_arena," << duration_cast<milliseconds>(t_drop_end - t_drop_begin).count()
+                  << '\n';
+    }
+
     /* Generate missing keys used for lookups. */
     auto missing_keys = gen_misses(g, keys);
     std::shuffle(begin(missing_keys), end(missing_keys), g);
@@ -0,0 +1,89 @@
+#include "ColumnStore.hpp"
+#include "Loader.hpp"
+#include <chrono>
+#include <iostream>
+#include <mutable/mutable.hpp>
+
+
+namespace {
+
+#ifndef NDEBUG
+constexpr int NUM_COPIES = 10;
+#else
+constexpr int NUM_COPIES = 100;
+#endif
+constexpr int NUM_REPETITIONS = 10;
+
+/* The filter of `query.sql`. */
+constexpr int64_t MIN_SIZE = 1024 * 1024 * 1024;
+
+}
+
+/** Filters `packages.size` with the predicate kernels of `ColumnStore` and with `m::execute_query()`, and reports the
+ * tuples per second of both. */
+int main(int argc, const char **argv)
+{
+    const char *path = argc > 1 ? argv[1] : "resource/arch-packages.csv";
+
+    auto &C = m::Catalog::Get();
+    m::Diagnostic diag(true, std::cout, std::cerr);
+
+    C.register_store<ColumnStore>(C.pool("MyColStore"));
+    C.default_store(C.pool("MyColStore"));
+
+    auto &DB = C.add_database(C.pool("dbsys20"));
+    C.set_database_in_use(DB);
+
+    auto &T = DB.add_table(C.pool("packages"));
+    T.push_back(C.pool("id"),           m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    T.push_back(C.pool("repo"),         m::Type::Get_Char(m::Type::TY_Vector, 10));
+    T.push_back(C.pool("pkg_name"),     m::Type::Get_Char(m::Type::TY_Vector, 32));
+    T.push_back(C.pool("pkg_ver"),      m::Type::Get_Char(m::Type::TY_Vector, 20));
+    T.push_back(C.pool("description"),  m::Type::Get_Char(m::Type::TY_Vector, 80));
+    T.push_back(C.pool("licenses"),     m::Type::Get_Char(m::Type::TY_Vector, 32));
+    T.push_back(C.pool("size"),         m::Type::Get_Integer(m::Type::TY_Vector, 8));
+    T.push_back(C.pool("packager"),     m::Type::Get_Char(m::Type::TY_Vector, 32));
+    T.store(C.create_store(T));
+
+    /* Load the packages several times, so that the columns do not fit into the caches. */
+    for (int i = 0; i != NUM_COPIES; ++i)
+        load_CSV_presized(diag, T, path);
+    if (diag.num_errors()) return 1;
+    drop_null_bitmap(T);
+
+    auto &store = static_cast<ColumnStore&>(T.store());
+    const auto size_id = T[C.pool("size")].id;
+    const double num_tuples = double(store.num_rows()) * NUM_REPETITIONS;
+
+    using namespace std::chrono;
+
+    /* Evaluate the filter through mutable's interpretation of the query. */
+    std::size_t num_results_query = 0;
+    auto t_query_begin = steady_clock::now();
+    for (int i = 0; i != NUM_REPETITIONS; ++i) {
+        auto stmt = m::statement_from_string(diag, "SELECT id FROM packages WHERE size > 1024 * 1024 * 1024;");
+        std::unique_ptr<m::SelectStmt> query(static_cast<m::SelectStmt*>(stmt.release()));
+        auto op = std::make_unique<m::CallbackOperator>([&](const m::Schema&, const m::Tuple&) {
+            ++num_results_query;
+        });
+        m::execute_query(diag, *query, std::move(op));
+    }
+    auto t_query_end = steady_clock::now();
+
+    /* Evaluate the filter directly on the column. */
+    std::size_t num_results_kernel = 0;
+    auto t_kernel_begin = steady_clock::now();
+    for (int i = 0; i != NUM_REPETITIONS; ++i)
+        num_results_kernel += store.filter(size_id, predicate::Comparison::Greater, MIN_SIZE).count();
+    auto t_kernel_end = steady_clock::now();
+
+    if (num_results_query != num_results_kernel) {
+        std::cerr << "execute_query and the kernel disagree on the number of results\n";
+        return 1;
+    }
+
+    const auto seconds_query = duration<double>(t_query_end - t_query_begin).count();
+    const auto seconds_kernel = duration<double>(t_kernel_end - t_kernel_begin).count();
+    std::cout << "predicate,execute_query,tuples_per_second," << num_tuples / seconds_query << '\n'
+              << "predicate,kernel,tuples_per_second," << num_tuples / seconds_kernel << '\n';
+}
@@ -0,0 +1,103 @@
+#include "CSV.hpp"
+#include "ColumnStore.hpp"
+#include "Loader.hpp"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutable/mutable.hpp>
+#include <sstream>
+
+
+namespace {
+
+#ifndef NDEBUG
+constexpr int NUM_COPIES = 10;
+#else
+constexpr int NUM_COPIES = 100;
+#endif
+
+/** Runs `f()` and returns the megabytes of `bytes` it processes per second. */
+template<typename F>
+double megabytes_per_second(std::size_t bytes, F &&f)
+{
+    using namespace std::chrono;
+    auto t_begin = steady_clock::now();
+    f();
+    auto t_end = steady_clock::now();
+    return bytes / 1e6 / duration<double>(t_end - t_begin).count();
+}
+
+}
+
+/** Scans `NUM_COPIES` copies of the packages for records and fields, byte by byte and with the vectorized scanner of
+ * `src/CSV.hpp`, and loads them into a column store on one thread.  Reports the MB/s of each. */
+int main(int argc, const char **argv)
+{
+    const char *path = argc > 1 ? argv[1] : "resource/arch-packages.csv";
+
+    std::string header, data;
+    {
+        std::ifstream in(path);
+        std::getline(in, header);
+        std::stringstream records;
+        records << in.rdbuf();
+        for (int i = 0; i != NUM_COPIES; ++i)
+            data += records.str();
+    }
+    const char *begin = data.data(), *end = data.data() + data.size();
+
+    std::size_t num_records = 0, num_fields_scalar = 0, num_fields_simd = 0;
+    std::vector<csv::Field> fields;
+
+    const auto records = megabytes_per_second(data.size(), [&]() {
+        num_records = csv::count_records(begin, end);
+    });
+    const auto scalar = megabytes_per_second(data.size(), [&]() {
+        csv::for_each_record(begin, end, [&](const char *record, const char *record_end) {
+            csv::split_fields(record, record_end, fields);
+            num_fields_scalar += fields.size();
+        });
+    });
+    const auto simd = megabytes_per_second(data.size(), [&]() {
+        csv::for_each_split_record(begin, end, fields, [&](const std::vector<csv::Field> &record) {
+            num_fields_simd += record.size();
+        });
+    });
+    if (num_fields_scalar != num_fields_simd) {
+        std::cerr << "scanners disagree: " << num_fields_scalar << " vs " << num_fields_simd << " fields\n";
+        return 1;
+    }
+
+    /* Convert the fields into the typed values of a column store, on a single thread. */
+    const auto copies = (std::filesystem::temp_directory_path() / "tokenizer_bench.csv").string();
+    {
+        std::ofstream out(copies);
+        out << header << '\n' << data;
+    }
+
+    auto &C = m::Catalog::Get();
+    m::Diagnostic diag(true, std::cout, std::cerr);
+    auto &DB = C.add_database(C.pool("dbsys20"));
+    auto &T = DB.add_table(C.pool("packages"));
+    T.push_back(C.pool("id"),           m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    T.push_back(C.pool("repo"),         m::Type::Get_Char(m::Type::TY_Vector, 10));
+    T.push_back(C.pool("pkg_name"),     m::Type::Get_Char(m::Type::TY_Vector, 32));
+    T.push_back(C.pool("pkg_ver"),      m::Type::Get_Char(m::Type::TY_Vector, 20));
+    T.push_back(C.pool("description"),  m::Type::Get_Char(m::Type::TY_Vector, 80));
+    T.push_back(C.pool("licenses"),     m::Type::Get_Char(m::Type::TY_Vector, 32));
+    T.push_back(C.pool("size"),         m::Type::Get_Integer(m::Type::TY_Vector, 8));
+    T.push_back(C.pool("packager"),     m::Type::Get_Char(m::Type::TY_Vector, 32));
+    T.store(std::make_unique<ColumnStore>(T));
+
+    const auto load = megabytes_per_second(data.size(), [&]() {
+        load_CSV_parallel(diag, T, copies.c_str(), true, 1);
+    });
+    std::filesystem::remove(copies);
+
+    std::cout << "tokenizer,records,MB_per_second," << records << '\n'
+              << "tokenizer,fields_scalar,MB_per_second," << scalar << '\n'
+              << "tokenizer,fields_simd,MB_per_second," << simd << '\n'
+              << "tokenizer,load_column_store,MB_per_second," << load << '\n';
+    return T.store().num_rows() != num_records or diag.num_errors() != 0;
+}
@@ -0,0 +1,71 @@
+#include "ColumnStore.hpp"
+#include "RowStore.hpp"
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutable/mutable.hpp>
+
+
+namespace {
+
+#ifndef NDEBUG
+constexpr int32_t NUM_TUPLES = 2e6;
+#else
+constexpr int32_t NUM_TUPLES = 2e7;
+#endif
+
+/* Selects 1% of the values, i.e. one contiguous range of blocks when the data is sorted. */
+constexpr int64_t RANGE_LO = NUM_TUPLES / 2;
+constexpr int64_t RANGE_HI = RANGE_LO + NUM_TUPLES / 100 - 1;
+
+}
+
+/** Loads `NUM_TUPLES` rows into a store of type `Store`, sorted or shuffled, and measures how many blocks a range scan
+ * skips and how long it takes. */
+template<typename Store>
+void benchmark_zone_map(const char *name, bool sorted)
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("dbsys20"));
+    auto &table = DB.add_table(C.pool("zones"));
+    table.push_back(C.pool("key"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+
+    typename Store::Options options;
+    options.zone_map_attributes = { "key" };
+    table.store(std::make_unique<Store>(table, options));
+    auto &store = static_cast<Store&>(table.store());
+
+    {
+        m::StoreWriter W(store);
+        m::Tuple tup(W.schema());
+        for (int32_t i = 0; i != NUM_TUPLES; ++i) {
+            /* A multiplicative permutation of [0, NUM_TUPLES) spreads neighbouring keys over the whole table. */
+            tup.set(0, sorted ? i : int32_t(int64_t(i) * 7919 % NUM_TUPLES));
+            W.append(tup);
+        }
+    }
+
+    using namespace std::chrono;
+
+    std::size_t skipped = 0;
+    auto t_begin = steady_clock::now();
+    const auto selection = store.select_range(0, RANGE_LO, RANGE_HI, &skipped);
+    auto t_end = steady_clock::now();
+
+    const std::size_t num_blocks = (store.num_rows() + ZoneMap::BLOCK_ROWS - 1) / ZoneMap::BLOCK_ROWS;
+    const char *order = sorted ? "sorted" : "unsorted";
+    std::cout << "zonemap," << name << '_' << order << ",selected," << selection.size() << '\n'
+              << "zonemap," << name << '_' << order << ",skip_rate," << double(skipped) / num_blocks << '\n'
+              << "zonemap," << name << '_' << order << ",scan,"
+              << duration_cast<microseconds>(t_end - t_begin).count() << '\n';
+}
+
+int main()
+{
+    benchmark_zone_map<RowStore>("row", true);
+    benchmark_zone_map<RowStore>("row", false);
+    benchmark_zone_map<ColumnStore>("column", true);
+    benchmark_zone_map<ColumnStore>("column", false);
+}
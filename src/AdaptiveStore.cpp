@@ -0,0 +1,283 @@
+#include "AdaptiveStore.hpp"
+#include "Bits.hpp"
+#include "RowLayout.hpp"
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+
+namespace {
+
+using Layout = AdaptiveStore::Layout;
+
+/** Calls `f` with `store` as the store of `layout`. */
+template<typename F>
+void visit(m::Store &store, Layout layout, F &&f) {
+    if (layout == Layout::Column)
+        f(static_cast<ColumnStore&>(store));
+    else
+        f(static_cast<RowStore&>(store));
+}
+
+/* Locations of values and NULL bits in row `row`, the same way for both stores and their views. */
+template<typename S>
+BitAddress value_in(const S &store, std::size_t row, std::size_t id, RowStore *) {
+    return store.value_location(row, id);
+}
+template<typename S>
+BitAddress value_in(const S &store, std::size_t row, std::size_t id, ColumnStore *) {
+    return store.value_location(id, row);
+}
+template<typename S>
+BitAddress null_in(const S &store, std::size_t row, std::size_t id, RowStore *) {
+    return store.null_location(row, id);
+}
+template<typename S>
+BitAddress null_in(const S &store, std::size_t row, std::size_t id, ColumnStore *) {
+    return store.null_location(id, row);
+}
+
+template<typename S> struct store_of { using type = S; };
+template<> struct store_of<RowStore::ReadView> { using type = RowStore; };
+template<> struct store_of<ColumnStore::ReadView> { using type = ColumnStore; };
+
+/** Copies the rows [`first`, `end`) of `view` into the same rows of `dst`, attribute by attribute. */
+template<typename View, typename Dst>
+void copy_rows(const m::Table &table, const View &view, Dst &dst, std::size_t first, std::size_t end) {
+    typename store_of<View>::type *from = nullptr;
+    Dst *to = nullptr;
+    for (const auto &i : table) {
+        const auto bits = i.type->size();
+        for (std::size_t row = first; row != end; ++row) {
+            const auto src = value_in(view, row, i.id, from), dst_value = value_in(dst, row, i.id, to);
+            copy_bits(dst_value.base, dst_value.bit, src.base, src.bit, bits);
+            const auto src_null = null_in(view, row, i.id, from), dst_null = null_in(dst, row, i.id, to);
+            if (dst_null.base)
+                set_bit(dst_null.base, dst_null.bit, src_null.base and get_bit(src_null.base, src_null.bit));
+        }
+    }
+}
+
+}
+
+const char *AdaptiveStore::name(Layout layout) {
+    switch (layout) {
+        case Layout::Row: return "row";
+        case Layout::Column: return "column";
+        case Layout::Hybrid: return "hybrid";
+    }
+    return "unknown";
+}
+
+AdaptiveStore::AdaptiveStore(const m::Table &table, const Options &options)
+    : Store(table), options(options), current(options.initial)
+{
+    // Without queries noted, the hybrid layout keeps the cold attributes of the options
+    if (current == Layout::Hybrid) {
+        for (const auto &i : table)
+            if (std::find(options.row.cold_attributes.begin(), options.row.cold_attributes.end(), i.name) !=
+                options.row.cold_attributes.end())
+                current_cold.push_back(i.id);
+    }
+    inner = make_store(current, current_cold);
+    relinearize();
+}
+
+AdaptiveStore::~AdaptiveStore() {
+    if (conversion.valid()) conversion.wait();
+}
+
+void AdaptiveStore::append() {
+    // All rows appended so far are written, so a finished conversion can catch up with them and take over
+    finish(false);
+    inner->append();
+    relinearize();
+}
+
+void AdaptiveStore::drop() {
+    // The copy reads from a view of the current store, which must not release the rows of the view meanwhile
+    finish(true);
+    inner->drop();
+    relinearize();
+}
+
+void AdaptiveStore::note_query(std::vector<std::size_t> ids) {
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    ++query_shapes[ids];
+    if (++num_queries % options.min_queries == 0) adapt(false);
+}
+
+bool AdaptiveStore::adapt(bool wait) {
+    bool changed = finish(wait);
+    if (converting() or num_queries < options.min_queries) return changed;
+
+    // Find the cheapest layout, the hybrid layout split as the queries suggest
+    const auto cold = cold_attributes();
+    const double current_cost = cost(current, current_cold);
+    Layout best = current;
+    double best_cost = current_cost;
+    for (auto layout : { Layout::Row, Layout::Column, Layout::Hybrid }) {
+        const double c = cost(layout, cold);
+        if (c < best_cost) {
+            best = layout;
+            best_cost = c;
+        }
+    }
+    if (best_cost > (1 - options.min_gain) * current_cost) return changed;
+
+    start(best, best == Layout::Hybrid ? cold : std::vector<std::size_t>(), best_cost);
+    return finish(wait) or changed;
+}
+
+/** Returns the ids of the attributes the noted queries access at most `cold_access_ratio` as often as the most accessed
+ * one, in ascending order. */
+std::vector<std::size_t> AdaptiveStore::cold_attributes() const {
+    std::vector<uint64_t> accesses(table().size(), 0);
+    for (const auto &shape : query_shapes)
+        for (auto id : shape.first) accesses[id] += shape.second;
+    const uint64_t max_accesses = *std::max_element(accesses.begin(), accesses.end());
+
+    std::vector<std::size_t> cold;
+    for (std::size_t id = 0; id != accesses.size(); ++id)
+        if (accesses[id] <= options.cold_access_ratio * max_accesses) cold.push_back(id);
+    return cold;
+}
+
+/** Returns the bytes per row the noted queries touch in `layout` with the cold attributes `cold`, summed over the
+ * queries.  A row layout reads whole rows of the groups a query accesses, a column layout the columns it accesses. */
+double AdaptiveStore::cost(Layout layout, const std::vector<std::size_t> &cold) const {
+    double total = 0;
+    switch (layout) {
+        case Layout::Row: {
+            const double stride = plan_row_layout(table(), options.row.layout).stride_bytes;
+            for (const auto &shape : query_shapes)
+                total += shape.second * stride;
+            break;
+        }
+
+        case Layout::Column: {
+            const double bitmap_bytes = options.column.null_bitmap ? (table().size() + 7) / 8 : 0;
+            for (const auto &shape : query_shapes) {
+                double bytes = bitmap_bytes;
+                for (auto id : shape.first)
+                    bytes += (table()[id].type->size() + 7) / 8 + options.column_overhead_bytes;
+                total += shape.second * bytes;
+            }
+            break;
+        }
+
+        case Layout::Hybrid: {
+            // Splitting off no attribute or every attribute is the row layout, with more bookkeeping
+            if (cold.empty() or cold.size() == table().size()) return std::numeric_limits<double>::infinity();
+            auto hot_options = options.row.layout, cold_options = options.row.layout;
+            cold_options.null_bitmap = false;
+            for (const auto &i : table()) {
+                const bool is_cold = std::binary_search(cold.begin(), cold.end(), i.id);
+                (is_cold ? hot_options : cold_options).excluded_attributes.emplace_back(i.name);
+            }
+            const double hot_stride = plan_row_layout(table(), hot_options).stride_bytes;
+            const double cold_stride = plan_row_layout(table(), cold_options).stride_bytes;
+            for (const auto &shape : query_shapes) {
+                const bool reads_cold = std::any_of(shape.first.begin(), shape.first.end(), [&](std::size_t id) {
+                    return std::binary_search(cold.begin(), cold.end(), id);
+                });
+                total += shape.second * (hot_stride + (reads_cold ? cold_stride : 0));
+            }
+            break;
+        }
+    }
+    return total;
+}
+
+/** Creates an empty store of `layout`, with the cold attributes `cold` in the hybrid layout. */
+std::unique_ptr<m::Store> AdaptiveStore::make_store(Layout layout, const std::vector<std::size_t> &cold) const {
+    if (layout == Layout::Column) {
+        auto column_options = options.column;
+        column_options.concurrent_readers = true;
+        return std::make_unique<ColumnStore>(table(), column_options);
+    }
+
+    auto row_options = options.row;
+    row_options.concurrent_readers = true;
+    row_options.cold_attributes.clear();
+    if (layout == Layout::Hybrid)
+        for (auto id : cold) row_options.cold_attributes.emplace_back(table()[id].name);
+    return std::make_unique<RowStore>(table(), row_options);
+}
+
+/** Starts converting the rows into `layout`, with the cold attributes `cold` in the hybrid layout. */
+void AdaptiveStore::start(Layout layout, std::vector<std::size_t> cold, double new_cost) {
+    target = layout;
+    target_cold = std::move(cold);
+    target_cost = new_cost;
+
+    // Copy the committed rows from a view, which stays valid while rows are appended to the current store
+    auto copy = [this, from = current, to = layout, store = make_store(layout, target_cold)]() mutable {
+        const auto begin = std::chrono::steady_clock::now();
+        Conversion result;
+        visit(*inner, from, [&](auto &src) {
+            const auto view = src.read_view();
+            result.rows = view.num_rows();
+            visit(*store, to, [&](auto &dst) {
+                dst.append(result.rows);
+                copy_rows(table(), view, dst, 0, result.rows);
+            });
+        });
+        result.store = std::move(store);
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        return result;
+    };
+    conversion = std::async(options.background ? std::launch::async : std::launch::deferred, std::move(copy));
+}
+
+/** Swaps in the converted store, if the conversion is done or `wait`.  Returns true iff the layout changed. */
+bool AdaptiveStore::finish(bool wait) {
+    if (not conversion.valid()) return false;
+    if (options.background and not wait and
+        conversion.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return false;
+
+    auto result = conversion.get();
+
+    // Copy the rows appended since the view was taken, all written by now except maybe the one `drop()` removes next
+    const auto begin = std::chrono::steady_clock::now();
+    visit(*inner, current, [&](auto &src) {
+        src.commit_rows();
+        const auto view = src.read_view();
+        visit(*result.store, target, [&](auto &dst) {
+            dst.append(view.num_rows() - result.rows);
+            copy_rows(table(), view, dst, result.rows, view.num_rows());
+        });
+    });
+    const double seconds =
+        result.seconds + std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    history.push_back({ current, target, inner->num_rows(), num_queries, cost(current, current_cold), target_cost,
+                        seconds });
+
+    // Swap the store and the linearization mutable reads together
+    inner = std::move(result.store);
+    current = target;
+    current_cold = std::move(target_cold);
+    inner_linearization = nullptr;
+    relinearize();
+    return true;
+}
+
+/** Rebuilds the linearization from the current store, if that replaced its own. */
+void AdaptiveStore::relinearize() {
+    if (&inner->linearization() == inner_linearization) return;
+    inner_linearization = &inner->linearization();
+    visit(*inner, current, [this](auto &store) { linearization(store.make_linearization()); });
+}
+
+void AdaptiveStore::dump(std::ostream &out) const {
+    out << "AdaptiveStore for table \"" << table().name << "\": " << num_rows() << " rows in the " << name(current)
+        << " layout, " << num_queries << " queries noted" << (converting() ? ", converting to " : "")
+        << (converting() ? name(target) : "") << '\n';
+    for (const auto &t : history) {
+        out << "  " << name(t.from) << " -> " << name(t.to) << " after " << t.queries << " queries: " << t.rows
+            << " rows in " << t.seconds << " s, " << t.old_cost << " -> " << t.new_cost << " bytes touched\n";
+    }
+    inner->dump(out);
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "ColumnStore.hpp"
+#include "RowStore.hpp"
+#include <future>
+#include <map>
+#include <memory>
+#include <mutable/mutable.hpp>
+#include <vector>
+
+
+/** A store that adapts its layout to the queries it serves.  It keeps its rows in a `RowStore` or a `ColumnStore`,
+ * notes which attributes each query accesses, and converts the rows into the layout whose scans touch the fewest bytes:
+ * whole rows, single columns, or rows split into a group of hot and a group of cold attributes (hybrid).
+ *
+ * Conversions copy the rows on a background thread from a `read_view()` of the current store, while rows are still
+ * appended to it.  Once the copy is done, `append()` or `adapt()` copy the rows appended meanwhile and swap in the new
+ * store together with its linearization, in one step between two of mutable's calls.  Dropping rows may release memory
+ * the copy still reads, so `drop()` waits for the copy to finish and swaps in the new store before it drops a row. */
+struct AdaptiveStore : m::Store
+{
+    /** The layouts the store converts between. */
+    enum class Layout
+    {
+        Row,    ///< all attributes of a row next to each other, in a `RowStore`
+        Column, ///< every attribute in a column of its own, in a `ColumnStore`
+        Hybrid, ///< a `RowStore` with a row group of hot and one of cold attributes
+    };
+
+    /** Options to configure when and how an `AdaptiveStore` converts its rows. */
+    struct Options
+    {
+        /** Layout to start with. */
+        Layout initial = Layout::Row;
+        /** Options of the stores of each layout.  `concurrent_readers` is always enabled, so that rows can be copied
+         * while they are appended, and `cold_attributes` of the hybrid layout follow the queries. */
+        RowStore::Options row;
+        ColumnStore::Options column;
+        /** Reconsider the layout after every `min_queries` noted queries. */
+        std::size_t min_queries = 16;
+        /** Convert only if the new layout touches at most `1 - min_gain` of the bytes the current one touches. */
+        double min_gain = 0.2;
+        /** Bytes per row charged for every column a query reads in the column layout, for stitching the values of a row
+         * back together from separate columns. */
+        std::size_t column_overhead_bytes = 8;
+        /** Attributes accessed at most this fraction as often as the most accessed one are cold in the hybrid
+         * layout. */
+        double cold_access_ratio = 0.1;
+        /** Copy the rows on a background thread.  Otherwise, `adapt()` copies them right away. */
+        bool background = true;
+    };
+
+    /** A conversion from one layout to another. */
+    struct Transition
+    {
+        Layout from, to;
+        /** Rows converted, and queries noted before the conversion started. */
+        std::size_t rows, queries;
+        /** Bytes per row the noted queries touch in the old and in the new layout, summed over the queries. */
+        double old_cost, new_cost;
+        /** Time spent copying the rows, in the background and while swapping. */
+        double seconds;
+    };
+
+    /** Returns the name of `layout`, as `dump()` prints it. */
+    static const char *name(Layout layout);
+
+    private:
+    /** The rows copied by a conversion so far. */
+    struct Conversion
+    {
+        std::unique_ptr<m::Store> store;
+        std::size_t rows = 0;
+        double seconds = 0;
+    };
+
+    Options options;
+    Layout current;
+    // Cold attributes of the hybrid layout, in ascending order
+    std::vector<std::size_t> current_cold;
+    std::unique_ptr<m::Store> inner;
+    // Linearization of `inner` the linearization of this store was built from
+    const m::Linearization *inner_linearization = nullptr;
+
+    // Number of noted queries with each set of accessed attributes
+    std::map<std::vector<std::size_t>, uint64_t> query_shapes;
+    std::size_t num_queries = 0;
+
+    // Conversion in progress and its target
+    std::future<Conversion> conversion;
+    Layout target;
+    std::vector<std::size_t> target_cold;
+    double target_cost = 0;
+
+    std::vector<Transition> history;
+
+    public:
+    AdaptiveStore(const m::Table &table) : AdaptiveStore(table, Options()) {}
+    AdaptiveStore(const m::Table &table, const Options &options);
+    /** Waits for a conversion in progress. */
+    ~AdaptiveStore();
+
+    std::size_t num_rows() const override { return inner->num_rows(); }
+    void append() override;
+    void drop() override;
+
+    /** Notes a query that accesses the attributes with the ids `ids`, and reconsiders the layout after every
+     * `Options::min_queries` queries. */
+    void note_query(std::vector<std::size_t> ids);
+    /** Swaps in a finished conversion, and starts converting if the noted queries touch at most `1 - min_gain` of the
+     * bytes in another layout.  With `wait`, waits for the conversion to finish and swaps it in.  Returns true iff the
+     * layout changed. */
+    bool adapt(bool wait = false);
+    /** Returns true iff a conversion is in progress. */
+    bool converting() const { return conversion.valid(); }
+
+    /** Returns the current layout. */
+    Layout layout() const { return current; }
+    /** Returns the bytes per row the noted queries touch in `layout`, summed over the queries.  The hybrid layout
+     * splits the attributes as the noted queries suggest, and costs infinitely much if that makes no attribute or
+     * every attribute cold. */
+    double cost(Layout layout) const {
+        return cost(layout, layout == Layout::Hybrid ? cold_attributes() : current_cold);
+    }
+    /** Returns the conversions so far. */
+    const std::vector<Transition> &transitions() const { return history; }
+    /** Returns the store that currently holds the rows. */
+    const m::Store &store() const { return *inner; }
+
+    void accept(m::StoreVisitor &v) override { v(*this); }
+    void accept(m::ConstStoreVisitor &v) const override { v(*this); }
+
+    void dump(std::ostream &out) const override;
+    using Store::dump;
+
+    private:
+    std::vector<std::size_t> cold_attributes() const;
+    double cost(Layout layout, const std::vector<std::size_t> &cold) const;
+    std::unique_ptr<m::Store> make_store(Layout layout, const std::vector<std::size_t> &cold) const;
+    void start(Layout layout, std::vector<std::size_t> cold, double new_cost);
+    bool finish(bool wait);
+    void relinearize();
+};
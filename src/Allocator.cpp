@@ -0,0 +1,343 @@
+#include "Allocator.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+
+using namespace memory;
+
+
+namespace {
+
+/** Returns `addr` rounded up to the next multiple of `alignment`, a power of two. */
+uint8_t *align(uint8_t *addr, std::size_t alignment) {
+    return reinterpret_cast<uint8_t *>(round_up(reinterpret_cast<uintptr_t>(addr), alignment));
+}
+
+/** Returns the smallest power of two not less than `n`, which must be positive. */
+std::size_t next_power_of_two(std::size_t n) {
+    return n <= 1 ? 1 : std::size_t(1) << (64 - __builtin_clzl(n - 1));
+}
+
+AllocationOptions mmap_options() {
+    AllocationOptions options;
+    options.backend = Backend::Mmap;
+    return options;
+}
+
+AllocationOptions malloc_options(std::size_t alignment) {
+    AllocationOptions options;
+    options.alignment = alignment;
+    return options;
+}
+
+/** Returns the bytes `malloc()` hands out for an allocation of `bytes` aligned to `alignment`. */
+std::size_t malloc_bytes(std::size_t bytes, std::size_t alignment) {
+    return alignment <= alignof(std::max_align_t) ? bytes : round_up(bytes, alignment);
+}
+
+}
+
+
+/*======================================================================================================================
+ * AllocatorStatistics
+ *====================================================================================================================*/
+
+void AllocatorStatistics::print(std::ostream &out) const {
+    out << allocated_bytes << " bytes allocated (peak " << peak_bytes << "), " << reserved_bytes << " bytes reserved, "
+        << allocations << " allocations, " << reallocations << " reallocations, " << deallocations
+        << " deallocations, fragmentation " << fragmentation() << std::endl;
+}
+
+
+/*======================================================================================================================
+ * Allocator
+ *====================================================================================================================*/
+
+void *Allocator::allocate(std::size_t bytes, std::size_t alignment) {
+    std::lock_guard<std::mutex> lock(mutex);
+    void *addr = do_allocate(bytes, alignment);
+    ++stats.allocations;
+    stats.allocated_bytes += bytes;
+    stats.peak_bytes = std::max(stats.peak_bytes, stats.allocated_bytes);
+    return addr;
+}
+
+void *Allocator::reallocate(void *addr, std::size_t old_bytes, std::size_t new_bytes, std::size_t alignment,
+                            std::size_t *copied_bytes) {
+    if (not addr) return allocate(new_bytes, alignment);
+    std::lock_guard<std::mutex> lock(mutex);
+    addr = do_reallocate(addr, old_bytes, new_bytes, alignment, copied_bytes);
+    ++stats.reallocations;
+    stats.allocated_bytes = stats.allocated_bytes - old_bytes + new_bytes;
+    stats.peak_bytes = std::max(stats.peak_bytes, stats.allocated_bytes);
+    return addr;
+}
+
+void Allocator::deallocate(void *addr, std::size_t bytes, std::size_t alignment) {
+    if (not addr) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    do_deallocate(addr, bytes, alignment);
+    ++stats.deallocations;
+    stats.allocated_bytes -= bytes;
+}
+
+AllocatorStatistics Allocator::statistics() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+void *Allocator::do_reallocate(void *addr, std::size_t old_bytes, std::size_t new_bytes, std::size_t alignment,
+                               std::size_t *copied_bytes) {
+    void *new_addr = do_allocate(new_bytes, alignment);
+    memcpy(new_addr, addr, std::min(old_bytes, new_bytes));
+    do_deallocate(addr, old_bytes, alignment);
+    if (copied_bytes) *copied_bytes += std::min(old_bytes, new_bytes);
+    return new_addr;
+}
+
+
+/*======================================================================================================================
+ * SystemAllocator
+ *====================================================================================================================*/
+
+AllocationOptions SystemAllocator::options(std::size_t alignment) const {
+    AllocationOptions options;
+    options.backend = backend;
+    options.huge_pages = huge_pages;
+    options.alignment = alignment;
+    return options;
+}
+
+/** Returns the bytes the backend takes from the system for `bytes` aligned to `alignment`. */
+std::size_t SystemAllocator::reserved(std::size_t bytes, std::size_t alignment) const {
+    return backend == Backend::Mmap ? round_up(bytes, page_size()) : malloc_bytes(bytes, alignment);
+}
+
+void *SystemAllocator::do_allocate(std::size_t bytes, std::size_t alignment) {
+    void *addr = memory::allocate(options(alignment), bytes);
+    stats.reserved_bytes += reserved(bytes, alignment);
+    return addr;
+}
+
+void *SystemAllocator::do_reallocate(void *addr, std::size_t old_bytes, std::size_t new_bytes, std::size_t alignment,
+                                     std::size_t *copied_bytes) {
+    addr = memory::reallocate(options(alignment), addr, old_bytes, new_bytes, copied_bytes);
+    stats.reserved_bytes = stats.reserved_bytes - reserved(old_bytes, alignment) + reserved(new_bytes, alignment);
+    return addr;
+}
+
+void SystemAllocator::do_deallocate(void *addr, std::size_t bytes, std::size_t alignment) {
+    memory::deallocate(options(alignment), addr, bytes);
+    stats.reserved_bytes -= reserved(bytes, alignment);
+}
+
+
+/*======================================================================================================================
+ * ArenaAllocator
+ *====================================================================================================================*/
+
+ArenaAllocator::ArenaAllocator(std::size_t chunk_bytes)
+    : chunk_bytes(round_up(std::max<std::size_t>(chunk_bytes, 1), page_size()))
+{ }
+
+ArenaAllocator::~ArenaAllocator() {
+    for (const auto &c : chunks) unmap(c);
+    for (const auto &c : large) unmap(c);
+}
+
+/** Returns true iff an allocation of `bytes` aligned to `alignment` gets a mapping of its own. */
+bool ArenaAllocator::is_large(std::size_t bytes, std::size_t alignment) const {
+    return bytes > chunk_bytes / 2 or alignment > page_size();
+}
+
+/** Maps a chunk of at least `bytes` from the system. */
+ArenaAllocator::Chunk ArenaAllocator::map(std::size_t bytes) {
+    bytes = round_up(bytes, page_size());
+    Chunk chunk{ static_cast<uint8_t *>(memory::allocate(mmap_options(), bytes)), bytes };
+    stats.reserved_bytes += bytes;
+    return chunk;
+}
+
+void ArenaAllocator::unmap(const Chunk &chunk) {
+    memory::deallocate(mmap_options(), chunk.address, chunk.bytes);
+    stats.reserved_bytes -= chunk.bytes;
+}
+
+/** Returns the mapping of the large allocation at `addr`, or `large.end()` if it was bumped from a chunk. */
+std::vector<ArenaAllocator::Chunk>::iterator ArenaAllocator::find_large(const void *addr) {
+    return std::find_if(large.begin(), large.end(), [addr](const Chunk &c) {
+        return c.address <= addr and addr < c.address + c.bytes;
+    });
+}
+
+void ArenaAllocator::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto &c : large) unmap(c);
+    large.clear();
+    if (not chunks.empty()) {
+        std::for_each(chunks.begin() + 1, chunks.end(), [this](const Chunk &c) { unmap(c); });
+        chunks.resize(1);
+    }
+    used = 0;
+    last = nullptr;
+    stats.allocated_bytes = 0;
+}
+
+void *ArenaAllocator::do_allocate(std::size_t bytes, std::size_t alignment) {
+    // Large allocations would waste much of a chunk, map them on their own
+    if (is_large(bytes, alignment)) {
+        const auto chunk = map(bytes + (alignment > page_size() ? alignment : 0));
+        large.push_back(chunk);
+        return align(chunk.address, alignment);
+    }
+
+    // Bump through the current chunk, or start a new one, leaving the rest of the current one unused
+    if (not chunks.empty()) {
+        const Chunk &current = chunks.back();
+        uint8_t *addr = align(current.address + used, alignment);
+        if (addr + bytes <= current.address + current.bytes) {
+            used = addr + bytes - current.address;
+            return last = addr;
+        }
+    }
+    chunks.push_back(map(chunk_bytes));
+    uint8_t *addr = align(chunks.back().address, alignment);
+    used = addr + bytes - chunks.back().address;
+    return last = addr;
+}
+
+void *ArenaAllocator::do_reallocate(void *addr, std::size_t old_bytes, std::size_t new_bytes, std::size_t alignment,
+                                    std::size_t *copied_bytes) {
+    // The last allocation grows and shrinks in place while it fits into the current chunk
+    if (addr == last and not is_large(new_bytes, alignment)) {
+        const Chunk &current = chunks.back();
+        if (last + new_bytes <= current.address + current.bytes) {
+            used = last + new_bytes - current.address;
+            return addr;
+        }
+    }
+
+    // A page-aligned large allocation is remapped, on Linux the kernel moves the page table entries instead of the
+    // contents
+    if (is_large(new_bytes, alignment) and alignment <= page_size()) {
+        auto it = find_large(addr);
+        if (it != large.end() and it->address == addr) {
+            const std::size_t bytes = round_up(new_bytes, page_size());
+            it->address = static_cast<uint8_t *>(
+                memory::reallocate(mmap_options(), it->address, it->bytes, bytes, copied_bytes));
+            stats.reserved_bytes = stats.reserved_bytes - it->bytes + bytes;
+            it->bytes = bytes;
+            return it->address;
+        }
+    }
+
+    return Allocator::do_reallocate(addr, old_bytes, new_bytes, alignment, copied_bytes);
+}
+
+void ArenaAllocator::do_deallocate(void *addr, std::size_t, std::size_t) {
+    auto it = find_large(addr);
+    if (it != large.end()) {
+        unmap(*it);
+        large.erase(it);
+        return;
+    }
+
+    // Only the last allocation can be taken back, everything else waits for the arena to be dropped
+    if (addr == last) {
+        used = last - chunks.back().address;
+        last = nullptr;
+    }
+}
+
+
+/*======================================================================================================================
+ * PoolAllocator
+ *====================================================================================================================*/
+
+PoolAllocator::PoolAllocator(std::size_t max_class_bytes, std::size_t slab_bytes)
+    : max_class_bytes(next_power_of_two(std::max(max_class_bytes, MIN_CLASS_BYTES)))
+    , slab_bytes(round_up(std::max(slab_bytes, this->max_class_bytes), page_size()))
+    , free_lists(class_index(this->max_class_bytes) + 1, nullptr)
+{ }
+
+PoolAllocator::~PoolAllocator() {
+    for (const auto &slab : slabs) memory::deallocate(mmap_options(), const_cast<uint8_t *>(slab.first), slab_bytes);
+}
+
+std::size_t PoolAllocator::size_class(std::size_t bytes, std::size_t alignment) {
+    return next_power_of_two(std::max({ bytes, alignment, MIN_CLASS_BYTES }));
+}
+
+std::size_t PoolAllocator::class_index(std::size_t class_bytes) {
+    return __builtin_ctzl(class_bytes) - __builtin_ctzl(MIN_CLASS_BYTES);
+}
+
+/** Returns true iff an allocation of `bytes` aligned to `alignment` comes from a slab.  Blocks of a class lie at
+ * multiples of the class inside page-aligned slabs, so they are aligned to a page at most. */
+bool PoolAllocator::pooled(std::size_t bytes, std::size_t alignment) const {
+    return size_class(bytes, alignment) <= max_class_bytes and alignment <= page_size();
+}
+
+/** Returns the class of the block at `addr`, or 0 if it does not lie in a slab.  The class is looked up rather than
+ * computed from the size, so that memory may be freed with a larger alignment than it was allocated with. */
+std::size_t PoolAllocator::class_of(const void *addr) const {
+    auto it = slabs.upper_bound(static_cast<const uint8_t *>(addr));
+    if (it == slabs.begin()) return 0;
+    --it;
+    return addr < it->first + slab_bytes ? it->second : 0;
+}
+
+void *PoolAllocator::do_allocate(std::size_t bytes, std::size_t alignment) {
+    if (not pooled(bytes, alignment)) {
+        void *addr = memory::allocate(malloc_options(alignment), bytes);
+        stats.reserved_bytes += malloc_bytes(bytes, alignment);
+        return addr;
+    }
+
+    const std::size_t class_bytes = size_class(bytes, alignment);
+    auto &head = free_lists[class_index(class_bytes)];
+    if (not head) {
+        // Carve a new slab into blocks of the class, linked in address order
+        auto slab = static_cast<uint8_t *>(memory::allocate(mmap_options(), slab_bytes));
+        slabs.emplace(slab, class_bytes);
+        stats.reserved_bytes += slab_bytes;
+        for (std::size_t offset = slab_bytes; offset >= class_bytes; offset -= class_bytes) {
+            auto block = reinterpret_cast<FreeBlock *>(slab + offset - class_bytes);
+            block->next = head;
+            head = block;
+        }
+    }
+    FreeBlock *block = head;
+    head = block->next;
+    return block;
+}
+
+void *PoolAllocator::do_reallocate(void *addr, std::size_t old_bytes, std::size_t new_bytes, std::size_t alignment,
+                                   std::size_t *copied_bytes) {
+    // The block of the class has room for the new size already
+    const std::size_t old_class = class_of(addr);
+    if (old_class and pooled(new_bytes, alignment) and old_class == size_class(new_bytes, alignment))
+        return addr;
+    if (not old_class and not pooled(new_bytes, alignment)) {
+        addr = memory::reallocate(malloc_options(alignment), addr, old_bytes, new_bytes, copied_bytes);
+        stats.reserved_bytes = stats.reserved_bytes - malloc_bytes(old_bytes, alignment) +
+                               malloc_bytes(new_bytes, alignment);
+        return addr;
+    }
+    return Allocator::do_reallocate(addr, old_bytes, new_bytes, alignment, copied_bytes);
+}
+
+void PoolAllocator::do_deallocate(void *addr, std::size_t bytes, std::size_t alignment) {
+    const std::size_t class_bytes = class_of(addr);
+    if (not class_bytes) {
+        memory::deallocate(malloc_options(alignment), addr, bytes);
+        stats.reserved_bytes -= malloc_bytes(bytes, alignment);
+        return;
+    }
+
+    auto &head = free_lists[class_index(class_bytes)];
+    auto block = static_cast<FreeBlock *>(addr);
+    block->next = head;
+    head = block;
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "Memory.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+
+namespace memory {
+
+/** What an `Allocator` has handed out and what it holds from the system for that. */
+struct AllocatorStatistics
+{
+    /** Bytes handed out and not freed yet, and the most that ever were at once. */
+    std::size_t allocated_bytes = 0;
+    std::size_t peak_bytes = 0;
+    /** Bytes the allocator holds from the system, to hand out or handed out already. */
+    std::size_t reserved_bytes = 0;
+    /** Number of calls to allocate, reallocate and free memory. */
+    std::size_t allocations = 0;
+    std::size_t reallocations = 0;
+    std::size_t deallocations = 0;
+
+    /** Returns the fraction of the reserved bytes not handed out: padding, rounding, freed but not reused memory. */
+    double fragmentation() const { return reserved_bytes ? 1 - double(allocated_bytes) / reserved_bytes : 0; }
+
+    /** Prints the statistics for humans, in one line. */
+    void print(std::ostream &out) const;
+};
+
+/** Where the buffers of a store or the nodes of a tree come from, with statistics of its use.  Set it as
+ * `AllocationOptions::allocator` of a store or pass it to `BPlusTree::Bulkload()`; several stores and trees may share
+ * one allocator.  All methods are safe to call from several threads at once. */
+struct Allocator
+{
+    virtual ~Allocator() = default;
+
+    /** Allocates `bytes` aligned to `alignment`, a power of two.  Throws `std::bad_alloc` on failure. */
+    void *allocate(std::size_t bytes, std::size_t alignment);
+    /** Resizes the memory at `addr` of `old_bytes` to `new_bytes`, possibly moving it, and returns its new address.
+     * Adds the number of bytes copied to move the memory to `*copied_bytes`, if given. */
+    void *reallocate(void *addr, std::size_t old_bytes, std::size_t new_bytes, std::size_t alignment,
+                     std::size_t *copied_bytes = nullptr);
+    /** Frees the memory at `addr` of `bytes`, allocated with `alignment`. */
+    void deallocate(void *addr, std::size_t bytes, std::size_t alignment);
+
+    /** Returns true iff the memory need not be freed piece by piece, because destroying the allocator frees all of
+     * it at once. */
+    virtual bool frees_in_bulk() const { return false; }
+
+    /** Returns the statistics so far. */
+    AllocatorStatistics statistics() const;
+
+    protected:
+    /* The allocation strategy, called with `mutex` held.  `do_reallocate()` allocates, copies and frees by default. */
+    virtual void *do_allocate(std::size_t bytes, std::size_t alignment) = 0;
+    virtual void *do_reallocate(void *addr, std::size_t old_bytes, std::size_t new_bytes, std::size_t alignment,
+                                std::size_t *copied_bytes);
+    virtual void do_deallocate(void *addr, std::size_t bytes, std::size_t alignment) = 0;
+
+    mutable std::mutex mutex;
+    /** Kept up to date by the strategies for `reserved_bytes`, and by `Allocator` for the rest. */
+    AllocatorStatistics stats;
+};
+
+/** Allocates every buffer on its own from the system, through one of the allocation backends. */
+struct SystemAllocator : Allocator
+{
+    SystemAllocator(Backend backend = Backend::Malloc, bool huge_pages = false)
+        : backend(backend), huge_pages(huge_pages)
+    { }
+
+    private:
+    Backend backend;
+    bool huge_pages;
+
+    AllocationOptions options(std::size_t alignment) const;
+    std::size_t reserved(std::size_t bytes, std::size_t alignment) const;
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void *do_reallocate(void *addr, std::size_t old_bytes, std::size_t new_bytes, std::size_t alignment,
+                        std::size_t *copied_bytes) override;
+    void do_deallocate(void *addr, std::size_t bytes, std::size_t alignment) override;
+};
+
+/** Hands out memory by bumping a pointer through chunks mapped from the system.  Allocations larger than half a chunk,
+ * or aligned beyond a page, get a mapping of their own, which grows like `Backend::Mmap` and is unmapped when freed.
+ * Freeing other memory only takes it back if it was the last allocation; everything else stays reserved until the
+ * arena is reset or destroyed, which unmaps all chunks at once, regardless of how many allocations they hold. */
+struct ArenaAllocator : Allocator
+{
+    /** Allocates chunks of `chunk_bytes`, rounded up to whole pages, or larger for larger allocations. */
+    explicit ArenaAllocator(std::size_t chunk_bytes = 1UL << 20);
+    ~ArenaAllocator();
+    ArenaAllocator(const ArenaAllocator&) = delete;
+    ArenaAllocator &operator=(const ArenaAllocator&) = delete;
+
+    bool frees_in_bulk() const override { return true; }
+
+    /** Frees all memory handed out at once, keeping the first chunk to allocate from again.  No memory of the arena
+     * may be used or freed anymore. */
+    void reset();
+
+    private:
+    struct Chunk
+    {
+        uint8_t *address;
+        std::size_t bytes;
+    };
+
+    std::size_t chunk_bytes;
+    // Chunks to bump through, the last one is current, and mappings of single large allocations
+    std::vector<Chunk> chunks;
+    std::vector<Chunk> large;
+    // Bytes used of the current chunk, and where the last allocation from it starts
+    std::size_t used = 0;
+    uint8_t *last = nullptr;
+
+    bool is_large(std::size_t bytes, std::size_t alignment) const;
+    Chunk map(std::size_t bytes);
+    void unmap(const Chunk &chunk);
+    std::vector<Chunk>::iterator find_large(const void *addr);
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void *do_reallocate(void *addr, std::size_t old_bytes, std::size_t new_bytes, std::size_t alignment,
+                        std::size_t *copied_bytes) override;
+    void do_deallocate(void *addr, std::size_t bytes, std::size_t alignment) override;
+};
+
+/** Rounds every allocation up to a size class, a power of two, and keeps a free list per class, carved from slabs
+ * mapped from the system.  Freed memory is reused by the next allocation of its class, and resizing within a class
+ * never moves.  Slabs are only unmapped when the pool is destroyed.  Allocations beyond the largest class come from
+ * `malloc()` on their own and must be freed before the pool is destroyed. */
+struct PoolAllocator : Allocator
+{
+    static constexpr std::size_t MIN_CLASS_BYTES = 16;
+
+    /** Pools allocations of up to `max_class_bytes`, a power of two, in slabs of `slab_bytes`. */
+    explicit PoolAllocator(std::size_t max_class_bytes = 1UL << 16, std::size_t slab_bytes = 1UL << 20);
+    ~PoolAllocator();
+    PoolAllocator(const PoolAllocator&) = delete;
+    PoolAllocator &operator=(const PoolAllocator&) = delete;
+
+    /** Returns the size class of an allocation of `bytes` aligned to `alignment`. */
+    static std::size_t size_class(std::size_t bytes, std::size_t alignment);
+
+    private:
+    struct FreeBlock
+    {
+        FreeBlock *next;
+    };
+
+    std::size_t max_class_bytes;
+    std::size_t slab_bytes;
+    // Head of the free list of each class, indexed by log2 of the class over `MIN_CLASS_BYTES`
+    std::vector<FreeBlock*> free_lists;
+    // Class of the blocks of every slab, by the address of the slab
+    std::map<const uint8_t*, std::size_t> slabs;
+
+    bool pooled(std::size_t bytes, std::size_t alignment) const;
+    std::size_t class_of(const void *addr) const;
+    static std::size_t class_index(std::size_t class_bytes);
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void *do_reallocate(void *addr, std::size_t old_bytes, std::size_t new_bytes, std::size_t alignment,
+                        std::size_t *copied_bytes) override;
+    void do_deallocate(void *addr, std::size_t bytes, std::size_t alignment) override;
+};
+
+}
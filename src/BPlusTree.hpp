@@ -1,12 +1,17 @@
 #pragma once
 
+#include "Allocator.hpp"
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
 #include <utility>
 #include <cmath>
 #include <optional>
+#include <vector>
 
 
 template<
@@ -51,6 +56,30 @@ private:
     size_type numLeaves;
     leaf_node *bottom_left_leaf;
     leaf_node *bottom_right_leaf;
+    /* Allocator of the nodes, `nullptr` to allocate them with `new`. */
+    std::shared_ptr<memory::Allocator> allocator;
+
+    /** Creates a node, from `allocator` if given.  Nodes from an allocator are aligned to a cache line, so that a node
+     * sized to fit one never straddles two. */
+    template<typename Node>
+    static Node *make_node(memory::Allocator *allocator) {
+        if (not allocator) return new Node();
+        return new (allocator->allocate(sizeof(Node), node_alignment<Node>())) Node();
+    }
+
+    /** Destroys a node created by `make_node()` with the same `allocator`. */
+    template<typename Node>
+    static void destroy_node(memory::Allocator *allocator, Node *node) {
+        if (not allocator) {
+            delete node;
+            return;
+        }
+        node->~Node();
+        allocator->deallocate(node, sizeof(Node), node_alignment<Node>());
+    }
+
+    template<typename Node>
+    static constexpr std::size_t node_alignment() { return sizeof(Node) <= 64 ? 64 : alignof(Node); }
 
     /*--- Iterator ---------------------------------------------------------------------------------------------------*/
 private:
@@ -209,7 +238,7 @@ private:
     struct tree_node {
         virtual ~tree_node() = default;;
 
-        virtual void cleanUP() = 0;
+        virtual void cleanUP(memory::Allocator *allocator) = 0;
 
         virtual bool isLeaf() = 0;
 
@@ -376,15 +405,15 @@ public:
             return this->current_capacity >= ceil(computed_capacity * 1.0 / 2);
         }
 
-        void cleanUP() {
+        void cleanUP(memory::Allocator *allocator) {
             for (size_type i = 0; i < current_capacity; i++) {
                 if (children[i] != nullptr) {
-                    reinterpret_cast<tree_node *>(children[i])->cleanUP();
+                    reinterpret_cast<tree_node *>(children[i])->cleanUP(allocator);
 
                     if (reinterpret_cast<tree_node *>(children[i])->isLeaf()) {
-                        delete (reinterpret_cast<leaf_node *>(children[i]));
+                        destroy_node(allocator, reinterpret_cast<leaf_node *>(children[i]));
                     } else {
-                        delete (reinterpret_cast<inner_node *>(children[i]));
+                        destroy_node(allocator, reinterpret_cast<inner_node *>(children[i]));
                     }
                 }
             }
@@ -583,7 +612,7 @@ public:
             nextptr = _nextptr;
         }
 
-        void cleanUP() {
+        void cleanUP(memory::Allocator *) {
             //Nothing to do
         }
 
@@ -616,10 +645,12 @@ public:
 
     /*--- Factory methods --------------------------------------------------------------------------------------------*/
     template<typename It>
-    static BPlusTree Bulkload(It begin, It end) {
+    static BPlusTree Bulkload(It begin, It end, std::shared_ptr<memory::Allocator> allocator = nullptr) {
         /*
          * Bulkload the B+-tree with the values in the range [begin, end).  The iterators of type `It` are *random
          * access iterators*.  The elements being iterated are `std::pair<key_type, mapped_type>`.
+         * The nodes come from `allocator`, if given.  With an `ArenaAllocator`, the nodes of a level lie back to back
+         * in memory, and destroying the tree frees no node, the arena frees all of them at once when it is dropped.
          */
 
         /** create leaves first */
@@ -629,11 +660,11 @@ public:
         leaf_node *prev = nullptr;
 
         std::vector<inner_node *> outputNodes;
-        auto node = new inner_node();
+        auto node = make_node<inner_node>(allocator.get());
 
         // O(n)
         while (begin != end) {
-            leaf_node *newLeaf = new leaf_node();
+            leaf_node *newLeaf = make_node<leaf_node>(allocator.get());
             if (prev != nullptr) prev->setNextLeaf(newLeaf);
             prev = newLeaf;
 
@@ -661,13 +692,15 @@ public:
 
             if (node->full()) {
                 outputNodes.push_back(node);
-                node = new inner_node();
+                node = make_node<inner_node>(allocator.get());
             }
         }
 
         // Here we need to add the last node to the vector, but only if it was filled with at least one elem
         if (node->size() != 0)
             outputNodes.push_back(node);
+        else
+            destroy_node(allocator.get(), node);
 
         //O(1)
         /// restore BTree property (only needed for the last node of that row) //
@@ -690,7 +723,7 @@ public:
         while (!finished) {
             //Handle every node of this level
             for (size_type i = 0; i < inputNodes.size();) {
-                auto n = new inner_node();
+                auto n = make_node<inner_node>(allocator.get());
 
                 while (!n->full() && i < inputNodes.size())
                     n->insert(inputNodes[i++]);
@@ -717,15 +750,15 @@ public:
         }
 
         if (inputNodes.empty())
-            return BPlusTree();
+            return BPlusTree(std::move(allocator));
 
-        return BPlusTree(inputNodes.front(), leaves.size(), leaves.front(), leaves.back());
+        return BPlusTree(inputNodes.front(), leaves.size(), leaves.front(), leaves.back(), std::move(allocator));
     }
 
     template<typename Container>
-    static BPlusTree Bulkload(const Container &C) {
+    static BPlusTree Bulkload(const Container &C, std::shared_ptr<memory::Allocator> allocator = nullptr) {
         using std::begin, std::end;
-        return Bulkload(begin(C), end(C));
+        return Bulkload(begin(C), end(C), std::move(allocator));
     }
 
 
@@ -733,7 +766,10 @@ public:
 
 
 private:
-    BPlusTree(inner_node *rootNode, size_type _numLeaves, leaf_node *left, leaf_node *right) {
+    BPlusTree(inner_node *rootNode, size_type _numLeaves, leaf_node *left, leaf_node *right,
+              std::shared_ptr<memory::Allocator> allocator)
+        : allocator(std::move(allocator))
+    {
         root = rootNode;
         numLeaves = _numLeaves;
         bottom_left_leaf = left;
@@ -741,10 +777,10 @@ private:
     }
 
     /* Constructor for empty tree */
-    BPlusTree() {
-        root = new inner_node();
+    BPlusTree(std::shared_ptr<memory::Allocator> allocator) : allocator(std::move(allocator)) {
+        root = make_node<inner_node>(this->allocator.get());
         numLeaves = 0;
-        leaf_node *dummy = new leaf_node();
+        leaf_node *dummy = make_node<leaf_node>(this->allocator.get());
         bottom_right_leaf = dummy;
         bottom_left_leaf = dummy;
     }
@@ -752,16 +788,33 @@ private:
 public:
     BPlusTree(const BPlusTree &) = delete;
 
-    BPlusTree(BPlusTree &&) = default;
+    /* The moved-from tree gives up its nodes, so that only one tree destroys them. */
+    BPlusTree(BPlusTree &&other) noexcept
+        : root(std::exchange(other.root, nullptr))
+        , numLeaves(other.numLeaves)
+        , bottom_left_leaf(other.bottom_left_leaf)
+        , bottom_right_leaf(other.bottom_right_leaf)
+        , allocator(std::move(other.allocator))
+    { }
 
     ~BPlusTree() {
         /* TODO: 2.1.4.1 */
 
-        root->cleanUP();
+        if (root == nullptr)
+            return;
+
+        // Nodes of an arena go away with the arena, unless their entries need to be destroyed one by one
+        if (allocator and allocator->frees_in_bulk() and std::is_trivially_destructible_v<entry_type>)
+            return;
+
+        root->cleanUP(allocator.get());
         //if root was a pointer initialized with new, also delete
-        delete root;
+        destroy_node(allocator.get(), root);
     }
 
+    /** Returns the allocator of the nodes, or `nullptr` if they are allocated with `new`. */
+    const std::shared_ptr<memory::Allocator> &node_allocator() const { return allocator; }
+
     /** Returns the number of entries. */
     size_type size() const {
         size_type size = 0;
@@ -0,0 +1,106 @@
+#include "BitPacking.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+
+namespace {
+
+/** Unpacks `n` values of `W` bits from `words` and adds `reference`.  The width is a template parameter, so that each
+ * width gets a kernel with constant shifts and masks, which the compiler unrolls and vectorizes. */
+template<unsigned W>
+void unpack_kernel(const uint64_t *words, std::size_t n, int64_t reference, int64_t *out)
+{
+    if constexpr (W == 0) {
+        std::fill_n(out, n, reference);
+    } else {
+        constexpr uint64_t MASK = W == 64 ? ~uint64_t(0) : (uint64_t(1) << W) - 1;
+        for (std::size_t i = 0; i != n; ++i) {
+            const std::size_t bit = i * W;
+            const std::size_t word = bit / 64, shift = bit % 64;
+            uint64_t value = words[word] >> shift;
+            if (shift + W > 64) value |= words[word + 1] << (64 - shift);
+            out[i] = reference + int64_t(value & MASK);
+        }
+    }
+}
+
+using kernel_type = void(*)(const uint64_t*, std::size_t, int64_t, int64_t*);
+
+template<std::size_t... W>
+constexpr std::array<kernel_type, sizeof...(W)> make_kernels(std::index_sequence<W...>) {
+    return { &unpack_kernel<W>... };
+}
+
+/** Unpack kernels for 0 to 64 bits per value. */
+constexpr auto KERNELS = make_kernels(std::make_index_sequence<65>());
+
+/** Returns the number of words holding `n` values of `bits` bits. */
+constexpr std::size_t num_words(std::size_t n, unsigned bits) { return (n * bits + 63) / 64; }
+
+}
+
+void PackedColumn::append_block(const int64_t *values, const bool *is_null) {
+    // Find the frame of reference, NULLs do not widen it
+    int64_t min = std::numeric_limits<int64_t>::max(), max = std::numeric_limits<int64_t>::min();
+    for (std::size_t i = 0; i != BLOCK_ROWS; ++i) {
+        if (is_null and is_null[i]) continue;
+        min = std::min(min, values[i]);
+        max = std::max(max, values[i]);
+    }
+    if (min > max) min = max = 0; // all NULL
+
+    const uint64_t range = uint64_t(max) - uint64_t(min);
+    const unsigned bits = range == 0 ? 0 : 64 - __builtin_clzll(range);
+
+    Block block{ min, bits, bits >= 8 * value_bytes, words.size() };
+    if (block.plain) {
+        // Packing does not pay off, keep the plain values
+        block.bits = 0;
+        words.resize(words.size() + (BLOCK_ROWS * value_bytes + 7) / 8, 0);
+        auto dst = reinterpret_cast<uint8_t *>(words.data() + block.offset);
+        for (std::size_t i = 0; i != BLOCK_ROWS; ++i)
+            memcpy(dst + i * value_bytes, &values[i], value_bytes); // little endian, the low bytes hold the value
+    } else {
+        words.resize(words.size() + num_words(BLOCK_ROWS, bits), 0);
+        auto dst = words.data() + block.offset;
+        for (std::size_t i = 0; bits != 0 and i != BLOCK_ROWS; ++i) {
+            const uint64_t delta = is_null and is_null[i] ? 0 : uint64_t(values[i]) - uint64_t(min);
+            const std::size_t bit = i * bits;
+            dst[bit / 64] |= delta << (bit % 64);
+            if (bit % 64 + bits > 64) dst[bit / 64 + 1] |= delta >> (64 - bit % 64);
+        }
+    }
+    blocks.push_back(block);
+}
+
+void PackedColumn::unpack(std::size_t block, int64_t *out) const {
+    const auto &b = blocks[block];
+    if (not b.plain) {
+        KERNELS[b.bits](words.data() + b.offset, BLOCK_ROWS, b.reference, out);
+        return;
+    }
+
+    // Sign-extend the plain values
+    auto src = reinterpret_cast<const uint8_t *>(words.data() + b.offset);
+    const unsigned shift = 64 - 8 * value_bytes;
+    for (std::size_t i = 0; i != BLOCK_ROWS; ++i) {
+        uint64_t value = 0;
+        memcpy(&value, src + i * value_bytes, value_bytes);
+        out[i] = int64_t(value << shift) >> shift;
+    }
+}
+
+/** Drops the words of blocks no longer encoded. */
+void PackedColumn::shrink_words() {
+    if (blocks.empty()) {
+        words.clear();
+        return;
+    }
+    const auto &last = blocks.back();
+    const std::size_t end = last.offset + (last.plain ? (BLOCK_ROWS * value_bytes + 7) / 8
+                                                     : num_words(BLOCK_ROWS, last.bits));
+    words.resize(end);
+}
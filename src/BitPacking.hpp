@@ -0,0 +1,54 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+/** A frame-of-reference encoded integer column.  Rows are encoded in blocks of `BLOCK_ROWS`.  A block stores its
+ * minimum as reference and every value as its difference to the reference, bit-packed with as few bits as the largest
+ * difference needs.  A block whose differences need as many bits as the plain values is stored plain instead. */
+struct PackedColumn
+{
+    static constexpr std::size_t BLOCK_ROWS = 1024;
+
+    private:
+    struct Block
+    {
+        int64_t reference;
+        // Bits per packed value, or 0 and `plain` if the block is stored plain
+        unsigned bits;
+        bool plain;
+        // Index of the first word of the block in `words`
+        std::size_t offset;
+    };
+
+    // Width of the plain values in bytes
+    std::size_t value_bytes;
+    std::vector<Block> blocks;
+    std::vector<uint64_t> words;
+
+    public:
+    explicit PackedColumn(std::size_t value_bytes) : value_bytes(value_bytes) {}
+
+    /** Returns the number of encoded rows, always a multiple of `BLOCK_ROWS`. */
+    std::size_t size() const { return blocks.size() * BLOCK_ROWS; }
+    std::size_t num_blocks() const { return blocks.size(); }
+    /** Returns the bits per value of block `block`, or the bits of a plain value if the block is stored plain. */
+    unsigned bits(std::size_t block) const { return blocks[block].plain ? 8 * value_bytes : blocks[block].bits; }
+    /** Returns the bytes taken by the encoded blocks. */
+    std::size_t bytes() const { return words.size() * sizeof(uint64_t) + blocks.size() * sizeof(Block); }
+
+    /** Encodes the next block from the `BLOCK_ROWS` values at `values`.  Rows with `is_null[i]` set are encoded as
+     * the reference, `is_null` may be `nullptr` if no row is NULL. */
+    void append_block(const int64_t *values, const bool *is_null);
+    /** Forgets all blocks that contain row `n` or later rows. */
+    void truncate(std::size_t n) { blocks.resize(std::min(blocks.size(), n / BLOCK_ROWS)); shrink_words(); }
+
+    /** Decodes the `BLOCK_ROWS` values of block `block` to `out`. */
+    void unpack(std::size_t block, int64_t *out) const;
+
+    private:
+    void shrink_words();
+};
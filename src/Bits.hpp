@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+
+/* Helpers to access memory at the granularity of bits.  Bit `i` is bit `i % 8` of byte `i / 8`, as in the null bitmaps
+ * of mutable. */
+
+/** The location of a value that need not start at a byte boundary, e.g. a BOOL or a bit of a null bitmap: bit `bit`
+ * counted from `base`. */
+struct BitAddress
+{
+    uint8_t *base;
+    std::size_t bit;
+};
+
+/** Returns bit `bit` counted from `base`. */
+inline bool get_bit(const void *base, std::size_t bit) {
+    return (reinterpret_cast<const uint8_t *>(base)[bit / 8] >> (bit % 8)) & 1u;
+}
+
+/** Sets bit `bit` counted from `base` to `value`. */
+inline void set_bit(void *base, std::size_t bit, bool value) {
+    auto &byte = reinterpret_cast<uint8_t *>(base)[bit / 8];
+    byte = (byte & ~(1u << (bit % 8))) | (uint8_t(value) << (bit % 8));
+}
+
+/** Copies `bits` bits from bit `src_bit` of `src` to bit `dst_bit` of `dst`.  The ranges must not overlap. */
+inline void copy_bits(void *dst, std::size_t dst_bit, const void *src, std::size_t src_bit, std::size_t bits) {
+    if (dst_bit % 8 == 0 and src_bit % 8 == 0 and bits % 8 == 0) {
+        // Whole bytes, e.g. any attribute but a BOOL
+        memcpy(reinterpret_cast<uint8_t *>(dst) + dst_bit / 8, reinterpret_cast<const uint8_t *>(src) + src_bit / 8,
+               bits / 8);
+        return;
+    }
+    for (std::size_t i = 0; i != bits; ++i)
+        set_bit(dst, dst_bit + i, get_bit(src, src_bit + i));
+}
+
+/** Returns true iff any of the `bits` bits starting at bit `bit` of `base` is set. */
+inline bool any_bit(const void *base, std::size_t bit, std::size_t bits) {
+    for (std::size_t i = 0; i != bits; ++i)
+        if (get_bit(base, bit + i)) return true;
+    return false;
+}
+
+/** Loads the signed little endian integer of `bytes` bytes at `src` and widens it to 64 bits. */
+inline int64_t load_integer(const void *src, std::size_t bytes) {
+    uint64_t value = 0;
+    memcpy(&value, src, bytes);
+    const unsigned shift = 64 - 8 * bytes;
+    return int64_t(value << shift) >> shift;
+}
@@ -0,0 +1,143 @@
+#include "CSV.hpp"
+#include <algorithm>
+
+#if defined(__AVX2__) or defined(__PCLMUL__)
+#include <immintrin.h>
+#endif
+
+
+namespace {
+
+/** Returns the mask of the bytes of a block that equal `c`. */
+#ifdef __AVX2__
+inline uint64_t equal_mask(__m256i lo, __m256i hi, char c) {
+    const __m256i v = _mm256_set1_epi8(c);
+    const uint32_t mask_lo = _mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, v));
+    const uint32_t mask_hi = _mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, v));
+    return uint64_t(mask_hi) << 32 | mask_lo;
+}
+#else
+inline uint64_t equal_mask(const char *block, char c) {
+    uint64_t mask = 0;
+    for (std::size_t i = 0; i != csv::BLOCK_BYTES; ++i)
+        mask |= uint64_t(block[i] == c) << i;
+    return mask;
+}
+#endif
+
+/** Returns the mask whose bit `i` is the parity of the bits 0 to `i` of `mask`: set from an opening quote up to the
+ * byte before the closing one. */
+inline uint64_t prefix_xor(uint64_t mask) {
+#ifdef __PCLMUL__
+    // Carry-less multiplication by all ones XORs every bit into all higher bits
+    const __m128i product = _mm_clmulepi64_si128(_mm_set_epi64x(0, mask), _mm_set1_epi8(-1), 0);
+    return _mm_cvtsi128_si64(product);
+#else
+    for (unsigned shift = 1; shift != 64; shift *= 2)
+        mask ^= mask << shift;
+    return mask;
+#endif
+}
+
+}
+
+csv::BlockMasks csv::classify(const char *block, ScanState &state) {
+#ifdef __AVX2__
+    const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block));
+    const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + 32));
+    const uint64_t backslashes = equal_mask(lo, hi, '\\');
+    const uint64_t quotes = equal_mask(lo, hi, '"');
+    const uint64_t commas = equal_mask(lo, hi, ',');
+    const uint64_t newlines = equal_mask(lo, hi, '\n');
+#else
+    const uint64_t backslashes = equal_mask(block, '\\');
+    const uint64_t quotes = equal_mask(block, '"');
+    const uint64_t commas = equal_mask(block, ',');
+    const uint64_t newlines = equal_mask(block, '\n');
+#endif
+
+    // Backslashes are rare, visit them in order: one that is not escaped itself escapes the next byte
+    uint64_t escaped = state.escaped;
+    state.escaped = false;
+    for (uint64_t b = backslashes & ~escaped; b; b &= b - 1) {
+        const unsigned i = __builtin_ctzll(b);
+        if (escaped >> i & 1) continue;
+        if (i == BLOCK_BYTES - 1)
+            state.escaped = true;
+        else
+            escaped |= uint64_t(1) << (i + 1);
+    }
+
+    const uint64_t inside = prefix_xor(quotes & ~escaped) ^ state.in_quotes;
+    state.in_quotes = uint64_t(int64_t(inside) >> 63); // all ones iff the last byte is inside quotes
+    const uint64_t outside = ~inside & ~escaped;
+    return { newlines & outside, (newlines | commas) & outside };
+}
+
+bool csv::is_escaped(const char *pos, const char *begin) {
+    std::size_t n = 0;
+    while (pos != begin and *--pos == '\\') ++n;
+    return n % 2;
+}
+
+std::size_t csv::count_quotes(const char *begin, const char *end, bool escaped) {
+    std::size_t n = 0;
+    for (const char *p = begin; p != end; ++p) {
+        if (escaped)
+            escaped = false;
+        else if (*p == '\\')
+            escaped = true;
+        else
+            n += *p == '"';
+    }
+    return n;
+}
+
+const char *csv::next_record(const char *pos, const char *begin, const char *end, bool in_quotes) {
+    if (pos == begin or (pos[-1] == '\n' and not in_quotes and not is_escaped(pos - 1, begin))) return pos;
+    for (bool escaped = is_escaped(pos, begin); pos != end; ++pos) {
+        if (escaped)
+            escaped = false;
+        else if (*pos == '\\')
+            escaped = true;
+        else if (*pos == '"')
+            in_quotes = not in_quotes;
+        else if (*pos == '\n' and not in_quotes)
+            return pos + 1;
+    }
+    return end;
+}
+
+std::size_t csv::count_records(const char *begin, const char *end) {
+    std::size_t n = 0;
+    for_each_record(begin, end, [&n](const char *, const char *) { ++n; });
+    return n;
+}
+
+void csv::split_fields(const char *begin, const char *end, std::vector<Field> &fields) {
+    fields.clear();
+    bool in_quotes = false;
+    const char *field = begin;
+    for (const char *p = begin; p != end; ++p) {
+        if (*p == '\\') {
+            if (++p == end) break;
+        } else if (*p == '"') {
+            in_quotes = not in_quotes;
+        } else if (*p == ',' and not in_quotes) {
+            fields.push_back(make_field(field, p));
+            field = p + 1;
+        }
+    }
+    fields.push_back(make_field(field, end));
+}
+
+std::string csv::unescape(const Field &field) {
+    std::string value;
+    value.reserve(field.end - field.begin);
+    for (const char *p = field.begin; p != field.end; ++p) {
+        // A backslash escapes the next character, a quote inside quotes is doubled
+        if ((*p == '\\' or (*p == '"' and field.quoted)) and p + 1 != field.end) ++p;
+        value.push_back(*p);
+    }
+    return value;
+}
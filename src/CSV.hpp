@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+
+/* Scanning of CSV data in memory.  Records end at a newline outside of quoted fields, an optional carriage return
+ * before it is dropped, and empty records are skipped.  Fields are separated by commas outside of quoted fields.  A
+ * quote inside a quoted field is written as two quotes or escaped with a backslash, and a backslash escapes any
+ * character, which then neither separates nor quotes.
+ *
+ * The data is classified 64 bytes at a time into bit masks of its newlines and commas outside of quotes, with AVX2
+ * and carry-less multiplication where available, so that scanning only visits the separators. */
+namespace csv {
+
+/** A field of a record.  A quoted field is given without its quotes. */
+struct Field
+{
+    const char *begin;
+    const char *end;
+    bool quoted;
+    /** The field contains escaped characters, use `unescape()` to get its value. */
+    bool escaped;
+
+    bool empty() const { return begin == end; }
+};
+
+/** Bytes classified at once by `classify()`. */
+constexpr std::size_t BLOCK_BYTES = 64;
+
+/** The separators of a block outside of quotes, bit `i` standing for byte `i`. */
+struct BlockMasks
+{
+    uint64_t newlines;
+    /** Newlines and commas. */
+    uint64_t separators;
+};
+
+/** What `classify()` carries from one block into the next. */
+struct ScanState
+{
+    /** All ones if the block starts inside quotes, zero otherwise. */
+    uint64_t in_quotes = 0;
+    /** The first byte of the block is escaped by a backslash at the end of the previous one. */
+    bool escaped = false;
+};
+
+/** Classifies the `BLOCK_BYTES` bytes at `block`, which start in `state`, and updates `state` to the end of the
+ * block. */
+BlockMasks classify(const char *block, ScanState &state);
+
+/** Calls `f(pos)` for every newline outside of quotes in [`begin`, `end`), and for every comma outside of quotes as
+ * well if `WITH_COMMAS`, in order.  `begin` must lie outside of quotes. */
+template<bool WITH_COMMAS, typename F>
+void for_each_separator(const char *begin, const char *end, F &&f) {
+    ScanState state;
+    auto visit = [&f](const char *block, BlockMasks masks) {
+        for (uint64_t m = WITH_COMMAS ? masks.separators : masks.newlines; m; m &= m - 1)
+            f(block + __builtin_ctzll(m));
+    };
+
+    const char *block = begin;
+    for (; std::size_t(end - block) >= BLOCK_BYTES; block += BLOCK_BYTES)
+        visit(block, classify(block, state));
+    if (block != end) {
+        // The tail is padded with zeros, which are no separators, instead of reading past `end`
+        char tail[BLOCK_BYTES] = {};
+        memcpy(tail, block, end - block);
+        visit(block, classify(tail, state));
+    }
+}
+
+/** Returns true iff the character at `pos` is escaped, i.e. preceded by an odd number of backslashes after `begin`. */
+bool is_escaped(const char *pos, const char *begin);
+
+/** Returns the number of quotes that are not escaped in [`begin`, `end`), whose first character is escaped if
+ * `escaped`.  Data starting outside of quotes is inside of quotes after an odd number of them. */
+std::size_t count_quotes(const char *begin, const char *end, bool escaped);
+
+/** Returns the start of the first record at or after `pos`, i.e. `pos` itself if it directly follows a newline outside
+ * of quotes.  `in_quotes` tells whether `pos` lies inside quotes, escaped characters from `begin` on are taken into
+ * account.  Returns `end` if no record starts before it. */
+const char *next_record(const char *pos, const char *begin, const char *end, bool in_quotes);
+
+/** Calls `f(record_begin, record_end)` for every non-empty record in [`begin`, `end`), which must start at a record. */
+template<typename F>
+void for_each_record(const char *begin, const char *end, F &&f) {
+    auto emit = [&f](const char *record, const char *record_end) {
+        if (record_end != record and record_end[-1] == '\r') --record_end;
+        if (record_end != record) f(record, record_end);
+    };
+
+    const char *record = begin;
+    for_each_separator<false>(begin, end, [&](const char *newline) {
+        emit(record, newline);
+        record = newline + 1;
+    });
+    if (record != end) emit(record, end);
+}
+
+/** Returns the field spanning [`begin`, `end`) between two separators. */
+inline Field make_field(const char *begin, const char *end) {
+    if (begin == end or *begin != '"') return { begin, end, false, memchr(begin, '\\', end - begin) != nullptr };
+    ++begin;
+    if (end != begin and end[-1] == '"') --end; // closing quote
+    const bool escaped = memchr(begin, '"', end - begin) or memchr(begin, '\\', end - begin);
+    return { begin, end, true, escaped };
+}
+
+/** Calls `f(fields)` with the fields of every non-empty record in [`begin`, `end`), which must start at a record.
+ * `fields` is reused for all records. */
+template<typename F>
+void for_each_split_record(const char *begin, const char *end, std::vector<Field> &fields, F &&f) {
+    const char *field = begin;
+    auto end_record = [&](const char *record_end) {
+        if (record_end != field and record_end[-1] == '\r') --record_end;
+        if (not fields.empty() or record_end != field) {
+            fields.push_back(make_field(field, record_end));
+            f(fields);
+        }
+        fields.clear();
+    };
+
+    fields.clear();
+    for_each_separator<true>(begin, end, [&](const char *separator) {
+        if (*separator == '\n')
+            end_record(separator);
+        else
+            fields.push_back(make_field(field, separator));
+        field = separator + 1;
+    });
+    if (field != end or not fields.empty()) end_record(end);
+}
+
+/** Returns the number of non-empty records in [`begin`, `end`), which must start at a record. */
+std::size_t count_records(const char *begin, const char *end);
+
+/** Splits the record [`begin`, `end`) into its fields, replacing the contents of `fields`.  Scans byte by byte, for
+ * single records like a header. */
+void split_fields(const char *begin, const char *end, std::vector<Field> &fields);
+
+/** Returns the value of a field that contains escaped characters. */
+std::string unescape(const Field &field);
+
+}
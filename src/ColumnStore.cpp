@@ -1,47 +1,291 @@
 #include "ColumnStore.hpp"
+#include "Bits.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
 
-ColumnStore::ColumnStore(const m::Table &table)
-        : Store(table) {
+
+namespace {
+
+/** Reads `n` signed integers of `value_bytes` each from `src` and widens them to 64 bits at `out`. */
+void read_integers(const char *src, std::size_t value_bytes, std::size_t n, int64_t *out)
+{
+    switch (value_bytes) {
+        case 1: for (std::size_t i = 0; i != n; ++i) out[i] = reinterpret_cast<const int8_t *>(src)[i]; break;
+        case 2: for (std::size_t i = 0; i != n; ++i) out[i] = reinterpret_cast<const int16_t *>(src)[i]; break;
+        case 4: for (std::size_t i = 0; i != n; ++i) out[i] = reinterpret_cast<const int32_t *>(src)[i]; break;
+        default: for (std::size_t i = 0; i != n; ++i) out[i] = reinterpret_cast<const int64_t *>(src)[i]; break;
+    }
+}
+
+}
+
+ColumnStore::ColumnStore(const m::Table &table, const Options &options)
+        : Store(table), options(options) {
 
     // Initial rows
     storable_in_buffer = 10;
+    this->options.allocation.alignment = std::max(options.allocation.alignment, ALIGNMENT);
+
+    if (options.segmented) {
+        // Start with one segment per column
+        this->options.segment_rows = memory::round_up(std::max<std::size_t>(options.segment_rows, 1),
+                                                      PackedColumn::BLOCK_ROWS);
+        num_segments = 1;
+        storable_in_buffer = this->options.segment_rows;
+    }
 
     /* 1.3.1: Allocate columns for the attributes. */
     for (const auto &i : table) {
         // Create a buffer for each column/attribute
         size_t rowSizeBytes = ceil((double) i.type->size() / 8);
-        auto buffer = malloc(rowSizeBytes * storable_in_buffer);
-        columnBuffers.push_back(buffer);
+        columnBuffers.push_back(allocate_column(rowSizeBytes));
     }
 
     /* 1.3.1: Allocate a column for the null bitmap. */
-    bitmap_buffer = malloc(ceil((double) this->table().size() / 8) *
-                           storable_in_buffer); //buffer for a bitmap for each tuple inserted with num of attributes bits each
+    if (options.null_bitmap)
+        bitmap_buffer = allocate_column(bitmap_bytes()); //buffer for a bitmap for each tuple inserted with num of attributes bits each
 
+    reset_auxiliary();
     createLin();
 }
 
 ColumnStore::~ColumnStore() {
     /* 1.3.1: Free allocated memory. */
-    for (const auto &i : columnBuffers)
-        free((void *) i);
-    free(bitmap_buffer);
+    release_buffers();
+    for (auto &free : unpublished) free();
+    delete version.load();
+}
+
+/** Frees all columns and the null bitmap, wherever they live. */
+void ColumnStore::release_buffers() {
+    if (mapping) {
+        release_mapping();
+        return;
+    }
+    auto buff_it = columnBuffers.cbegin();
+    for (const auto &i : table()) {
+        size_t rowSizeBytes = ceil((double) i.type->size() / 8);
+        release_column(*buff_it++, rowSizeBytes);
+    }
+    if (bitmap_buffer)
+        release_column(bitmap_buffer, bitmap_bytes());
+}
+
+/** Returns the distance between two segments of a column of `bytes_per_row`, whole pages so that every segment can be
+ * committed on its own, including the padding after the last row. */
+std::size_t ColumnStore::segment_stride_bytes(std::size_t bytes_per_row) const {
+    return memory::round_up(column_bytes(bytes_per_row, options.segment_rows), memory::page_size());
+}
+
+/** Returns the address space reserved for all segments of a column of `bytes_per_row`. */
+std::size_t ColumnStore::reserved_bytes(std::size_t bytes_per_row) const {
+    const auto stride = segment_stride_bytes(bytes_per_row);
+    return std::max(options.max_bytes / stride, std::size_t(1)) * stride;
+}
+
+/** Allocates a column of `bytes_per_row` for `storable_in_buffer` rows, in segmented mode for `num_segments`
+ * segments. */
+void *ColumnStore::allocate_column(std::size_t bytes_per_row) {
+    if (not options.segmented)
+        return memory::allocate(options.allocation, column_bytes(bytes_per_row, storable_in_buffer));
+
+    // Reserve the address space for all segments up front and commit only the segments in use
+    const auto reserved = reserved_bytes(bytes_per_row);
+    if (num_segments * segment_stride_bytes(bytes_per_row) > reserved) throw std::bad_alloc();
+    auto buffer = memory::reserve(reserved);
+    if (options.allocation.huge_pages) memory::use_huge_pages(buffer, reserved);
+    memory::commit(buffer, num_segments * segment_stride_bytes(bytes_per_row));
+    return buffer;
+}
+
+/** Frees a column of `bytes_per_row` allocated with `allocate_column()`, once no reader can scan it anymore. */
+void ColumnStore::release_column(void *buffer, std::size_t bytes_per_row) {
+    if (options.segmented) {
+        free_later([buffer, bytes = reserved_bytes(bytes_per_row)]() { memory::release(buffer, bytes); });
+    } else {
+        const auto bytes = column_bytes(bytes_per_row, storable_in_buffer);
+        free_later([allocation = options.allocation, buffer, bytes]() {
+            memory::deallocate(allocation, buffer, bytes);
+        });
+    }
+}
+
+/** Unmaps the snapshot the columns were restored from, once no reader can scan it anymore. */
+void ColumnStore::release_mapping() {
+    auto old = std::make_shared<snapshot::Mapping>();
+    std::swap(*old, mapping);
+    free_later([old]() { snapshot::unmap(*old); });
+}
+
+/** Calls `free` right away, or, if the store has concurrent readers, once the next version is published and no
+ * reader can scan the memory it frees anymore. */
+void ColumnStore::free_later(std::function<void()> free) {
+    if (options.concurrent_readers)
+        unpublished.push_back(std::move(free));
+    else
+        free();
+}
+
+/** Resizes the column at `buffer` from `old_bytes` to `new_bytes`.  With concurrent readers, the column is copied to a
+ * new buffer and the old one is freed once no reader can scan it anymore, instead of reallocating it in place. */
+void *ColumnStore::move_column(void *buffer, std::size_t old_bytes, std::size_t new_bytes) {
+    if (not options.concurrent_readers)
+        return memory::reallocate(options.allocation, buffer, old_bytes, new_bytes, &stats.copied_bytes);
+
+    auto moved = memory::allocate(options.allocation, new_bytes);
+    memcpy(moved, buffer, std::min(old_bytes, new_bytes));
+    stats.copied_bytes += std::min(old_bytes, new_bytes);
+    free_later([allocation = options.allocation, buffer, old_bytes]() {
+        memory::deallocate(allocation, buffer, old_bytes);
+    });
+    return moved;
+}
+
+/** Returns the address of row `row` in the column at `buffer` of `bytes_per_row`. */
+uint8_t *ColumnStore::address(void *buffer, std::size_t bytes_per_row, std::size_t row) const {
+    auto base = reinterpret_cast<uint8_t *>(buffer);
+    if (options.segmented)
+        return base + row / options.segment_rows * segment_stride_bytes(bytes_per_row) +
+               row % options.segment_rows * bytes_per_row;
+    return base + row * bytes_per_row;
+}
+
+/** Returns the address of the value of attribute `id` in row `row`. */
+uint8_t *ColumnStore::value_address(std::size_t id, std::size_t row) const {
+    return address(columnBuffers[id], (table()[id].type->size() + 7) / 8, row);
 }
 
 std::size_t ColumnStore::num_rows() const {
     /* 1.3.1: Implement */
-    return row_count;
+    // Writers appending concurrently publish their rows through the watermark only
+    return concurrent ? concurrent->watermark() : row_count;
 }
 
 void ColumnStore::append() {
     /* 1.3.1: Implement */
     // Increase used rows
     ++row_count;
+    // mutable has written the rows before the new one
+    committed.store(row_count - 1, std::memory_order_release);
+
+    // The previous rows are written now, summarize the block they completed
+    if (row_count % ZoneMap::BLOCK_ROWS == 1) summarize(row_count - 1);
 
     // Check if enough memory is pre allocated
     if (row_count < storable_in_buffer) return;
+    // Only commit the next segment, rows already stored and the linearization stay untouched
+    if (options.segmented) {
+        resize_segments(storable_in_buffer + options.segment_rows);
+        return;
+    }
     // If not allocate 1.5*old_size (aka Java ArrayList)
-    storable_in_buffer = storable_in_buffer + (storable_in_buffer >> 1u);
+    resize(storable_in_buffer + (storable_in_buffer >> 1u));
+}
+
+void ColumnStore::reserve(std::size_t n) {
+    // Growth happens as soon as the last row is in use, so keep one row more than requested
+    if (n < storable_in_buffer) return;
+    if (options.segmented)
+        resize_segments(n + 1);
+    else
+        resize(n + 1);
+}
+
+void ColumnStore::append(std::size_t n) {
+    commit_rows();
+    summarize(row_count);
+    reserve(row_count + n);
+    row_count += n;
+}
+
+/** Calls `f(buffer, bytes_per_row)` for every column and the null bitmap. */
+template<typename F>
+void ColumnStore::for_each_column(F &&f) const {
+    auto buff_it = columnBuffers.cbegin();
+    for (const auto &i : table()) {
+        size_t rowSizeBytes = ceil((double) i.type->size() / 8);
+        f(*buff_it++, rowSizeBytes);
+    }
+    if (bitmap_buffer) f(bitmap_buffer, bitmap_bytes());
+}
+
+void ColumnStore::begin_concurrent_appends() {
+    if (not options.segmented) throw std::logic_error("concurrent appends need a segmented ColumnStore");
+    if (concurrent) throw std::logic_error("concurrent appends have begun already");
+
+    // The rows so far are written, summarize them before writers append behind them
+    summarize(row_count);
+    std::size_t max_segments = std::numeric_limits<std::size_t>::max();
+    for_each_column([this, &max_segments](void *, std::size_t bytes_per_row) {
+        max_segments = std::min(max_segments, reserved_bytes(bytes_per_row) / segment_stride_bytes(bytes_per_row));
+    });
+    // Leave room for the spare row `append()` keeps after the last row
+    concurrent = std::make_unique<ConcurrentAppend>(row_count, max_segments * options.segment_rows - 1,
+                                                    num_segments);
+}
+
+std::size_t ColumnStore::claim_rows(std::size_t n) {
+    const auto first = concurrent->claim(n);
+    // Commit the segments of the claimed rows, unless another writer did so already
+    const auto segments = (first + n + options.segment_rows - 1) / options.segment_rows;
+    concurrent->commit_units(segments, [this](std::size_t segment) {
+        for_each_column([this, segment](void *buffer, std::size_t bytes_per_row) {
+            const auto stride = segment_stride_bytes(bytes_per_row);
+            memory::commit(reinterpret_cast<uint8_t *>(buffer) + segment * stride, stride);
+        });
+    });
+    return first;
+}
+
+void ColumnStore::publish_rows(std::size_t first, std::size_t n) {
+    concurrent->publish(first, n);
+}
+
+void ColumnStore::end_concurrent_appends() {
+    if (not concurrent) return;
+    if (concurrent->watermark() != concurrent->claimed_rows())
+        throw std::logic_error("not all claimed rows are published");
+
+    num_segments = concurrent->committed_units();
+    storable_in_buffer = num_segments * options.segment_rows;
+    row_count = concurrent->watermark();
+    concurrent.reset();
+    commit_rows();
+    // Commit the spare row after the last row, or decommit the segments writers committed beyond it
+    resize_segments(row_count + 1);
+    summarize(row_count);
+}
+
+/** Commits or decommits segments of all columns and the null bitmap until they hold at least `capacity` rows, and no
+ * segment beyond. */
+void ColumnStore::resize_segments(std::size_t capacity) {
+    while (storable_in_buffer < capacity) {
+        for_each_column([this](void *, std::size_t bytes_per_row) {
+            if ((num_segments + 1) * segment_stride_bytes(bytes_per_row) > reserved_bytes(bytes_per_row))
+                throw std::bad_alloc();
+        });
+        for_each_column([this](void *buffer, std::size_t bytes_per_row) {
+            const auto stride = segment_stride_bytes(bytes_per_row);
+            memory::commit(reinterpret_cast<uint8_t *>(buffer) + num_segments * stride, stride);
+        });
+        ++num_segments;
+        storable_in_buffer += options.segment_rows;
+    }
+    while (num_segments > 1 and storable_in_buffer - options.segment_rows >= capacity) {
+        --num_segments;
+        storable_in_buffer -= options.segment_rows;
+        for_each_column([this](void *buffer, std::size_t bytes_per_row) {
+            const auto stride = segment_stride_bytes(bytes_per_row);
+            memory::decommit(reinterpret_cast<uint8_t *>(buffer) + num_segments * stride, stride);
+        });
+    }
+}
+
+/** Grows or shrinks all columns and the null bitmap to hold `capacity` rows. */
+void ColumnStore::resize(std::size_t capacity) {
+    const auto old_size = storable_in_buffer;
+    storable_in_buffer = capacity;
 
     // Create iterator over old buffers (to reallocate)
     auto buff_it = columnBuffers.cbegin();
@@ -50,7 +294,16 @@ void ColumnStore::append() {
     for (const auto &i : table()) {
         // For each attribute realloc
         size_t rowSizeBytes = ceil((double) i.type->size() / 8);
-        auto buffer = realloc(*buff_it, rowSizeBytes * storable_in_buffer);
+        void *buffer;
+        if (mapping) {
+            // Columns restored from a snapshot live in the mapped file, move them to memory of our own
+            buffer = memory::allocate(options.allocation, column_bytes(rowSizeBytes, storable_in_buffer));
+            memcpy(buffer, *buff_it, rowSizeBytes * std::min(old_size, storable_in_buffer));
+            stats.copied_bytes += rowSizeBytes * std::min(old_size, storable_in_buffer);
+        } else {
+            buffer = move_column(*buff_it, column_bytes(rowSizeBytes, old_size),
+                                 column_bytes(rowSizeBytes, storable_in_buffer));
+        }
         newBuffers.push_back(buffer);
 
         ++buff_it;
@@ -60,31 +313,537 @@ void ColumnStore::append() {
     columnBuffers = newBuffers;
 
     /* 1.3.1: Allocate a column for the null bitmap. */
-    bitmap_buffer = realloc(bitmap_buffer, ceil((double) this->table().size() / 8) *
-                                           storable_in_buffer); //buffer for a bitmap for each tuple inserted with num of attributes bits each
+    if (bitmap_buffer and mapping) {
+        auto buffer = memory::allocate(options.allocation, column_bytes(bitmap_bytes(), storable_in_buffer));
+        memcpy(buffer, bitmap_buffer, bitmap_bytes() * std::min(old_size, storable_in_buffer));
+        bitmap_buffer = buffer;
+        stats.copied_bytes += bitmap_bytes() * std::min(old_size, storable_in_buffer);
+    } else if (bitmap_buffer) {
+        bitmap_buffer = move_column(bitmap_buffer, column_bytes(bitmap_bytes(), old_size),
+                                    column_bytes(bitmap_bytes(), storable_in_buffer)); //buffer for a bitmap for each tuple inserted with num of attributes bits each
+    }
+    if (mapping) release_mapping();
+    if (storable_in_buffer > old_size)
+        ++stats.grow_reallocations;
+    else
+        ++stats.shrink_reallocations;
 
     createLin();
 }
 
 void ColumnStore::drop() {
     /* 1.3.1: Implement */
-    //TODO decrease memory dynamically for all
     --row_count;
+    committed.store(std::min(committed.load(), row_count), std::memory_order_release);
+    dead_rows.forget(row_count);
+    transposed_rows = std::min(transposed_rows, row_count);
+    for (auto &n : null_columns)
+        if (n) n->truncate(row_count);
+    for (auto &d : dictionaries)
+        if (d) d->truncate(row_count);
+    for (auto &h : string_heaps)
+        if (h) h->truncate(row_count);
+    for (auto &p : packed)
+        if (p) p->truncate(row_count);
+    for (auto &z : zone_maps)
+        if (z) z->truncate(row_count);
+
+    // Keep one empty segment as spare, so alternating appends and drops at a segment boundary do not thrash
+    if (options.segmented) {
+        if (num_segments >= 3 and row_count <= (num_segments - 2) * options.segment_rows)
+            resize_segments(storable_in_buffer - options.segment_rows);
+        return;
+    }
+
+    // Shrink to half once only a third is used, so that alternating appends and drops do not thrash
+    if (storable_in_buffer > 10 and row_count < storable_in_buffer / 3)
+        resize(std::max<std::size_t>(10, storable_in_buffer / 2));
+}
+
+bool ColumnStore::erase(std::size_t row) {
+    if (row >= row_count or not dead_rows.mark(row)) return false;
+
+    // Compact a little at a time, so that no single erase pays for compacting the whole store
+    if (dead_rows.size() > options.compaction_threshold * row_count)
+        compact(options.compaction_step);
+    return true;
+}
+
+std::size_t ColumnStore::compact(std::size_t budget) {
+    return dead_rows.compact(row_count, budget, [this](std::size_t from, std::size_t to) {
+        for (const auto &i : table()) {
+            size_t rowSizeBytes = ceil((double) i.type->size() / 8);
+            memcpy(value_address(i.id, to), value_address(i.id, from), rowSizeBytes);
+        }
+        if (bitmap_buffer) {
+            memcpy(bitmap_address(to), bitmap_address(from), bitmap_bytes());
+            if (to < transposed_rows) transpose_row(to);
+        }
+        // Rows not encoded yet are encoded again from `to` on
+        for (auto &d : dictionaries) {
+            if (not d) continue;
+            if (from < d->size())
+                d->copy(from, to);
+            else
+                d->truncate(to);
+        }
+        for (auto &h : string_heaps) {
+            if (not h) continue;
+            if (from < h->size())
+                h->copy(from, to);
+            else
+                h->truncate(to);
+        }
+        for (auto &p : packed)
+            if (p) p->truncate(to);
+        for (auto &z : zone_maps)
+            if (z) z->truncate(to);
+    }, [this]() { drop(); });
+}
+
+/** Creates the empty dictionary encoded columns, string heaps, bit-packed columns and zone maps the options ask for. */
+void ColumnStore::reset_auxiliary() {
+    dictionaries.clear();
+    string_heaps.clear();
+    packed.clear();
+    zone_maps.clear();
+    null_columns.clear();
+    null_columns.resize(table().size());
+    transposed_rows = 0;
+    auto listed = [](const std::vector<std::string> &names, const char *name) {
+        return std::find(names.begin(), names.end(), name) != names.end();
+    };
+    for (const auto &i : table()) {
+        const bool encoded = listed(options.dictionary_attributes, i.name);
+        if (encoded and not i.type->is_character_sequence())
+            throw std::invalid_argument("only CHAR attributes can be dictionary encoded");
+        dictionaries.emplace_back(encoded ? std::make_unique<DictionaryColumn>(i.type->size() / 8) : nullptr);
+
+        const bool in_heap = listed(options.string_heap_attributes, i.name);
+        if (in_heap and not i.type->is_character_sequence())
+            throw std::invalid_argument("only CHAR attributes can be kept in a string heap");
+        if (in_heap and i.type->size() / 8 > StringColumn::MAX_BYTES)
+            throw std::invalid_argument("CHAR attribute too long for a string heap");
+        string_heaps.emplace_back(in_heap ? std::make_unique<StringColumn>(i.type->size() / 8) : nullptr);
+
+        const bool is_packed = listed(options.packed_attributes, i.name);
+        if (is_packed and not i.type->is_integral())
+            throw std::invalid_argument("only integer attributes can be bit-packed");
+        packed.emplace_back(is_packed ? std::make_unique<PackedColumn>(i.type->size() / 8) : nullptr);
+
+        const bool is_summarized = listed(options.zone_map_attributes, i.name);
+        if (is_summarized and not i.type->is_integral())
+            throw std::invalid_argument("only integer attributes can have a zone map");
+        zone_maps.emplace_back(is_summarized ? std::make_unique<ZoneMap>() : nullptr);
+    }
+}
+
+/** Transposes the row-major null bitmap of the first `written_rows` rows into the null bitmaps of the attributes. */
+void ColumnStore::transpose_nulls(std::size_t written_rows) {
+    if (not bitmap_buffer) {
+        transposed_rows = std::max(transposed_rows, written_rows);
+        return;
+    }
+    for (; transposed_rows < written_rows; ++transposed_rows)
+        transpose_row(transposed_rows);
+}
+
+/** Copies the null bits of row `row` from the row-major null bitmap into the null bitmaps of the attributes, creating
+ * the null bitmap of an attribute at its first NULL. */
+void ColumnStore::transpose_row(std::size_t row) {
+    auto bits = bitmap_address(row);
+    const bool has_null = any_bit(bits, 0, table().size());
+    for (std::size_t id = 0; id != null_columns.size(); ++id) {
+        const bool is_null = has_null and get_bit(bits, id);
+        auto &nulls = null_columns[id];
+        if (is_null and not nulls) nulls = std::make_unique<NullBitmap>();
+        if (nulls) nulls->set(row, is_null);
+    }
+}
+
+/** Summarizes the blocks completed by the first `written_rows` rows in the zone maps. */
+void ColumnStore::summarize(std::size_t written_rows) {
+    transpose_nulls(written_rows);
+    for (const auto &i : table()) {
+        auto &z = zone_maps[i.id];
+        if (not z) continue;
+
+        const std::size_t value_bytes = i.type->size() / 8;
+        while (z->size() + ZoneMap::BLOCK_ROWS <= written_rows) {
+            // A block never spans two segments
+            ZoneMap::Zone zone;
+            auto column = value_address(i.id, z->size());
+            for (std::size_t row = z->size(), end = row + ZoneMap::BLOCK_ROWS; row != end; ++row, column += value_bytes)
+                zone.add(load_integer(column, value_bytes), is_null(i.id, row));
+            z->append(zone);
+        }
+    }
+}
+
+Selection ColumnStore::select_range(std::size_t id, int64_t lo, int64_t hi, std::size_t *skipped_blocks) {
+    summarize(row_count);
+
+    const std::size_t value_bytes = table()[id].type->size() / 8;
+    const ZoneMap *z = zone_maps[id].get();
+
+    Selection selection;
+    for (std::size_t first = 0; first < row_count; first += ZoneMap::BLOCK_ROWS) {
+        const std::size_t block = first / ZoneMap::BLOCK_ROWS;
+        if (z and block < z->num_blocks() and not z->zone(block).overlaps(lo, hi)) {
+            if (skipped_blocks) ++*skipped_blocks;
+            continue;
+        }
+        for (std::size_t row = first, end = std::min(row_count, first + ZoneMap::BLOCK_ROWS); row != end; ++row) {
+            if (is_null(id, row)) continue;
+            const auto value = load_integer(value_address(id, row), value_bytes);
+            if (lo <= value and value <= hi) selection.push_back(row);
+        }
+    }
+    skip_dead(selection);
+    return selection;
+}
+
+void ColumnStore::encode() {
+    transpose_nulls(row_count);
+    for (const auto &i : table()) {
+        const std::size_t value_bytes = i.type->size() / 8;
+
+        if (auto &d = dictionaries[i.id]) {
+            for (std::size_t row = d->size(); row != row_count; ++row) {
+                d->append(is_null(i.id, row) ? nullptr : reinterpret_cast<const char *>(value_address(i.id, row)));
+            }
+        }
+
+        if (auto &h = string_heaps[i.id]) {
+            for (std::size_t row = h->size(); row != row_count; ++row)
+                h->append(is_null(i.id, row) ? nullptr : reinterpret_cast<const char *>(value_address(i.id, row)));
+        }
+
+        if (auto &p = packed[i.id]) {
+            int64_t values[PackedColumn::BLOCK_ROWS];
+            bool nulls[PackedColumn::BLOCK_ROWS];
+            while (p->size() + PackedColumn::BLOCK_ROWS <= row_count) {
+                const auto first = p->size();
+                read_integers(reinterpret_cast<const char *>(value_address(i.id, first)), value_bytes,
+                              PackedColumn::BLOCK_ROWS, values);
+                for (std::size_t row = 0; row != PackedColumn::BLOCK_ROWS; ++row)
+                    nulls[row] = is_null(i.id, first + row);
+                p->append_block(values, nulls);
+            }
+        }
+    }
+}
+
+void ColumnStore::scan(std::size_t id, const scan_consumer &consume) {
+    encode();
+
+    const std::size_t value_bytes = table()[id].type->size() / 8;
+    int64_t values[PackedColumn::BLOCK_ROWS];
+
+    // Unpack the bit-packed blocks, read the rows after them in runs of the same size, which never span two segments
+    std::size_t first = 0;
+    if (const auto &p = packed[id]) {
+        for (std::size_t block = 0; block != p->num_blocks(); ++block, first += PackedColumn::BLOCK_ROWS) {
+            p->unpack(block, values);
+            consume(first, values, PackedColumn::BLOCK_ROWS);
+        }
+    }
+    while (first < row_count) {
+        const auto n = std::min(PackedColumn::BLOCK_ROWS, row_count - first);
+        read_integers(reinterpret_cast<const char *>(value_address(id, first)), value_bytes, n, values);
+        consume(first, values, n);
+        first += n;
+    }
+}
+
+Selection ColumnStore::select_equal(std::size_t id, const std::string &value) {
+    encode();
+    Selection selection;
+    dictionaries[id]->select_equal(value, selection);
+    skip_dead(selection);
+    return selection;
+}
+
+Selection ColumnStore::select_in(std::size_t id, const std::vector<std::string> &values) {
+    encode();
+    Selection selection;
+    dictionaries[id]->select_in(values, selection);
+    skip_dead(selection);
+    return selection;
+}
+
+/** Evaluates `kernel(values, n, out)` on every run of contiguous rows of attribute `id` and clears the bits of NULL
+ * and dead rows. */
+template<typename Kernel>
+RowBitmap ColumnStore::filter_runs(std::size_t id, Kernel &&kernel) {
+    transpose_nulls(row_count);
+    RowBitmap result(row_count);
+    // Runs end at segments, which start at multiples of 64 rows, so every run starts at a word of its own
+    for (std::size_t first = 0; first < row_count; first += contiguous_rows(first))
+        kernel(values(id, first), contiguous_rows(first), result.words.data() + first / 64);
+    exclude_nulls_and_dead(id, result);
+    return result;
+}
+
+/** Clears the bits of the rows in `result` that are dead or where attribute `id` is NULL. */
+void ColumnStore::exclude_nulls_and_dead(std::size_t id, RowBitmap &result) const {
+    // Only the attribute's own null bitmap is read, a word at a time
+    if (const auto &nulls = null_columns[id]) {
+        for (std::size_t w = 0; w != nulls->num_words(); ++w)
+            result.words[w] &= ~nulls->word(w);
+    }
+    if (not dead_rows.empty()) {
+        for (std::size_t row = 0; row != row_count; ++row)
+            if (dead_rows.is_dead(row)) result.reset(row);
+    }
+}
+
+RowBitmap ColumnStore::filter_integers(std::size_t id, predicate::Comparison op, int64_t lo, int64_t hi) {
+    const auto &type = *table()[id].type;
+    if (not type.is_integral()) throw std::invalid_argument("integer constants need an integer attribute");
+    const std::size_t value_bytes = type.size() / 8;
+    return filter_runs(id, [&](const uint8_t *values, std::size_t n, uint64_t *out) {
+        predicate::compare_integers(values, value_bytes, n, op, lo, hi, out);
+    });
+}
+
+RowBitmap ColumnStore::filter(std::size_t id, predicate::Comparison op, double lo, double hi) {
+    const auto &type = *table()[id].type;
+    if (type.is_float()) {
+        return filter_runs(id, [&](const uint8_t *values, std::size_t n, uint64_t *out) {
+            predicate::compare(reinterpret_cast<const float *>(values), n, op, float(lo), float(hi), out);
+        });
+    }
+    if (type.is_double()) {
+        return filter_runs(id, [&](const uint8_t *values, std::size_t n, uint64_t *out) {
+            predicate::compare(reinterpret_cast<const double *>(values), n, op, lo, hi, out);
+        });
+    }
+    throw std::invalid_argument("floating-point constants need a FLOAT or DOUBLE attribute");
+}
+
+RowBitmap ColumnStore::filter(std::size_t id, predicate::Comparison op, const std::string &lo,
+                              const std::string &hi) {
+    const auto &type = *table()[id].type;
+    if (not type.is_character_sequence()) throw std::invalid_argument("string constants need a CHAR attribute");
+    if (const auto &h = string_heaps[id]) {
+        // Mostly decided on the prefixes, without touching the plain column
+        encode();
+        RowBitmap result(row_count);
+        h->compare(op, lo, hi, result.words.data());
+        exclude_nulls_and_dead(id, result);
+        return result;
+    }
+    const std::size_t length = type.size() / 8;
+    return filter_runs(id, [&](const uint8_t *values, std::size_t n, uint64_t *out) {
+        predicate::compare_chars(reinterpret_cast<const char *>(values), length, n, op, lo.c_str(), hi.c_str(), out);
+    });
+}
+
+void ColumnStore::gather(std::size_t id, const Selection &rows, void *out) const {
+    const std::size_t value_bytes = (table()[id].type->size() + 7) / 8;
+    auto dst = static_cast<uint8_t *>(out);
+    for (std::size_t i = 0; i != rows.size(); ++i, dst += value_bytes) {
+        if (i + PREFETCH_DISTANCE < rows.size()) __builtin_prefetch(value_address(id, rows[i + PREFETCH_DISTANCE]));
+        memcpy(dst, value_address(id, rows[i]), value_bytes);
+    }
+}
+
+ColumnStore::Projection ColumnStore::project(const RowBitmap &qualifying, const std::vector<std::size_t> &ids) {
+    transpose_nulls(row_count);
+    Projection projection;
+    projection.rows = qualifying.to_selection();
+    const auto &rows = projection.rows;
+    for (auto id : ids) {
+        const std::size_t value_bytes = (table()[id].type->size() + 7) / 8;
+        projection.columns.emplace_back(rows.size() * value_bytes);
+        gather(id, rows, projection.columns.back().data());
+
+        RowBitmap column_nulls;
+        if (const auto &n = null_columns[id]) {
+            column_nulls = RowBitmap(rows.size());
+            for (std::size_t i = 0; i != rows.size(); ++i)
+                if (n->is_null(rows[i])) column_nulls.set(i);
+        }
+        projection.nulls.push_back(std::move(column_nulls));
+    }
+    return projection;
+}
+
+/** Removes dead rows from `selection`. */
+void ColumnStore::skip_dead(Selection &selection) const {
+    if (dead_rows.empty()) return;
+    selection.erase(std::remove_if(selection.begin(), selection.end(),
+                                   [this](uint32_t row) { return dead_rows.is_dead(row); }),
+                    selection.end());
+}
+
+bool ColumnStore::drop_null_bitmap() {
+    if (not bitmap_buffer) return true;
+
+    // Only possible if no row contains a NULL
+    for (std::size_t row = 0; row != row_count; ++row)
+        if (any_bit(bitmap_address(row), 0, table().size())) return false;
+
+    // A bitmap restored from a snapshot is freed along with the mapping
+    if (not mapping)
+        release_column(bitmap_buffer, bitmap_bytes());
+    bitmap_buffer = nullptr;
+    options.null_bitmap = false;
+    for (auto &n : null_columns) n.reset();
+
+    createLin();
+    return true;
+}
+
+bool ColumnStore::save(const char *path) {
+    compact();
+
+    snapshot::Contents contents;
+    contents.kind = snapshot::Kind::Column;
+    contents.num_rows = row_count;
+    // One row more, since the store grows as soon as its last row is in use
+    contents.capacity = row_count + 1;
+    contents.layout = { bitmap_buffer != nullptr };
+
+    // One snapshot segment per column, followed by the null bitmap, each as large as the padded column in memory.  The
+    // segments of a segmented column are joined.
+    std::size_t max_bytes_per_row = bitmap_bytes();
+    for (const auto &i : table())
+        max_bytes_per_row = std::max<std::size_t>(max_bytes_per_row, ceil((double) i.type->size() / 8));
+    const std::vector<uint8_t> empty_value(max_bytes_per_row + PADDING_BYTES, 0);
+    std::vector<snapshot::Pieces> segments;
+    auto add_column = [&](void *buffer, std::size_t bytes_per_row) {
+        snapshot::Pieces rows;
+        if (options.segmented) {
+            for (std::size_t first = 0; first < row_count; first += options.segment_rows)
+                rows.emplace_back(address(buffer, bytes_per_row, first),
+                                  std::min(options.segment_rows, row_count - first) * bytes_per_row);
+        } else {
+            rows.emplace_back(buffer, bytes_per_row * row_count);
+        }
+        rows.emplace_back(empty_value.data(), bytes_per_row + PADDING_BYTES);
+        segments.push_back(std::move(rows));
+    };
+    auto buff_it = columnBuffers.cbegin();
+    for (const auto &i : table()) {
+        size_t rowSizeBytes = ceil((double) i.type->size() / 8);
+        add_column(*buff_it++, rowSizeBytes);
+    }
+    if (bitmap_buffer)
+        add_column(bitmap_buffer, bitmap_bytes());
+
+    return snapshot::write(path, table(), contents, segments);
+}
+
+bool ColumnStore::restore(const char *path) {
+    if (row_count != 0) return false;
+
+    auto restored = snapshot::map(path, table(), snapshot::Kind::Column);
+    if (not restored) return false;
+
+    // Check that every segment holds a full, padded column
+    const auto &contents = restored.contents;
+    auto holds_column = [&](std::size_t idx, std::size_t bytes_per_row) {
+        const auto bytes = restored.segment_bytes[idx];
+        return bytes >= PADDING_BYTES and contents.capacity == (bytes - PADDING_BYTES) / bytes_per_row and
+               (bytes - PADDING_BYTES) % bytes_per_row == 0;
+    };
+    bool valid = contents.layout.size() == 1 and contents.capacity > contents.num_rows and
+                 restored.segments.size() == table().size() + (contents.layout[0] ? 1 : 0);
+    if (valid) {
+        std::size_t idx = 0;
+        for (const auto &i : table())
+            valid = valid and holds_column(idx++, ceil((double) i.type->size() / 8));
+        if (contents.layout[0])
+            valid = valid and holds_column(idx, bitmap_bytes());
+    }
+    if (not valid) {
+        snapshot::unmap(restored);
+        return false;
+    }
+
+    // The columns now live in the mapped file, in one piece each
+    release_buffers();
+    options.segmented = false;
+    num_segments = 0;
+    columnBuffers.assign(restored.segments.begin(), restored.segments.begin() + table().size());
+    bitmap_buffer = contents.layout[0] ? restored.segments.back() : nullptr;
+    options.null_bitmap = bitmap_buffer != nullptr;
+    row_count = contents.num_rows;
+    storable_in_buffer = contents.capacity;
+    mapping = std::move(restored);
+    reset_auxiliary();
+    commit_rows();
+
+    createLin();
+    return true;
+}
+
+StoreStatistics ColumnStore::statistics() const {
+    StoreStatistics result = stats;
+    result.rows = row_count;
+    result.live_rows = num_live_rows();
+    result.capacity = storable_in_buffer;
+    // Columns are padded, committed segments to whole pages
+    auto allocated = [this](std::size_t bytes_per_row) -> std::size_t {
+        return options.segmented ? num_segments * segment_stride_bytes(bytes_per_row)
+                                 : column_bytes(bytes_per_row, storable_in_buffer);
+    };
+    for (const auto &i : table()) {
+        result.bytes_per_row += ceil((double) i.type->size() / 8);
+        result.allocated_bytes += allocated(ceil((double) i.type->size() / 8));
+    }
+    if (bitmap_buffer) {
+        result.bytes_per_row += bitmap_bytes();
+        result.null_bitmap_bytes = allocated(bitmap_bytes());
+        result.allocated_bytes += result.null_bitmap_bytes;
+    }
+    for (const auto &n : null_columns) {
+        if (not n) continue;
+        result.null_bitmap_bytes += n->bytes();
+        result.allocated_bytes += n->bytes();
+    }
+    for (const auto &d : dictionaries)
+        if (d) result.encoded_bytes += d->bytes();
+    for (const auto &h : string_heaps)
+        if (h) result.encoded_bytes += h->bytes();
+    for (const auto &p : packed)
+        if (p) result.encoded_bytes += p->bytes();
+    return result;
 }
 
 void ColumnStore::dump(std::ostream &out) const {
-    /* TODO 1.3: Print description of this store to `out`. */
-    out << "Some useful data" << std::endl;
+    out << "ColumnStore of table '" << table().name << "', " << columnBuffers.size() << " column(s)"
+        << (options.segmented ? ", segmented" : "") << (mapping ? ", mapped from a snapshot" : "") << '\n';
+    statistics().print(out);
 }
 
 /** A custom function to create a linearization, but you need to fill columnBuffers and bitmap_buffer first **/
 void ColumnStore::createLin() {
-    /* 1.3.1: Allocate a column for the null bitmap. */
-    auto bitmap_column = std::make_unique<m::Linearization>(m::Linearization::CreateFinite(1, 1));
-    bitmap_column->add_null_bitmap(0, 0);
-
     /* 1.3.2: Create linearization. */
-    auto lin = std::make_unique<m::Linearization>(m::Linearization::CreateInfinite(this->table().size() + 1));
+    const auto begin = std::chrono::steady_clock::now();
+    linearization(make_linearization());
+    ++stats.linearizations;
+    stats.linearization_time += std::chrono::steady_clock::now() - begin;
+    publish_version();
+}
+
+std::unique_ptr<m::Linearization> ColumnStore::make_linearization() const {
+    const std::size_t num_sequences = this->table().size() + (bitmap_buffer ? 1 : 0);
+    auto lin = std::make_unique<m::Linearization>(m::Linearization::CreateInfinite(num_sequences));
+
+    auto add_column = [&](void *buffer, std::size_t bytes_per_row, std::unique_ptr<m::Linearization> column) {
+        const auto address = uint64_t(reinterpret_cast<uintptr_t>(buffer));
+        if (options.segmented) {
+            // Infinite sequence of finite segments, each holding `segment_rows` rows
+            auto segment = std::make_unique<m::Linearization>(m::Linearization::CreateFinite(1, options.segment_rows));
+            segment->add_sequence(0, bytes_per_row, std::move(column));
+            lin->add_sequence(address, segment_stride_bytes(bytes_per_row), std::move(segment));
+        } else {
+            lin->add_sequence(address, bytes_per_row, std::move(column));
+        }
+    };
 
     // Get the iterator for the buffer
     auto buff_it = columnBuffers.cbegin();
@@ -96,14 +855,44 @@ void ColumnStore::createLin() {
 
         // Add the columns to the linearization (address space from buffer)
         size_t rowSizeBytes = ceil((double) i.type->size() / 8);
-        lin->add_sequence(uint64_t(reinterpret_cast<uintptr_t>(*buff_it)), rowSizeBytes, std::move(column));
+        add_column(*buff_it, rowSizeBytes, std::move(column));
 
         // Advance iterator
         ++buff_it;
     }
-    // Finally add the null bitmap
-    lin->add_sequence(uint64_t(reinterpret_cast<uintptr_t>(bitmap_buffer)), ceil((double) table().size() / 8),
-                      std::move(bitmap_column));
+    // Finally add the null bitmap, unless no attribute can be NULL
+    if (bitmap_buffer) {
+        auto bitmap_column = std::make_unique<m::Linearization>(m::Linearization::CreateFinite(1, 1));
+        bitmap_column->add_null_bitmap(0, 0);
+        add_column(bitmap_buffer, bitmap_bytes(), std::move(bitmap_column));
+    }
+    return lin;
+}
+
+/** Publishes the current columns to readers, the old version is freed once no reader can reach it anymore. */
+void ColumnStore::publish_version() {
+    auto fresh = new Version{ {}, bitmap_buffer != nullptr, options.segmented ? options.segment_rows : 0 };
+    for_each_column([this, fresh](void *buffer, std::size_t bytes_per_row) {
+        fresh->columns.push_back({ reinterpret_cast<uint8_t *>(buffer), bytes_per_row,
+                                   options.segmented ? segment_stride_bytes(bytes_per_row) : 0 });
+    });
+    auto old = version.exchange(fresh);
+    if (not options.concurrent_readers) {
+        delete old;
+        return;
+    }
+
+    // Readers pinned from now on find the new version, so the memory it replaced can be retired only now
+    if (old) epochs.retire([old]() { delete old; });
+    for (auto &free : unpublished)
+        epochs.retire(std::move(free));
+    unpublished.clear();
+}
 
-    linearization(std::move(lin));
+ColumnStore::ReadView ColumnStore::read_view() const {
+    ReadView view(epochs.pin());
+    // Rows committed before the version is read are in that version, which copied them if it moved them
+    view.rows = committed_rows();
+    view.version = version.load(std::memory_order_acquire);
+    return view;
 }
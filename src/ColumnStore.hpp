@@ -1,33 +1,368 @@
 #pragma once
 
+#include "BitPacking.hpp"
+#include "Bits.hpp"
+#include "ConcurrentAppend.hpp"
+#include "Dictionary.hpp"
+#include "Epoch.hpp"
+#include "Memory.hpp"
+#include "NullBitmap.hpp"
+#include "Predicate.hpp"
+#include "Snapshot.hpp"
+#include "StringColumn.hpp"
+#include "StoreStatistics.hpp"
+#include "Tombstones.hpp"
+#include "ZoneMap.hpp"
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <memory>
 #include <mutable/mutable.hpp>
+#include <string>
+#include <type_traits>
+#include <vector>
 
 
 struct ColumnStore : m::Store
 {
+    /** Every column and the null bitmap start at a multiple of `ALIGNMENT` bytes, and at least `PADDING_BYTES`
+     * readable bytes follow the last row of each, in segmented mode of each segment.  Vectorized kernels may therefore
+     * use aligned loads and read whole registers past the last row instead of handling a scalar tail. */
+    static constexpr std::size_t ALIGNMENT = 64;
+    static constexpr std::size_t PADDING_BYTES = 64;
+    /** Rows `gather()` prefetches ahead of the row it copies. */
+    static constexpr std::size_t PREFETCH_DISTANCE = 16;
+
+    /** Options to configure how a `ColumnStore` allocates its memory. */
+    struct Options
+    {
+        /** Backend of the column buffers and the null bitmap, unless `segmented`. */
+        memory::AllocationOptions allocation;
+        /** Let readers take `read_view()`s while a writer appends: growing copies the columns into new buffers and
+         * frees the old ones once no view can scan them anymore, instead of reallocating the buffers in place. */
+        bool concurrent_readers = false;
+        /** Build every column from segments of `segment_rows` rows inside a reservation of `max_bytes` of address
+         * space.  Growing commits one more segment per column instead of moving the columns, and the linearization
+         * never changes.  `segment_rows` is rounded up to a multiple of 1024, so blocks of encodings and zone maps
+         * never span two segments. */
+        bool segmented = false;
+        std::size_t segment_rows = 1UL << 16;
+        std::size_t max_bytes = 1UL << 34;
+        /** Keep a null bitmap.  Without it, no attribute of the table may ever be NULL. */
+        bool null_bitmap = true;
+        /** `erase()` compacts the store by up to `compaction_step` rows whenever more than `compaction_threshold` of
+         * its rows are dead.  By default, every erase compacts at once.  mutable knows nothing of dead rows and scans
+         * them like live ones, so only stores whose dead rows are skipped by their own scans may defer compaction. */
+        double compaction_threshold = 0;
+        std::size_t compaction_step = 1024;
+        /** Names of CHAR attributes to keep dictionary encoded as well, for predicates on their codes. */
+        std::vector<std::string> dictionary_attributes;
+        /** Names of CHAR attributes to keep in a variable-length string heap as well, for `filter()` on their text. */
+        std::vector<std::string> string_heap_attributes;
+        /** Names of integer attributes to keep frame-of-reference encoded and bit-packed as well, for `scan()`. */
+        std::vector<std::string> packed_attributes;
+        /** Names of integer attributes to summarize per block in zone maps, for `select_range()`. */
+        std::vector<std::string> zone_map_attributes;
+    };
+
     private:
+    /** The columns as a reader finds them, replaced whenever they move. */
+    struct Version
+    {
+        struct Column
+        {
+            uint8_t *base;
+            std::size_t bytes_per_row;
+            std::size_t segment_stride_bytes;
+        };
+        // One column per attribute, followed by the null bitmap if the store has one
+        std::vector<Column> columns;
+        bool has_null_bitmap;
+        // Rows per segment in segmented mode, 0 otherwise
+        std::size_t segment_rows;
+
+        uint8_t *address(const Column &column, std::size_t row) const {
+            if (segment_rows)
+                return column.base + row / segment_rows * column.segment_stride_bytes +
+                       row % segment_rows * column.bytes_per_row;
+            return column.base + row * column.bytes_per_row;
+        }
+    };
+
     /* 1.3.1: Declare necessary fields. */
     size_t row_count = 0;
     size_t storable_in_buffer;
 
     std::vector<void*> columnBuffers;
-    void* bitmap_buffer;
+    void* bitmap_buffer = nullptr;
+    // Segmented mode: number of committed segments, the same for every column and the null bitmap
+    std::size_t num_segments = 0;
+
+    Options options;
+
+    // Columns restored from a snapshot stay in the mapped file until they are resized
+    snapshot::Mapping mapping;
+    // Rows erased but not compacted yet
+    Tombstones dead_rows;
+    // Reallocations, copies and linearizations so far
+    StoreStatistics stats;
+    // Dictionary encoded copy of each attribute in `options.dictionary_attributes`, indexed by attribute id
+    std::vector<std::unique_ptr<DictionaryColumn>> dictionaries;
+    // Variable-length copy of each attribute in `options.string_heap_attributes`, indexed by attribute id
+    std::vector<std::unique_ptr<StringColumn>> string_heaps;
+    // Bit-packed copy of each attribute in `options.packed_attributes`, indexed by attribute id
+    std::vector<std::unique_ptr<PackedColumn>> packed;
+    // Zone map of each attribute in `options.zone_map_attributes`, indexed by attribute id
+    std::vector<std::unique_ptr<ZoneMap>> zone_maps;
+    // Column-major null bitmap of each attribute that is NULL in some row, indexed by attribute id, and the number of
+    // rows transposed into them from the row-major null bitmap mutable writes
+    std::vector<std::unique_ptr<NullBitmap>> null_columns;
+    std::size_t transposed_rows = 0;
+    // Rows claimed and published by concurrent writers, between `begin_concurrent_appends()` and
+    // `end_concurrent_appends()`
+    std::unique_ptr<ConcurrentAppend> concurrent;
+    // Readers of `read_view()`s find the current columns here, and pin the memory they read through `epochs`.  All rows
+    // before `committed` are written.
+    std::atomic<const Version *> version{ nullptr };
+    std::atomic<std::size_t> committed{ 0 };
+    mutable EpochManager epochs;
+    // Frees memory replaced since the current version was published.  That version still reaches the memory, so it is
+    // only retired once `publish_version()` replaced the version.
+    std::vector<std::function<void()>> unpublished;
 
     public:
-    ColumnStore(const m::Table &table);
+    ColumnStore(const m::Table &table) : ColumnStore(table, Options()) {}
+    ColumnStore(const m::Table &table, const Options &options);
     ~ColumnStore();
 
     std::size_t num_rows() const override;
     void append() override;
     void drop() override;
 
+    /** Makes room for at least `n` rows in total, so that appending up to `n` rows does not allocate. */
+    void reserve(std::size_t n);
+    /** Appends `n` rows at once. */
+    void append(std::size_t n);
+
+    /** Switches a segmented store to concurrent appends.  Until `end_concurrent_appends()`, writers on any thread
+     * `claim_rows()`, write them through `value_location()` and `null_location()`, and `publish_rows()`.
+     * `num_rows()` returns the watermark, below which all rows are written.  No other method may be called meanwhile,
+     * except `values()` and `null_bitmap()` of rows below the watermark.  Throws `std::logic_error` unless the store
+     * is segmented. */
+    void begin_concurrent_appends();
+    /** Claims `n` rows, commits their segments and returns the first row.  Throws `std::bad_alloc` if the reserved
+     * address space is exhausted.  Safe to call from several threads at once. */
+    std::size_t claim_rows(std::size_t n);
+    /** Publishes the `n` claimed rows from `first` on, which must be written completely.  Safe to call from several
+     * threads at once. */
+    void publish_rows(std::size_t first, std::size_t n);
+    /** Ends concurrent appends, after all writers are done.  The published rows become ordinary rows of the store.
+     * Throws `std::logic_error` if some claimed rows are not published. */
+    void end_concurrent_appends();
+
+    /** The rows committed when the view was taken.  The memory of the view stays valid while a writer appends more
+     * rows, even if the store moves its columns meanwhile, until the view is destroyed. */
+    struct ReadView
+    {
+        /** Returns the number of rows in the view. */
+        std::size_t num_rows() const { return rows; }
+        /** Returns the address of the value of attribute `id` in row `row` of the view. */
+        const uint8_t *values(std::size_t id, std::size_t row = 0) const {
+            return version->address(version->columns[id], row);
+        }
+        /** Returns the location of the value of attribute `id` in row `row` of the view. */
+        BitAddress value_location(std::size_t id, std::size_t row) const {
+            return { version->address(version->columns[id], row), 0 };
+        }
+        /** Returns the location of the NULL bit of attribute `id` in row `row` of the view, with a `nullptr` base if
+         * the store has no null bitmap. */
+        BitAddress null_location(std::size_t id, std::size_t row) const {
+            if (not version->has_null_bitmap) return { nullptr, 0 };
+            return { version->address(version->columns.back(), row), id };
+        }
+
+        private:
+        friend struct ColumnStore;
+        ReadView(EpochManager::Guard guard) : guard(std::move(guard)) {}
+
+        EpochManager::Guard guard;
+        const Version *version = nullptr;
+        std::size_t rows = 0;
+    };
+    /** Returns a view of the committed rows.  Safe to call from any thread while one writer appends, if the store has
+     * `Options::concurrent_readers` or is segmented; rows are only erased, compacted or dropped while no view
+     * exists.  mutable's queries read the linearization instead, which only a segmented store never replaces. */
+    ReadView read_view() const;
+    /** Returns the number of rows written completely, which a `read_view()` sees.  mutable writes the values of a row
+     * after appending it, so every `append()` commits the rows before the new one. */
+    std::size_t committed_rows() const {
+        return concurrent ? concurrent->watermark() : committed.load(std::memory_order_acquire);
+    }
+    /** Commits all rows appended so far, once their values are written. */
+    void commit_rows() { committed.store(row_count, std::memory_order_release); }
+
+    /** Marks row `row` dead and compacts as `Options::compaction_threshold` asks, by default at once: the last row
+     * moves into its place.  Until compacted, a dead row keeps its place and stays visible to mutable.  Returns false
+     * if the row does not exist or is dead already. */
+    bool erase(std::size_t row);
+    /** Returns true iff row `row` exists and is not dead. */
+    bool is_live(std::size_t row) const { return row < row_count and not dead_rows.is_dead(row); }
+    /** Returns the number of rows not dead. */
+    std::size_t num_live_rows() const { return row_count - dead_rows.size(); }
+    /** Returns the dead rows, which scans must skip. */
+    const Tombstones &tombstones() const { return dead_rows; }
+    /** Moves up to `budget` live rows from the end of the store into the places of dead rows, drops all dead rows from
+     * the end and shrinks the columns accordingly.  Moved rows change their index.  Returns the number of rows moved. */
+    std::size_t compact(std::size_t budget = std::numeric_limits<std::size_t>::max());
+
+    /** Encodes the rows appended since the last call into the dictionary encoded, string heap and bit-packed columns,
+     * the latter in whole blocks only.  mutable writes the values of a row only after appending it, so encoding catches up
+     * lazily, before predicates are evaluated and columns are scanned. */
+    void encode();
+    /** Returns the dictionary encoded column of attribute `id`, or `nullptr` if it is not dictionary encoded.  Rows
+     * appended since the last `encode()` are missing. */
+    const DictionaryColumn *dictionary(std::size_t id) const { return dictionaries[id].get(); }
+    /** Returns the live rows whose dictionary encoded attribute `id` is `value`, comparing codes instead of strings. */
+    Selection select_equal(std::size_t id, const std::string &value);
+    /** Returns the live rows whose dictionary encoded attribute `id` is one of `values`. */
+    Selection select_in(std::size_t id, const std::vector<std::string> &values);
+
+    /** Returns the string heap of attribute `id`, or `nullptr` if it has none.  Rows appended since the last
+     * `encode()` are missing. */
+    const StringColumn *string_heap(std::size_t id) const { return string_heaps[id].get(); }
+
+    /** Returns the bit-packed column of attribute `id`, or `nullptr` if it is not bit-packed. */
+    const PackedColumn *packed_column(std::size_t id) const { return packed[id].get(); }
+    /** Consumer of a run of `n` consecutive values starting at row `first`. */
+    using scan_consumer = std::function<void(std::size_t first, const int64_t *values, std::size_t n)>;
+    /** Passes all values of the integer attribute `id`, widened to 64 bits, to `consume`, in runs of consecutive
+     * rows.  Bit-packed blocks are unpacked, all other rows are read from the plain column.  Values of NULL rows are
+     * unspecified, and dead rows are included. */
+    void scan(std::size_t id, const scan_consumer &consume);
+
+    /** Returns the zone map of attribute `id`, or `nullptr` if it has none. */
+    const ZoneMap *zone_map(std::size_t id) const { return zone_maps[id].get(); }
+    /** Returns the live rows whose integer attribute `id` lies in [`lo`, `hi`].  Blocks whose zone rules out the range
+     * are skipped, their number is added to `*skipped_blocks`, if given. */
+    Selection select_range(std::size_t id, int64_t lo, int64_t hi, std::size_t *skipped_blocks = nullptr);
+
+    /** Returns the live rows whose attribute `id` compares to `lo` (and `hi`) as `op` says, evaluated by the kernels of
+     * `predicate` directly on the column.  NULLs never qualify.  Integer attributes take integer constants of any
+     * range, floating-point attributes take `double` constants rounded to their type, and CHAR attributes take
+     * strings; a CHAR attribute with a string heap is compared on its heap instead of its plain column.  Throws
+     * `std::invalid_argument` if the constants do not fit the attribute's type. */
+    template<typename T>
+    std::enable_if_t<std::is_integral_v<T>, RowBitmap>
+    filter(std::size_t id, predicate::Comparison op, T lo, int64_t hi = 0) {
+        return filter_integers(id, op, lo, hi);
+    }
+    RowBitmap filter(std::size_t id, predicate::Comparison op, double lo, double hi = 0);
+    RowBitmap filter(std::size_t id, predicate::Comparison op, const std::string &lo, const std::string &hi = "");
+
+    /** The projected attributes of the qualifying rows of a scan, column by column. */
+    struct Projection
+    {
+        /** The qualifying rows. */
+        Selection rows;
+        /** Values of the `i`-th projected attribute, one per row of `rows`, back to back as `gather()` writes them. */
+        std::vector<std::vector<uint8_t>> columns;
+        /** Bit `j` of `nulls[i]` is set iff the `i`-th projected attribute is NULL in row `rows[j]`.  Empty if the
+         * attribute is NULL in no row. */
+        std::vector<RowBitmap> nulls;
+    };
+    /** Copies the values of attribute `id` in the rows of `rows` to `out`, back to back in the order of `rows`, one
+     * byte per BOOL.  Values of NULL rows are unspecified, see `nulls()`.  The values `PREFETCH_DISTANCE` rows ahead
+     * are prefetched, so that sparse rows do not wait for memory one after the other. */
+    void gather(std::size_t id, const Selection &rows, void *out) const;
+    /** Scans with late materialization: only the rows set in `qualifying`, e.g. a conjunction of `filter()`s on the
+     * predicate attributes, are gathered, and only for the attributes `ids`.  `qualifying` must cover all rows. */
+    Projection project(const RowBitmap &qualifying, const std::vector<std::size_t> &ids);
+
+    /** Returns the column-major null bitmap of attribute `id`, or `nullptr` if the attribute is NULL in no row.
+     * mutable reads and writes NULLs through the row-major null bitmap of the linearization, the store transposes it
+     * lazily for its own scans. */
+    const NullBitmap *nulls(std::size_t id) {
+        transpose_nulls(row_count);
+        return null_columns[id].get();
+    }
+
+    /** Returns the address of the value of attribute `id` in row `row`, see `ALIGNMENT` and `PADDING_BYTES`. */
+    const uint8_t *values(std::size_t id, std::size_t row = 0) const { return value_address(id, row); }
+    /** Returns the address of the null bitmap of row `row`, or `nullptr` if the store has no null bitmap. */
+    const uint8_t *null_bitmap(std::size_t row = 0) const { return bitmap_buffer ? bitmap_address(row) : nullptr; }
+    /** Returns the location of the value of attribute `id` in row `row`, which must have been appended. */
+    BitAddress value_location(std::size_t id, std::size_t row) const { return { value_address(id, row), 0 }; }
+    /** Returns the location of the NULL bit of attribute `id` in row `row`, with a `nullptr` base if the store has no
+     * null bitmap. */
+    BitAddress null_location(std::size_t id, std::size_t row) const {
+        return bitmap_buffer ? BitAddress{ bitmap_address(row), id } : BitAddress{ nullptr, 0 };
+    }
+    /** Returns the number of rows from row `row` on that lie back to back in memory, up to the end of the segment of
+     * `row` or of the store. */
+    std::size_t contiguous_rows(std::size_t row) const {
+        const std::size_t end = options.segmented ? (row / options.segment_rows + 1) * options.segment_rows : row_count;
+        return std::min(end, row_count) - row;
+    }
+
+    /** Frees the null bitmap, if no row contains a NULL.  Afterwards, no attribute may be set to NULL anymore.
+     * Returns true iff the store has no null bitmap (anymore). */
+    bool drop_null_bitmap();
+
+    /** Compacts the store, since snapshots hold no dead rows, and writes a snapshot of all columns to the file at
+     * `path`.  Returns false if the file cannot be written. */
+    bool save(const char *path);
+    /** Replaces the columns of this empty store by the columns of the snapshot at `path`, by mapping the file into
+     * memory.  Returns false if the store is not empty or the file is no column snapshot of a table with the same
+     * schema. */
+    bool restore(const char *path);
+
     void accept(m::StoreVisitor &v) override { v(*this); }
     void accept(m::ConstStoreVisitor &v) const override { v(*this); }
 
+    /** Returns a linearization of the columns where they are in memory right now, e.g. for a store that wraps this one.
+     * It is valid until the store replaces its own linearization. */
+    std::unique_ptr<m::Linearization> make_linearization() const;
+
+    /** Returns what the store holds in memory and what maintaining it has cost so far. */
+    StoreStatistics statistics() const;
+
     void dump(std::ostream &out) const override;
     using Store::dump;
 
     private:
+    std::size_t bitmap_bytes() const { return ceil((double) table().size() / 8); }
+    std::size_t column_bytes(std::size_t bytes_per_row, std::size_t capacity) const {
+        return bytes_per_row * capacity + PADDING_BYTES;
+    }
+    std::size_t segment_stride_bytes(std::size_t bytes_per_row) const;
+    std::size_t reserved_bytes(std::size_t bytes_per_row) const;
+    void *allocate_column(std::size_t bytes_per_row);
+    void release_column(void *buffer, std::size_t bytes_per_row);
+    uint8_t *address(void *buffer, std::size_t bytes_per_row, std::size_t row) const;
+    uint8_t *value_address(std::size_t id, std::size_t row) const;
+    uint8_t *bitmap_address(std::size_t row) const { return address(bitmap_buffer, bitmap_bytes(), row); }
+    void resize(std::size_t capacity);
+    void resize_segments(std::size_t capacity);
+    template<typename F>
+    void for_each_column(F &&f) const;
+    void release_buffers();
+    void release_mapping();
+    void free_later(std::function<void()> free);
+    void *move_column(void *buffer, std::size_t old_bytes, std::size_t new_bytes);
+    void publish_version();
+    void reset_auxiliary();
+    void summarize(std::size_t written_rows);
+    void skip_dead(Selection &selection) const;
+    RowBitmap filter_integers(std::size_t id, predicate::Comparison op, int64_t lo, int64_t hi);
+    template<typename Kernel>
+    RowBitmap filter_runs(std::size_t id, Kernel &&kernel);
+    void exclude_nulls_and_dead(std::size_t id, RowBitmap &result) const;
+    void transpose_nulls(std::size_t written_rows);
+    void transpose_row(std::size_t row);
+    bool is_null(std::size_t id, std::size_t row) const {
+        const auto &n = null_columns[id];
+        return n and n->is_null(row);
+    }
     void createLin();
 
 };
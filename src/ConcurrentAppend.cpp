@@ -0,0 +1,83 @@
+#include "ConcurrentAppend.hpp"
+#include <algorithm>
+#include <new>
+
+
+namespace {
+
+constexpr std::size_t CHUNK_WORDS = ConcurrentAppend::CHUNK_ROWS / 64;
+
+}
+
+ConcurrentAppend::ConcurrentAppend(std::size_t first_row, std::size_t max_rows, std::size_t committed_units)
+    : first_row(first_row)
+    , max_rows(max_rows)
+    , claimed(first_row)
+    , visible(first_row)
+    , committed(committed_units)
+    , num_chunks((max_rows - std::min(first_row, max_rows) + CHUNK_ROWS - 1) / CHUNK_ROWS)
+{
+    chunks = std::make_unique<std::atomic<std::atomic<uint64_t> *>[]>(num_chunks);
+    for (std::size_t i = 0; i != num_chunks; ++i)
+        chunks[i] = nullptr;
+}
+
+ConcurrentAppend::~ConcurrentAppend() {
+    for (std::size_t i = 0; i != num_chunks; ++i)
+        delete[] chunks[i].load();
+}
+
+std::size_t ConcurrentAppend::claim(std::size_t n) {
+    std::size_t first = claimed.load();
+    do {
+        if (n > max_rows - first) throw std::bad_alloc();
+    } while (not claimed.compare_exchange_weak(first, first + n));
+    return first;
+}
+
+/** Returns the bits of chunk `index`, allocating them if `create`, or `nullptr` if they do not exist. */
+std::atomic<uint64_t> *ConcurrentAppend::chunk(std::size_t index, bool create) {
+    auto words = chunks[index].load();
+    if (words or not create) return words;
+
+    // Whoever installs a chunk first wins, the others free theirs
+    auto fresh = new std::atomic<uint64_t>[CHUNK_WORDS]();
+    if (chunks[index].compare_exchange_strong(words, fresh)) return fresh;
+    delete[] fresh;
+    return words;
+}
+
+void ConcurrentAppend::publish(std::size_t first, std::size_t n) {
+    // Set the bits a word at a time.  The atomic operations are sequentially consistent, so of two writers that close
+    // a gap from both sides at least one sees the bits of the other in `advance()`.
+    for (std::size_t bit = first - first_row, end = bit + n; bit != end;) {
+        const std::size_t in_word = bit % 64, bits = std::min(64 - in_word, end - bit);
+        const uint64_t mask = (bits == 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1) << in_word;
+        chunk(bit / CHUNK_ROWS, true)[bit % CHUNK_ROWS / 64].fetch_or(mask);
+        bit += bits;
+    }
+    advance();
+}
+
+/** Moves the watermark past all published rows that directly follow it. */
+void ConcurrentAppend::advance() {
+    std::size_t v = visible.load();
+    for (;;) {
+        // Find the end of the run of published rows from the watermark on
+        std::size_t end = v;
+        for (;;) {
+            const std::size_t bit = end - first_row;
+            if (end == max_rows) break;
+            const auto words = chunk(bit / CHUNK_ROWS, false);
+            if (not words) break;
+            const uint64_t published = words[bit % CHUNK_ROWS / 64].load() >> (bit % 64);
+            const std::size_t run = published == ~uint64_t(0) >> (bit % 64) ? 64 - bit % 64
+                                                                            : __builtin_ctzll(~published);
+            end += run;
+            if (bit % 64 + run != 64) break;
+        }
+        if (end == v) return;
+        // On failure, another writer moved the watermark; continue from there
+        if (visible.compare_exchange_weak(v, end)) v = end;
+    }
+}
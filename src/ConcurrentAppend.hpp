@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+
+/** Coordinates threads that append rows to a store at the same time, without locks.  A writer claims a range of rows
+ * with one atomic update, fills the rows independently of the other writers and publishes them.  Readers see the rows
+ * up to the watermark only: the end of the longest run of published rows, which the writer that closes a gap
+ * advances.  Published rows are marked in a bitmap of one bit per row, allocated in chunks of `CHUNK_ROWS` rows when
+ * first needed.
+ *
+ * The storage of the rows is committed in units, e.g. segments or blocks, that never move.  Writers commit the units
+ * their rows need themselves; a unit may be committed by two writers at once, so committing must be idempotent. */
+struct ConcurrentAppend
+{
+    static constexpr std::size_t CHUNK_ROWS = 1UL << 16;
+
+    private:
+    // Rows before `first_row` existed before, and at most `max_rows` rows fit into the store
+    std::size_t first_row;
+    std::size_t max_rows;
+    std::atomic<std::size_t> claimed;
+    std::atomic<std::size_t> visible;
+    // Units of storage committed, from the first unit of the store on
+    std::atomic<std::size_t> committed;
+    // Published bits of the rows from `first_row` on, per chunk
+    std::unique_ptr<std::atomic<std::atomic<uint64_t> *>[]> chunks;
+    std::size_t num_chunks;
+
+    public:
+    /** Starts appending after the `first_row` rows of a store that holds at most `max_rows` rows and has
+     * `committed_units` units of storage committed. */
+    ConcurrentAppend(std::size_t first_row, std::size_t max_rows, std::size_t committed_units);
+    ~ConcurrentAppend();
+    ConcurrentAppend(const ConcurrentAppend&) = delete;
+    ConcurrentAppend &operator=(const ConcurrentAppend&) = delete;
+
+    /** Claims `n` rows and returns the first.  Throws `std::bad_alloc` if they do not fit into the store. */
+    std::size_t claim(std::size_t n);
+    /** Publishes the `n` claimed rows from `first` on, which must be written completely. */
+    void publish(std::size_t first, std::size_t n);
+
+    /** Returns the number of rows readers may see, all of them written completely. */
+    std::size_t watermark() const { return visible.load(); }
+    /** Returns the number of rows claimed so far. */
+    std::size_t claimed_rows() const { return claimed.load(); }
+    /** Returns the number of units committed so far. */
+    std::size_t committed_units() const { return committed.load(); }
+
+    /** Makes sure that at least `n` units are committed, calling `commit(i)` for every unit `i` that is not. */
+    template<typename Commit>
+    void commit_units(std::size_t n, Commit &&commit) {
+        std::size_t have = committed.load();
+        while (have < n) {
+            commit(have);
+            // Another writer may have committed this unit, or more, in the meantime
+            if (committed.compare_exchange_weak(have, have + 1)) ++have;
+        }
+    }
+
+    private:
+    std::atomic<uint64_t> *chunk(std::size_t index, bool create);
+    void advance();
+};
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <mutable/mutable.hpp>
+
+
+/** Binds a store to a fixed set of options.  `m::Catalog::register_store()` only knows how to construct a store from
+ * a table, so a store that should be created with non-default options is registered as `Configured<Store, options>`,
+ * where `options` is an object of type `Store::Options` with static storage duration. */
+template<typename S, const typename S::Options &O>
+struct Configured : S
+{
+    Configured(const m::Table &table) : S(table, O) {}
+};
@@ -0,0 +1,105 @@
+#include "Dictionary.hpp"
+#include <algorithm>
+#include <cstring>
+
+
+namespace {
+
+/** Appends the rows of the `n` codes at `codes` with `wanted[code]` set to `selection`. */
+template<typename Code>
+void select_codes(const uint8_t *codes, std::size_t n, const std::vector<uint8_t> &wanted, Selection &selection)
+{
+    auto typed = reinterpret_cast<const Code *>(codes);
+    for (std::size_t row = 0; row != n; ++row)
+        if (wanted[typed[row]]) selection.push_back(row);
+}
+
+/** Appends the rows of the `n` codes at `codes` equal to `code` to `selection`. */
+template<typename Code>
+void select_code(const uint8_t *codes, std::size_t n, uint32_t code, Selection &selection)
+{
+    auto typed = reinterpret_cast<const Code *>(codes);
+    for (std::size_t row = 0; row != n; ++row)
+        if (typed[row] == code) selection.push_back(row);
+}
+
+}
+
+std::size_t DictionaryColumn::bytes() const {
+    std::size_t result = codes.size();
+    for (const auto &v : values) result += v.size();
+    return result;
+}
+
+void DictionaryColumn::append(const char *value) {
+    uint32_t c = NULL_CODE;
+    if (value) {
+        // CHAR values end at the first NUL byte, if shorter than the column
+        std::string key(value, strnlen(value, value_bytes));
+        auto it = value_codes.find(key);
+        if (it == value_codes.end()) {
+            values.push_back(key);
+            it = value_codes.emplace(std::move(key), values.size()).first;
+            if (code_bytes < 4 and values.size() >> (8 * code_bytes) != 0) widen();
+        }
+        c = it->second;
+    }
+
+    codes.resize((num_rows + 1) * code_bytes);
+    memcpy(codes.data() + num_rows * code_bytes, &c, code_bytes); // little endian, the low bytes hold the code
+    ++num_rows;
+}
+
+void DictionaryColumn::copy(std::size_t from, std::size_t to) {
+    memcpy(codes.data() + to * code_bytes, codes.data() + from * code_bytes, code_bytes);
+}
+
+uint32_t DictionaryColumn::code(std::size_t row) const {
+    uint32_t c = 0;
+    memcpy(&c, codes.data() + row * code_bytes, code_bytes);
+    return c;
+}
+
+uint32_t DictionaryColumn::lookup(const std::string &value) const {
+    auto it = value_codes.find(value.substr(0, strnlen(value.c_str(), value_bytes)));
+    return it == value_codes.end() ? NULL_CODE : it->second;
+}
+
+void DictionaryColumn::select_equal(const std::string &value, Selection &selection) const {
+    const auto c = lookup(value);
+    if (c == NULL_CODE) return; // no row has the value
+    switch (code_bytes) {
+        case 1: select_code<uint8_t>(codes.data(), num_rows, c, selection); break;
+        case 2: select_code<uint16_t>(codes.data(), num_rows, c, selection); break;
+        default: select_code<uint32_t>(codes.data(), num_rows, c, selection); break;
+    }
+}
+
+void DictionaryColumn::select_in(const std::vector<std::string> &in_values, Selection &selection) const {
+    // Look up every value once, then test each row's code against the set of wanted codes
+    std::vector<uint8_t> wanted(values.size() + 1, 0);
+    bool any = false;
+    for (const auto &v : in_values) {
+        const auto c = lookup(v);
+        wanted[c] = c != NULL_CODE;
+        any = any or c != NULL_CODE;
+    }
+    if (not any) return;
+    switch (code_bytes) {
+        case 1: select_codes<uint8_t>(codes.data(), num_rows, wanted, selection); break;
+        case 2: select_codes<uint16_t>(codes.data(), num_rows, wanted, selection); break;
+        default: select_codes<uint32_t>(codes.data(), num_rows, wanted, selection); break;
+    }
+}
+
+/** Doubles the width of the codes, the dictionary outgrew the current width. */
+void DictionaryColumn::widen() {
+    const unsigned new_code_bytes = code_bytes * 2;
+    std::vector<uint8_t> widened(num_rows * new_code_bytes, 0);
+    for (std::size_t row = 0; row != num_rows; ++row) {
+        const auto c = code(row);
+        memcpy(widened.data() + row * new_code_bytes, &c, new_code_bytes);
+    }
+    codes = std::move(widened);
+    code_bytes = new_code_bytes;
+}
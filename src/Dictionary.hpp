@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Selection.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+/** A dictionary encoded CHAR column: the distinct values of the column and one narrow integer code per row.  Code 0
+ * stands for NULL, the codes of values start at 1.  Codes take 1, 2 or 4 bytes, widened as the dictionary grows. */
+struct DictionaryColumn
+{
+    static constexpr uint32_t NULL_CODE = 0;
+
+    private:
+    // Width of the CHAR values in bytes
+    std::size_t value_bytes;
+    // Distinct values, value of code `c` at `values[c - 1]`, and the code of each value
+    std::vector<std::string> values;
+    std::unordered_map<std::string, uint32_t> value_codes;
+    // Codes of all rows, `code_bytes` each
+    std::vector<uint8_t> codes;
+    unsigned code_bytes = 1;
+    std::size_t num_rows = 0;
+
+    public:
+    explicit DictionaryColumn(std::size_t value_bytes) : value_bytes(value_bytes) {}
+
+    /** Returns the number of encoded rows. */
+    std::size_t size() const { return num_rows; }
+    /** Returns the number of distinct values, NULL excluded. */
+    std::size_t num_values() const { return values.size(); }
+    /** Returns the width of a code in bytes. */
+    unsigned width() const { return code_bytes; }
+    /** Returns the bytes taken by the codes and the dictionary. */
+    std::size_t bytes() const;
+
+    /** Appends the CHAR value at `value`, or NULL if `value` is `nullptr`. */
+    void append(const char *value);
+    /** Forgets all rows from `n` on. */
+    void truncate(std::size_t n) { num_rows = std::min(num_rows, n); codes.resize(num_rows * code_bytes); }
+    /** Sets the code of row `to` to the code of row `from`. */
+    void copy(std::size_t from, std::size_t to);
+
+    /** Returns the code of row `row`. */
+    uint32_t code(std::size_t row) const;
+    /** Returns the code of `value`, or `NULL_CODE` if it does not occur in the column. */
+    uint32_t lookup(const std::string &value) const;
+    /** Returns the value of code `code`, which must not be `NULL_CODE`. */
+    const std::string &value(uint32_t code) const { return values[code - 1]; }
+
+    /** Appends the rows whose value is `value` to `selection`. */
+    void select_equal(const std::string &value, Selection &selection) const;
+    /** Appends the rows whose value is one of `in_values` to `selection`. */
+    void select_in(const std::vector<std::string> &in_values, Selection &selection) const;
+
+    private:
+    void widen();
+};
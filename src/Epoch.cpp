@@ -0,0 +1,51 @@
+#include "Epoch.hpp"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+
+EpochManager::~EpochManager() {
+    for (auto &r : retired)
+        r.second();
+}
+
+EpochManager::Guard EpochManager::pin() {
+    // Start at a slot of its own for every thread, so that readers rarely compete for a slot
+    const std::size_t start = std::hash<std::thread::id>()(std::this_thread::get_id()) % MAX_READERS;
+    for (std::size_t i = 0; i != MAX_READERS; ++i) {
+        auto &slot = slots[(start + i) % MAX_READERS].epoch;
+        uint64_t e = global.load(), expected = 0;
+        if (not slot.compare_exchange_strong(expected, e)) continue;
+
+        // A writer may have retired memory after the epoch was read, and reclaimed it before the slot was taken.
+        // Announce the epoch it moved on to, whose memory this reader reaches, until the epoch is stable.
+        for (uint64_t now; (now = global.load()) != e; e = now)
+            slot.store(now);
+        return Guard(&slot);
+    }
+    throw std::runtime_error("too many readers pinned at once");
+}
+
+void EpochManager::retire(std::function<void()> free) {
+    // Readers pinned from now on see the epoch after the retirement, which is newer than that of the memory
+    retired.emplace_back(global.fetch_add(1), std::move(free));
+    reclaim();
+}
+
+std::size_t EpochManager::reclaim() {
+    uint64_t oldest = std::numeric_limits<uint64_t>::max();
+    for (std::size_t i = 0; i != MAX_READERS; ++i) {
+        const uint64_t e = slots[i].epoch.load();
+        if (e) oldest = std::min(oldest, e);
+    }
+
+    // Readers pinned in the epoch of a retirement, or before, may still reach its memory
+    auto first_kept = std::stable_partition(retired.begin(), retired.end(),
+                                            [oldest](const auto &r) { return r.first < oldest; });
+    const std::size_t num_freed = first_kept - retired.begin();
+    for (auto it = retired.begin(); it != first_kept; ++it)
+        it->second();
+    retired.erase(retired.begin(), first_kept);
+    return num_freed;
+}
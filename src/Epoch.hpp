@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+
+/** Epoch-based reclamation of memory that readers on other threads may still scan.  A reader pins the current epoch
+ * while it reads.  A writer that replaces some memory retires the old memory instead of freeing it, which advances the
+ * epoch; the memory is freed once every reader pinned in the epoch of its retirement, or before, is gone.
+ *
+ * Any number of threads may pin at once, but only one thread at a time may retire and reclaim. */
+struct EpochManager
+{
+    /** Readers that can be pinned at the same time. */
+    static constexpr std::size_t MAX_READERS = 128;
+
+    /** Keeps a reader pinned until it is destroyed. */
+    struct Guard
+    {
+        Guard() = default;
+        Guard(Guard &&other) noexcept : slot(std::exchange(other.slot, nullptr)) {}
+        Guard &operator=(Guard &&other) noexcept {
+            std::swap(slot, other.slot);
+            return *this;
+        }
+        ~Guard() { if (slot) slot->store(0); }
+
+        private:
+        friend struct EpochManager;
+        explicit Guard(std::atomic<uint64_t> *slot) : slot(slot) {}
+
+        std::atomic<uint64_t> *slot = nullptr;
+    };
+
+    private:
+    // The epoch of every pinned reader, 0 in free slots, each on a cache line of its own
+    struct alignas(64) Slot
+    {
+        std::atomic<uint64_t> epoch{ 0 };
+    };
+
+    std::atomic<uint64_t> global{ 1 };
+    std::unique_ptr<Slot[]> slots;
+    // Memory retired but not freed yet, with the epoch of its retirement
+    std::vector<std::pair<uint64_t, std::function<void()>>> retired;
+
+    public:
+    EpochManager() : slots(std::make_unique<Slot[]>(MAX_READERS)) {}
+    /** Frees all retired memory, no reader may be pinned anymore. */
+    ~EpochManager();
+    EpochManager(const EpochManager&) = delete;
+    EpochManager &operator=(const EpochManager&) = delete;
+
+    /** Pins the current epoch.  Memory the reader reaches after pinning stays valid until the guard is destroyed.
+     * Throws `std::runtime_error` if `MAX_READERS` readers are pinned already. */
+    Guard pin();
+
+    /** Calls `free` once no reader that might still reach the retired memory is pinned, possibly right away. */
+    void retire(std::function<void()> free);
+    /** Frees the retired memory no pinned reader can reach anymore.  Returns the number of retirements freed. */
+    std::size_t reclaim();
+
+    /** Returns the number of retirements not freed yet. */
+    std::size_t num_retired() const { return retired.size(); }
+    /** Returns the current epoch. */
+    uint64_t epoch() const { return global.load(); }
+};
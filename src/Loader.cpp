@@ -0,0 +1,416 @@
+#include "Loader.hpp"
+#include "ColumnStore.hpp"
+#include "PaxStore.hpp"
+#include "RowStore.hpp"
+#include "Bits.hpp"
+#include "CSV.hpp"
+#include "Snapshot.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <fcntl.h>
+#include <fstream>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+
+namespace {
+
+// Bytes at the beginning of a file used to estimate the record length
+constexpr std::size_t SAMPLE_BYTES = 1UL << 16;
+// Over-estimate the number of records, since the sampled records may be longer than the average
+constexpr double SAFETY_MARGIN = 1.1;
+// Ranges per thread, so that threads that finish early can take over the ranges of slower ones
+constexpr std::size_t RANGES_PER_THREAD = 4;
+
+/** Runs `task(i)` for all `i` in [0, `n`) on `num_threads` threads, each taking the next `i` when it is done. */
+template<typename Task>
+void parallel_for(std::size_t n, unsigned num_threads, Task &&task) {
+    std::atomic<std::size_t> next(0);
+    auto work = [&]() {
+        for (std::size_t i; (i = next++) < n;)
+            task(i);
+    };
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < num_threads; ++t)
+        threads.emplace_back(work);
+    work();
+    for (auto &t : threads)
+        t.join();
+}
+
+/** A file mapped read-only into memory. */
+struct MappedFile
+{
+    const char *data = nullptr;
+    std::size_t size = 0;
+    bool ok = false;
+
+    explicit MappedFile(const char *path) {
+        const int fd = open(path, O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (fstat(fd, &st) == 0) {
+            size = st.st_size;
+            ok = true;
+            if (size) {
+                void *address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (address == MAP_FAILED) {
+                    ok = false;
+                } else {
+                    madvise(address, size, MADV_SEQUENTIAL);
+                    data = static_cast<const char *>(address);
+                }
+            }
+        }
+        close(fd);
+    }
+    ~MappedFile() {
+        if (data) munmap(const_cast<char *>(data), size);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile &operator=(const MappedFile&) = delete;
+};
+
+/** How a field of the CSV file is converted into a value of an attribute. */
+struct Conversion
+{
+    enum Kind { Boolean, Integer, Float, Double, Char } kind;
+    std::size_t bytes;
+};
+
+/** Returns the conversion into values of `type` in `conversion`, or false if `load_CSV_parallel()` does not support
+ * `type`. */
+bool conversion_for(const m::PrimitiveType &type, Conversion &conversion) {
+    const std::size_t bytes = (type.size() + 7) / 8;
+    if (type.is_boolean())
+        conversion = { Conversion::Boolean, bytes };
+    else if (type.is_integral())
+        conversion = { Conversion::Integer, bytes };
+    else if (type.is_float())
+        conversion = { Conversion::Float, bytes };
+    else if (type.is_double())
+        conversion = { Conversion::Double, bytes };
+    else if (type.is_character_sequence())
+        conversion = { Conversion::Char, bytes };
+    else
+        return false;
+    return true;
+}
+
+/** Writes the value of `field` to `value`.  Returns false if `field` is no valid value of the conversion. */
+bool convert(const Conversion &conversion, const csv::Field &field, BitAddress value, std::string &scratch) {
+    uint8_t *dst = value.base + value.bit / 8;
+    const auto length = std::size_t(field.end - field.begin);
+    switch (conversion.kind) {
+        case Conversion::Boolean: {
+            auto is = [&](const char *word) {
+                return length == strlen(word) and strncasecmp(field.begin, word, length) == 0;
+            };
+            if (not is("TRUE") and not is("FALSE") and not is("1") and not is("0")) return false;
+            set_bit(value.base, value.bit, is("TRUE") or is("1"));
+            return true;
+        }
+
+        case Conversion::Integer: {
+            int64_t i;
+            const char *begin = field.begin + (length and *field.begin == '+');
+            auto [end, error] = std::from_chars(begin, field.end, i);
+            if (error != std::errc() or end != field.end) return false;
+            const unsigned shift = 64 - 8 * conversion.bytes;
+            if (int64_t(uint64_t(i) << shift) >> shift != i) return false; // out of range
+            memcpy(dst, &i, conversion.bytes); // little endian: the low bytes come first
+            return true;
+        }
+
+        case Conversion::Float:
+        case Conversion::Double: {
+            double d;
+#if __cpp_lib_to_chars >= 201611
+            // Parses in place, without a locale
+            const char *begin = field.begin + (length and *field.begin == '+');
+            auto [end, error] = std::from_chars(begin, field.end, d);
+            if (error != std::errc() or end != field.end or begin == field.end) return false;
+#else
+            // `strtod()` requires a terminated string
+            scratch.assign(field.begin, length);
+            char *end;
+            errno = 0;
+            d = strtod(scratch.c_str(), &end);
+            if (scratch.empty() or end != scratch.c_str() + scratch.size() or errno == ERANGE) return false;
+#endif
+            if (conversion.kind == Conversion::Float) {
+                const float f = d;
+                memcpy(dst, &f, sizeof(f));
+            } else {
+                memcpy(dst, &d, sizeof(d));
+            }
+            return true;
+        }
+
+        case Conversion::Char: {
+            const char *begin = field.begin;
+            std::size_t n = length;
+            if (field.escaped) {
+                scratch = csv::unescape(field);
+                begin = scratch.data();
+                n = scratch.size();
+            }
+            // Longer strings are truncated, shorter ones padded with NULs
+            n = std::min(n, conversion.bytes);
+            memcpy(dst, begin, n);
+            memset(dst + n, 0, conversion.bytes - n);
+            return true;
+        }
+    }
+    return false;
+}
+
+/** Returns the starts of about `size / chunk_bytes` ranges of the records in [`begin`, `begin + size`), followed by
+ * the end of the data.  A range starts at a record, and the quotes before it are counted in parallel to know whether
+ * a newline ends a record or belongs to a quoted field. */
+std::vector<const char *> split_ranges(const char *begin, std::size_t size, std::size_t chunk_bytes,
+                                       unsigned num_threads) {
+    const char *end = begin + size;
+    const std::size_t num_chunks = std::max<std::size_t>(1, std::min(size / std::max<std::size_t>(chunk_bytes, 1),
+                                                                      std::size_t(num_threads) * RANGES_PER_THREAD));
+    std::vector<const char *> chunks(num_chunks + 1);
+    for (std::size_t c = 0; c != num_chunks; ++c)
+        chunks[c] = begin + size * c / num_chunks;
+    chunks[num_chunks] = end;
+
+    // A chunk starts inside quotes iff an odd number of quotes precedes it
+    std::vector<std::size_t> quotes(num_chunks);
+    parallel_for(num_chunks, num_threads, [&](std::size_t c) {
+        quotes[c] = csv::count_quotes(chunks[c], chunks[c + 1], csv::is_escaped(chunks[c], begin));
+    });
+
+    std::vector<const char *> ranges(num_chunks + 1);
+    bool in_quotes = false;
+    for (std::size_t c = 0; c != num_chunks; ++c) {
+        ranges[c] = csv::next_record(chunks[c], begin, end, in_quotes);
+        in_quotes ^= quotes[c] & 1;
+    }
+    ranges[num_chunks] = end;
+    // A record spanning several chunks makes their ranges start at the same record; the later ones are then empty
+    for (std::size_t c = 1; c != num_chunks; ++c)
+        ranges[c] = std::max(ranges[c], ranges[c - 1]);
+    return ranges;
+}
+
+/* Locations of the value and the NULL bit of attribute `id` in row `row`, in the argument order of each store. */
+BitAddress value_in(const RowStore &store, std::size_t row, std::size_t id) { return store.value_location(row, id); }
+BitAddress value_in(const ColumnStore &store, std::size_t row, std::size_t id) {
+    return store.value_location(id, row);
+}
+BitAddress null_in(const RowStore &store, std::size_t row, std::size_t id) { return store.null_location(row, id); }
+BitAddress null_in(const ColumnStore &store, std::size_t row, std::size_t id) { return store.null_location(id, row); }
+
+/** Loads the records in [`begin`, `end`) into `store`, see `load_CSV_parallel()`.  `attributes` gives the attribute
+ * of every field of a record. */
+template<typename Store>
+void load_records(m::Diagnostic &diag, const m::Table &table, Store &store, const char *path, const char *begin,
+                  const char *end, const std::vector<std::size_t> &attributes, unsigned num_threads,
+                  std::size_t chunk_bytes) {
+    std::vector<Conversion> conversions(table.size());
+    for (const auto &i : table)
+        conversion_for(*i.type, conversions[i.id]);
+
+    const auto ranges = split_ranges(begin, end - begin, chunk_bytes, num_threads);
+    const std::size_t num_ranges = ranges.size() - 1;
+
+    // Count the records of every range to know at which row it starts, then append all rows at once
+    std::vector<std::size_t> first_row(num_ranges + 1);
+    parallel_for(num_ranges, num_threads, [&](std::size_t r) {
+        first_row[r + 1] = csv::count_records(ranges[r], ranges[r + 1]);
+    });
+    first_row[0] = store.num_rows();
+    for (std::size_t r = 0; r != num_ranges; ++r)
+        first_row[r + 1] += first_row[r];
+    store.append(first_row[num_ranges] - first_row[0]);
+
+    // Every thread writes the rows of its ranges.  No byte holds values or NULL bits of two rows, so threads never
+    // write to the same byte.  Zone maps, encodings and column-major NULLs catch up with the rows on the next scan.
+    std::atomic<std::size_t> malformed(0);
+    parallel_for(num_ranges, num_threads, [&](std::size_t r) {
+        std::vector<csv::Field> fields;
+        std::vector<bool> present(table.size());
+        std::string scratch;
+        std::size_t row = first_row[r], num_malformed = 0;
+
+        auto set_null = [&](std::size_t id, bool is_null) {
+            const auto null = null_in(store, row, id);
+            if (null.base) set_bit(null.base, null.bit, is_null);
+            return null.base != nullptr;
+        };
+
+        csv::for_each_split_record(ranges[r], ranges[r + 1], fields, [&](const std::vector<csv::Field> &record) {
+            if (record.size() != attributes.size()) ++num_malformed;
+
+            std::fill(present.begin(), present.end(), false);
+            for (std::size_t f = 0, n = std::min(record.size(), attributes.size()); f != n; ++f) {
+                const auto id = attributes[f];
+                const auto &field = record[f];
+                present[id] = true;
+                // An unquoted empty field is NULL, a quoted one the empty string
+                if (field.empty() and not field.quoted) {
+                    if (not set_null(id, true)) ++num_malformed;
+                    continue;
+                }
+                if (convert(conversions[id], field, value_in(store, row, id), scratch)) {
+                    set_null(id, false);
+                } else {
+                    ++num_malformed;
+                    set_null(id, true);
+                }
+            }
+            // Attributes missing from the file or the record are NULL
+            for (const auto &i : table)
+                if (not present[i.id]) set_null(i.id, true);
+            ++row;
+        });
+        malformed += num_malformed;
+    });
+    // Readers of `read_view()`s see the loaded rows from now on
+    store.commit_rows();
+
+    if (malformed)
+        diag.err() << path << ": " << malformed << " malformed record(s) or value(s), loaded as NULL" << std::endl;
+}
+
+}
+
+std::size_t estimate_CSV_rows(const char *path, bool has_header) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (not in) return 0;
+
+    const std::size_t file_size = in.tellg();
+    in.seekg(0);
+
+    std::vector<char> sample(std::min(file_size, SAMPLE_BYTES));
+    in.read(sample.data(), sample.size());
+
+    // Only count complete records of the sample
+    std::size_t records = 0, header_bytes = 0, last_newline = 0;
+    for (std::size_t i = 0; i != sample.size(); ++i) {
+        if (sample[i] != '\n') continue;
+        if (has_header and header_bytes == 0)
+            header_bytes = i + 1;
+        else
+            ++records;
+        last_newline = i + 1;
+    }
+
+    // Sample holds at most one (partial) record, the file is tiny
+    if (records == 0) return file_size == 0 ? 0 : 1;
+
+    const double bytes_per_record = double(last_newline - header_bytes) / records;
+    return std::size_t(double(file_size - header_bytes) / bytes_per_record * SAFETY_MARGIN) + 1;
+}
+
+bool presize(m::Table &table, std::size_t n) {
+    auto &store = table.store();
+    if (auto row_store = dynamic_cast<RowStore *>(&store)) {
+        row_store->reserve(n);
+        return true;
+    }
+    if (auto column_store = dynamic_cast<ColumnStore *>(&store)) {
+        column_store->reserve(n);
+        return true;
+    }
+    if (auto pax_store = dynamic_cast<PaxStore *>(&store)) {
+        pax_store->reserve(n);
+        return true;
+    }
+    return false;
+}
+
+bool drop_null_bitmap(m::Table &table) {
+    auto &store = table.store();
+    if (auto row_store = dynamic_cast<RowStore *>(&store))
+        return row_store->drop_null_bitmap();
+    if (auto column_store = dynamic_cast<ColumnStore *>(&store))
+        return column_store->drop_null_bitmap();
+    return false;
+}
+
+bool save_snapshot(m::Table &table, const char *path) {
+    auto &store = table.store();
+    if (auto row_store = dynamic_cast<RowStore *>(&store))
+        return row_store->save(path);
+    if (auto column_store = dynamic_cast<ColumnStore *>(&store))
+        return column_store->save(path);
+    return false;
+}
+
+bool restore_snapshot(m::Table &table, const char *path) {
+    auto &store = table.store();
+    if (auto row_store = dynamic_cast<RowStore *>(&store))
+        return row_store->restore(path);
+    if (auto column_store = dynamic_cast<ColumnStore *>(&store))
+        return column_store->restore(path);
+    return false;
+}
+
+void load_CSV_presized(m::Diagnostic &diag, m::Table &table, const char *path, bool has_header) {
+    presize(table, table.store().num_rows() + estimate_CSV_rows(path, has_header));
+    m::load_from_CSV(diag, table, path, std::numeric_limits<std::size_t>::max(), has_header, false);
+}
+
+bool load_CSV_parallel(m::Diagnostic &diag, m::Table &table, const char *path, bool has_header, unsigned num_threads,
+                       std::size_t chunk_bytes) {
+    auto row_store = dynamic_cast<RowStore *>(&table.store());
+    auto column_store = dynamic_cast<ColumnStore *>(&table.store());
+    if (not row_store and not column_store) return false;
+    for (const auto &i : table) {
+        Conversion conversion;
+        if (not conversion_for(*i.type, conversion)) return false;
+    }
+
+    MappedFile file(path);
+    if (not file.ok) {
+        diag.err() << "Could not open file " << path << std::endl;
+        return true;
+    }
+    const char *begin = file.data, *end = file.data + file.size;
+
+    // Map the fields of a record to attributes
+    std::vector<std::size_t> attributes;
+    if (has_header) {
+        // The header ends at the first newline outside of quotes, scanned for from its second character on
+        const char *header_end = begin == end ? end : csv::next_record(begin + 1, begin, end, *begin == '"');
+        const char *names_end = header_end;
+        while (names_end != begin and (names_end[-1] == '\n' or names_end[-1] == '\r')) --names_end;
+        std::vector<csv::Field> fields;
+        csv::split_fields(begin, names_end, fields);
+        for (const auto &field : fields) {
+            const std::string name = field.escaped ? csv::unescape(field) : std::string(field.begin, field.end);
+            auto it = std::find_if(table.begin(), table.end(), [&](const auto &i) { return name == i.name; });
+            if (it == table.end()) return false;
+            attributes.push_back(it->id);
+        }
+        begin = header_end;
+    } else {
+        for (const auto &i : table)
+            attributes.push_back(i.id);
+    }
+
+    if (num_threads == 0) num_threads = std::max(1U, std::thread::hardware_concurrency());
+    if (row_store)
+        load_records(diag, table, *row_store, path, begin, end, attributes, num_threads, chunk_bytes);
+    else
+        load_records(diag, table, *column_store, path, begin, end, attributes, num_threads, chunk_bytes);
+    return true;
+}
+
+bool load_CSV_or_snapshot(m::Diagnostic &diag, m::Table &table, const char *path, bool has_header) {
+    if (snapshot::is_snapshot(path))
+        return restore_snapshot(table, path);
+    if (not load_CSV_parallel(diag, table, path, has_header))
+        load_CSV_presized(diag, table, path, has_header);
+    return true;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <mutable/mutable.hpp>
+
+
+/** Estimates the number of records in the CSV file at `path` from the file size and the average length of the
+ * records at its beginning.  Errs on the side of too many rows.  Returns 0 if the file cannot be read. */
+std::size_t estimate_CSV_rows(const char *path, bool has_header);
+
+/** Reserves room for `n` rows in the store of `table`, if it is one of our stores.  Returns true iff it is. */
+bool presize(m::Table &table, std::size_t n);
+
+/** Drops the null bitmap of the store of `table`, if it is one of our stores and no row contains a NULL.  Returns true
+ * iff the store has no null bitmap (anymore). */
+bool drop_null_bitmap(m::Table &table);
+
+/** Writes a snapshot of the store of `table` to `path`, if it is one of our stores that supports snapshots.  Returns
+ * true iff the snapshot was written. */
+bool save_snapshot(m::Table &table, const char *path);
+
+/** Restores the empty store of `table` from the snapshot at `path`, if it is one of our stores that supports snapshots
+ * and the snapshot matches.  Returns true iff the store was restored. */
+bool restore_snapshot(m::Table &table, const char *path);
+
+/** Loads the CSV file at `path` into `table` like `m::load_from_CSV()`, but presizes the store for the estimated
+ * number of records first, so that loading does not reallocate the store over and over. */
+void load_CSV_presized(m::Diagnostic &diag, m::Table &table, const char *path, bool has_header = true);
+
+/** Loads the CSV file at `path` into `table` on `num_threads` threads, or on one thread per core if 0.  The file is
+ * split into ranges of about `chunk_bytes` at record boundaries, the records of all ranges are appended to the store
+ * at once, and every thread parses ranges directly into their rows.  Supports our row and column stores with BOOL,
+ * integer, FLOAT, DOUBLE and CHAR attributes; returns false without loading anything for any other store or
+ * attribute, or if the header names an unknown attribute.  Malformed values are loaded as NULL and reported to
+ * `diag`. */
+bool load_CSV_parallel(m::Diagnostic &diag, m::Table &table, const char *path, bool has_header = true,
+                       unsigned num_threads = 0, std::size_t chunk_bytes = 1UL << 22);
+
+/** Fills `table` from `path`, which is either a snapshot of its store or a CSV file that is loaded with
+ * `load_CSV_parallel()`, or with `load_CSV_presized()` if that does not support the table.  Returns false iff `path` is
+ * a snapshot that does not match the store of `table`. */
+bool load_CSV_or_snapshot(m::Diagnostic &diag, m::Table &table, const char *path, bool has_header = true);
@@ -0,0 +1,116 @@
+#include "Memory.hpp"
+#include "Allocator.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+
+
+std::size_t memory::page_size() {
+    static const std::size_t size = sysconf(_SC_PAGESIZE);
+    return size;
+}
+
+void *memory::reserve(std::size_t bytes) {
+    // Only claim the address space, pages are neither readable nor counted against the commit limit
+    void *addr = mmap(nullptr, bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (addr == MAP_FAILED) throw std::bad_alloc();
+    return addr;
+}
+
+void memory::commit(void *addr, std::size_t bytes) {
+    // Physical pages are only faulted in on first access
+    if (mprotect(addr, bytes, PROT_READ | PROT_WRITE) != 0) throw std::bad_alloc();
+}
+
+void memory::decommit(void *addr, std::size_t bytes) {
+    madvise(addr, bytes, MADV_DONTNEED);
+    mprotect(addr, bytes, PROT_NONE);
+}
+
+void memory::release(void *addr, std::size_t bytes) {
+    munmap(addr, bytes);
+}
+
+void memory::use_huge_pages(void *addr, std::size_t bytes) {
+#ifdef __linux__
+    // Only a hint, the kernel falls back to regular pages if it has no huge pages available
+    madvise(addr, bytes, MADV_HUGEPAGE);
+#else
+    // Transparent huge pages are Linux only, elsewhere the pages stay regular
+    (void) addr;
+    (void) bytes;
+#endif
+}
+
+void *memory::allocate(const AllocationOptions &options, std::size_t bytes) {
+    if (options.allocator) return options.allocator->allocate(bytes, options.alignment);
+    if (options.backend == Backend::Malloc) {
+        void *addr = options.alignment <= alignof(std::max_align_t) ? malloc(bytes)
+                                                                    : aligned_alloc(options.alignment,
+                                                                                    round_up(bytes, options.alignment));
+        if (addr == nullptr) throw std::bad_alloc();
+        return addr;
+    }
+
+    bytes = round_up(bytes, page_size());
+    void *addr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED) throw std::bad_alloc();
+    if (options.huge_pages and bytes >= options.huge_page_threshold) use_huge_pages(addr, bytes);
+    return addr;
+}
+
+void *memory::reallocate(const AllocationOptions &options, void *addr, std::size_t old_bytes, std::size_t new_bytes,
+                         std::size_t *copied_bytes) {
+    if (options.allocator)
+        return options.allocator->reallocate(addr, old_bytes, new_bytes, options.alignment, copied_bytes);
+    if (options.backend == Backend::Malloc) {
+        if (options.alignment > alignof(std::max_align_t)) {
+            // `realloc()` does not preserve the alignment, copy by hand
+            void *new_addr = allocate(options, new_bytes);
+            memcpy(new_addr, addr, std::min(old_bytes, new_bytes));
+            free(addr);
+            if (copied_bytes) *copied_bytes += std::min(old_bytes, new_bytes);
+            return new_addr;
+        }
+        const auto old_addr = reinterpret_cast<uintptr_t>(addr);
+        addr = realloc(addr, new_bytes);
+        if (addr == nullptr) throw std::bad_alloc();
+        // A buffer that moved was copied
+        if (copied_bytes and reinterpret_cast<uintptr_t>(addr) != old_addr)
+            *copied_bytes += std::min(old_bytes, new_bytes);
+        return addr;
+    }
+
+    old_bytes = round_up(old_bytes, page_size());
+    new_bytes = round_up(new_bytes, page_size());
+    if (old_bytes == new_bytes) return addr;
+
+#ifdef __linux__
+    // The kernel moves the page table entries, the contents are never copied
+    addr = mremap(addr, old_bytes, new_bytes, MREMAP_MAYMOVE);
+    if (addr == MAP_FAILED) throw std::bad_alloc();
+#else
+    // Without `mremap()`, map the new size and copy the contents over
+    void *new_addr = mmap(nullptr, new_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (new_addr == MAP_FAILED) throw std::bad_alloc();
+    memcpy(new_addr, addr, std::min(old_bytes, new_bytes));
+    munmap(addr, old_bytes);
+    if (copied_bytes) *copied_bytes += std::min(old_bytes, new_bytes);
+    addr = new_addr;
+#endif
+    if (options.huge_pages and new_bytes >= options.huge_page_threshold) use_huge_pages(addr, new_bytes);
+    return addr;
+}
+
+void memory::deallocate(const AllocationOptions &options, void *addr, std::size_t bytes) {
+    if (options.allocator)
+        options.allocator->deallocate(addr, bytes, options.alignment);
+    else if (options.backend == Backend::Malloc)
+        free(addr);
+    else
+        munmap(addr, round_up(bytes, page_size()));
+}
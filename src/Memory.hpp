@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+
+/* Helpers to manage memory directly through the virtual memory system.  Address space is either reserved without any
+ * backing and later committed in pieces, so that memory inside the reservation never has to move, or allocated as one
+ * buffer through one of the allocation backends. */
+namespace memory {
+
+/** Returns the size of a virtual memory page in bytes. */
+std::size_t page_size();
+
+/** Rounds `bytes` up to the next multiple of `alignment`, which must be a power of two. */
+constexpr std::size_t round_up(std::size_t bytes, std::size_t alignment) {
+    return (bytes + alignment - 1) & ~(alignment - 1);
+}
+
+/** Reserves `bytes` of address space without backing it with memory.  Throws `std::bad_alloc` on failure. */
+void *reserve(std::size_t bytes);
+
+/** Makes `bytes` starting at `addr` (inside a reservation) readable and writable. */
+void commit(void *addr, std::size_t bytes);
+
+/** Returns the memory of `bytes` starting at `addr` to the system, but keeps the address space reserved. */
+void decommit(void *addr, std::size_t bytes);
+
+/** Releases a reservation made with `reserve()`. */
+void release(void *addr, std::size_t bytes);
+
+/** Advises the system to back the `bytes` starting at `addr` with transparent huge pages.  Does nothing on systems
+ * other than Linux. */
+void use_huge_pages(void *addr, std::size_t bytes);
+
+
+struct Allocator;
+
+/** Where a store allocates its buffers from. */
+enum class Backend
+{
+    Malloc, ///< `malloc()` and `realloc()`, growing may copy the whole buffer in user space
+    Mmap,   ///< anonymous `mmap()` and, on Linux, `mremap()`: growing remaps the pages instead of copying them
+};
+
+/** Options for allocating a buffer with `allocate()` and `reallocate()`. */
+struct AllocationOptions
+{
+    Backend backend = Backend::Malloc;
+    /** Use transparent huge pages for `Mmap` buffers of at least `huge_page_threshold` bytes. */
+    bool huge_pages = false;
+    std::size_t huge_page_threshold = 1UL << 21;
+    /** Minimum alignment of the buffer in bytes, a power of two.  `Mmap` buffers are always aligned to pages. */
+    std::size_t alignment = alignof(std::max_align_t);
+    /** Allocator to take buffers from instead of the backend, e.g. an `ArenaAllocator` shared by the stores of all
+     * tables of a database, which records statistics of their allocations (`src/Allocator.hpp`). */
+    std::shared_ptr<Allocator> allocator;
+};
+
+/** Allocates a buffer of `bytes`.  Throws `std::bad_alloc` on failure. */
+void *allocate(const AllocationOptions &options, std::size_t bytes);
+
+/** Resizes the buffer at `addr` of `old_bytes` to `new_bytes`, possibly moving it, and returns its new address.  Adds
+ * the number of bytes copied to move the buffer to `*copied_bytes`, if given. */
+void *reallocate(const AllocationOptions &options, void *addr, std::size_t old_bytes, std::size_t new_bytes,
+                 std::size_t *copied_bytes = nullptr);
+
+/** Frees the buffer at `addr` of `bytes`. */
+void deallocate(const AllocationOptions &options, void *addr, std::size_t bytes);
+
+}
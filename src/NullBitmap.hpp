@@ -0,0 +1,52 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+/** Column-major null bitmap of a single attribute: bit `row % 64` of word `row / 64` is set iff the attribute is NULL
+ * in row `row`.  Scans of the attribute read only its own bits, 64 rows per word.  Words past the last NULL are not
+ * stored. */
+struct NullBitmap
+{
+    private:
+    std::vector<uint64_t> words;
+
+    public:
+    /** Returns word `i`, which is 0 if it is not stored. */
+    uint64_t word(std::size_t i) const { return i < words.size() ? words[i] : 0; }
+    std::size_t num_words() const { return words.size(); }
+
+    /** Returns true iff the attribute is NULL in `row`. */
+    bool is_null(std::size_t row) const { return (word(row / 64) >> (row % 64)) & 1u; }
+
+    /** Sets whether the attribute is NULL in `row`. */
+    void set(std::size_t row, bool is_null) {
+        if (row / 64 >= words.size()) {
+            if (not is_null) return;
+            words.resize(row / 64 + 1, 0);
+        }
+        const uint64_t bit = uint64_t(1) << (row % 64);
+        if (is_null)
+            words[row / 64] |= bit;
+        else
+            words[row / 64] &= ~bit;
+    }
+
+    /** Forgets all rows from row `n` on. */
+    void truncate(std::size_t n) {
+        words.resize(std::min(words.size(), (n + 63) / 64));
+        if (n % 64 and n / 64 < words.size()) words[n / 64] &= (uint64_t(1) << (n % 64)) - 1;
+    }
+
+    /** Returns the number of rows in which the attribute is NULL. */
+    std::size_t count() const {
+        std::size_t n = 0;
+        for (auto w : words) n += __builtin_popcountll(w);
+        return n;
+    }
+
+    std::size_t bytes() const { return words.capacity() * sizeof(uint64_t); }
+};
@@ -0,0 +1,112 @@
+#include "PaxStore.hpp"
+
+
+PaxStore::PaxStore(const m::Table &table, const Options &options)
+        : Store(table), options(options) {
+    // One byte per value, rounded up, as in the column store
+    std::size_t row_bytes = 0;
+    for (const auto &i : table) {
+        value_bytes.push_back(ceil((double) i.type->size() / 8));
+        row_bytes += value_bytes.back();
+    }
+    bitmap_bytes = ceil((double) table.size() / 8);
+    row_bytes += bitmap_bytes;
+
+    rows_per_block = std::max<std::size_t>(1, options.block_bytes / row_bytes);
+
+    // Place the minipages with alignment descending, so that every minipage starts properly aligned
+    std::vector<std::size_t> order(table.size());
+    for (std::size_t i = 0; i != order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return table[a].type->alignment() > table[b].type->alignment();
+    });
+
+    minipage_offsets.resize(table.size());
+    std::size_t offset = 0;
+    for (auto i : order) {
+        minipage_offsets[i] = offset;
+        offset += rows_per_block * value_bytes[i];
+    }
+    bitmap_offset = offset;
+
+    // Blocks never get smaller than requested, wider rows just get fewer rows per block.  Every block starts at a
+    // multiple of the largest alignment in bytes, so that the minipages of all blocks stay aligned, not only those of
+    // the first.
+    std::size_t max_alignment = 1;
+    for (const auto &i : table)
+        max_alignment = std::max<std::size_t>(max_alignment, (i.type->alignment() + 7) / 8);
+    block_bytes = memory::round_up(std::max(options.block_bytes, offset + rows_per_block * bitmap_bytes),
+                                   max_alignment);
+
+    // Start with a single block
+    blocks_allocated = 1;
+    address = memory::allocate(options.allocation, block_bytes * blocks_allocated);
+
+    createLin();
+}
+
+PaxStore::~PaxStore() {
+    memory::deallocate(options.allocation, address, block_bytes * blocks_allocated);
+}
+
+std::size_t PaxStore::num_rows() const {
+    return row_count;
+}
+
+void PaxStore::append() {
+    ++row_count;
+
+    // Check if the last allocated block still has room
+    if (row_count < blocks_allocated * rows_per_block) return;
+    // If not allocate 1.5*old_size, but at least one more block
+    grow(blocks_allocated + std::max<std::size_t>(1, blocks_allocated >> 1u));
+}
+
+void PaxStore::drop() {
+    --row_count;
+}
+
+void PaxStore::reserve(std::size_t n) {
+    // Growth happens as soon as the last row is in use, so keep one row more than requested
+    const std::size_t num_blocks = (n + 1 + rows_per_block - 1) / rows_per_block;
+    if (num_blocks > blocks_allocated) grow(num_blocks);
+}
+
+void PaxStore::append(std::size_t n) {
+    reserve(row_count + n);
+    row_count += n;
+}
+
+void PaxStore::dump(std::ostream &out) const {
+    out << "PaxStore with " << row_count << " rows in blocks of " << rows_per_block << " rows ("
+        << block_bytes << " bytes)" << std::endl;
+}
+
+/** Grows the buffer to hold `num_blocks` blocks. */
+void PaxStore::grow(std::size_t num_blocks) {
+    address = memory::reallocate(options.allocation, address, block_bytes * blocks_allocated,
+                                 block_bytes * num_blocks);
+    blocks_allocated = num_blocks;
+    createLin();
+}
+
+/** Creates the linearization: an infinite sequence of blocks, each a finite sequence of minipages. */
+void PaxStore::createLin() {
+    auto block = std::make_unique<m::Linearization>(m::Linearization::CreateFinite(table().size() + 1, rows_per_block));
+
+    for (const auto &i : table()) {
+        // Every minipage is a column of the attribute inside the block
+        auto column = std::make_unique<m::Linearization>(m::Linearization::CreateFinite(1, 1));
+        column->add_sequence(0, 0, i);
+        block->add_sequence(minipage_offsets[i.id], value_bytes[i.id], std::move(column));
+    }
+
+    // Finally add the minipage of null bitmaps
+    auto bitmap_column = std::make_unique<m::Linearization>(m::Linearization::CreateFinite(1, 1));
+    bitmap_column->add_null_bitmap(0, 0);
+    block->add_sequence(bitmap_offset, bitmap_bytes, std::move(bitmap_column));
+
+    auto lin = std::make_unique<m::Linearization>(m::Linearization::CreateInfinite(1));
+    lin->add_sequence(uint64_t(reinterpret_cast<uintptr_t>(address)), block_bytes, std::move(block));
+    linearization(std::move(lin));
+}
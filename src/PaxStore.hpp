@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Memory.hpp"
+#include <mutable/mutable.hpp>
+
+
+/** A store in the PAX layout (partition attributes across).  Rows are grouped into fixed-size blocks, and inside a
+ * block the values of each attribute are stored contiguously in a *minipage*, followed by a minipage of null bitmaps.
+ * Scans of few attributes touch few bytes as in a column store, while all attributes of a row share a block as in a
+ * row store. */
+struct PaxStore : m::Store
+{
+    /** Options to configure the block size and how a `PaxStore` allocates its memory. */
+    struct Options
+    {
+        /** Size of a block in bytes, a page by default. */
+        std::size_t block_bytes = 1UL << 12;
+        memory::AllocationOptions allocation;
+    };
+
+    private:
+    void *address;
+    std::size_t row_count = 0;
+    std::size_t blocks_allocated;
+
+    std::size_t block_bytes;
+    std::size_t rows_per_block;
+    std::size_t bitmap_bytes;
+    // Size of a single value of each attribute in bytes, in the order of the table
+    std::vector<std::size_t> value_bytes;
+    // Offset of the minipage of each attribute inside a block in bytes, in the order of the table
+    std::vector<std::size_t> minipage_offsets;
+    std::size_t bitmap_offset;
+
+    Options options;
+
+    public:
+    PaxStore(const m::Table &table) : PaxStore(table, Options()) {}
+    PaxStore(const m::Table &table, const Options &options);
+    ~PaxStore();
+
+    std::size_t num_rows() const override;
+    void append() override;
+    void drop() override;
+
+    /** Makes room for at least `n` rows in total, so that appending up to `n` rows does not allocate. */
+    void reserve(std::size_t n);
+    /** Appends `n` rows at once. */
+    void append(std::size_t n);
+
+    /** Returns the number of rows stored in one block. */
+    std::size_t block_size() const { return rows_per_block; }
+
+    void accept(m::StoreVisitor &v) override { v(*this); }
+    void accept(m::ConstStoreVisitor &v) const override { v(*this); }
+
+    void dump(std::ostream &out) const override;
+    using Store::dump;
+
+    private:
+    void grow(std::size_t num_blocks);
+    void createLin();
+
+};
@@ -0,0 +1,268 @@
+#include "Predicate.hpp"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+using namespace predicate;
+
+
+namespace {
+
+/** Evaluates the comparison `Op` of a single value. */
+template<Comparison Op, typename T>
+bool evaluate(T v, T lo, T hi) {
+    switch (Op) {
+        case Comparison::Equal:        return v == lo;
+        case Comparison::NotEqual:     return v != lo;
+        case Comparison::Less:         return v < lo;
+        case Comparison::LessEqual:    return v <= lo;
+        case Comparison::Greater:      return v > lo;
+        case Comparison::GreaterEqual: return v >= lo;
+        case Comparison::Between:      return lo <= v and v <= hi;
+    }
+    return false;
+}
+
+#ifdef __AVX2__
+
+/** Compresses the 32 bit mask of `_mm256_movemask_epi8()` on 16 bit lanes to one bit per lane. */
+uint32_t compress_pairs(uint32_t m) {
+    m &= 0x55555555u;
+    m = (m | m >> 1) & 0x33333333u;
+    m = (m | m >> 2) & 0x0F0F0F0Fu;
+    m = (m | m >> 4) & 0x00FF00FFu;
+    return (m | m >> 8) & 0x0000FFFFu;
+}
+
+/** An AVX2 register of `N` values of type `T`, with masks of the lanes where `a = b`, `a > b` and `a >= b`. */
+template<typename T> struct Lanes;
+
+template<> struct Lanes<int8_t>
+{
+    static constexpr std::size_t N = 32;
+    using reg = __m256i;
+    static reg load(const int8_t *p) { return _mm256_load_si256(reinterpret_cast<const __m256i *>(p)); }
+    static reg broadcast(int8_t v) { return _mm256_set1_epi8(v); }
+    static uint32_t eq(reg a, reg b) { return _mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)); }
+    static uint32_t gt(reg a, reg b) { return _mm256_movemask_epi8(_mm256_cmpgt_epi8(a, b)); }
+    static uint32_t ge(reg a, reg b) { return ~gt(b, a); }
+};
+
+template<> struct Lanes<int16_t>
+{
+    static constexpr std::size_t N = 16;
+    using reg = __m256i;
+    static reg load(const int16_t *p) { return _mm256_load_si256(reinterpret_cast<const __m256i *>(p)); }
+    static reg broadcast(int16_t v) { return _mm256_set1_epi16(v); }
+    static uint32_t eq(reg a, reg b) { return compress_pairs(_mm256_movemask_epi8(_mm256_cmpeq_epi16(a, b))); }
+    static uint32_t gt(reg a, reg b) { return compress_pairs(_mm256_movemask_epi8(_mm256_cmpgt_epi16(a, b))); }
+    static uint32_t ge(reg a, reg b) { return ~gt(b, a) & 0xFFFFu; }
+};
+
+template<> struct Lanes<int32_t>
+{
+    static constexpr std::size_t N = 8;
+    using reg = __m256i;
+    static reg load(const int32_t *p) { return _mm256_load_si256(reinterpret_cast<const __m256i *>(p)); }
+    static reg broadcast(int32_t v) { return _mm256_set1_epi32(v); }
+    static uint32_t eq(reg a, reg b) { return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b))); }
+    static uint32_t gt(reg a, reg b) { return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(a, b))); }
+    static uint32_t ge(reg a, reg b) { return ~gt(b, a) & 0xFFu; }
+};
+
+template<> struct Lanes<int64_t>
+{
+    static constexpr std::size_t N = 4;
+    using reg = __m256i;
+    static reg load(const int64_t *p) { return _mm256_load_si256(reinterpret_cast<const __m256i *>(p)); }
+    static reg broadcast(int64_t v) { return _mm256_set1_epi64x(v); }
+    static uint32_t eq(reg a, reg b) { return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(a, b))); }
+    static uint32_t gt(reg a, reg b) { return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(a, b))); }
+    static uint32_t ge(reg a, reg b) { return ~gt(b, a) & 0xFu; }
+};
+
+template<> struct Lanes<float>
+{
+    static constexpr std::size_t N = 8;
+    using reg = __m256;
+    static reg load(const float *p) { return _mm256_load_ps(p); }
+    static reg broadcast(float v) { return _mm256_set1_ps(v); }
+    static uint32_t eq(reg a, reg b) { return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_EQ_OQ)); }
+    static uint32_t gt(reg a, reg b) { return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_GT_OQ)); }
+    static uint32_t ge(reg a, reg b) { return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_GE_OQ)); }
+};
+
+template<> struct Lanes<double>
+{
+    static constexpr std::size_t N = 4;
+    using reg = __m256d;
+    static reg load(const double *p) { return _mm256_load_pd(p); }
+    static reg broadcast(double v) { return _mm256_set1_pd(v); }
+    static uint32_t eq(reg a, reg b) { return _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_EQ_OQ)); }
+    static uint32_t gt(reg a, reg b) { return _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_GT_OQ)); }
+    static uint32_t ge(reg a, reg b) { return _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_GE_OQ)); }
+};
+
+/** Returns the mask of the lanes of `v` that satisfy the comparison `Op`. */
+template<Comparison Op, typename L>
+uint64_t lane_mask(typename L::reg v, typename L::reg lo, typename L::reg hi) {
+    constexpr uint64_t ALL = (uint64_t(1) << L::N) - 1;
+    switch (Op) {
+        case Comparison::Equal:        return L::eq(v, lo);
+        case Comparison::NotEqual:     return ~uint64_t(L::eq(v, lo)) & ALL;
+        case Comparison::Less:         return L::gt(lo, v);
+        case Comparison::LessEqual:    return L::ge(lo, v);
+        case Comparison::Greater:      return L::gt(v, lo);
+        case Comparison::GreaterEqual: return L::ge(v, lo);
+        case Comparison::Between:      return L::ge(v, lo) & L::ge(hi, v);
+    }
+    return 0;
+}
+
+#endif
+
+/** Compares the values 64 at a time, a register at a time with AVX2, and writes a word of bits for every 64. */
+template<Comparison Op, typename T>
+void compare_words(const T *values, std::size_t n, T lo, T hi, uint64_t *out) {
+#ifdef __AVX2__
+    using L = Lanes<T>;
+    const auto vlo = L::broadcast(lo);
+    const auto vhi = L::broadcast(hi);
+    for (std::size_t first = 0; first < n; first += 64) {
+        // The last register may reach past the last value, into the padding
+        const std::size_t end = std::min<std::size_t>(64, n - first);
+        uint64_t word = 0;
+        for (std::size_t lane = 0; lane < end; lane += L::N)
+            word |= lane_mask<Op, L>(L::load(values + first + lane), vlo, vhi) << lane;
+        if (end != 64) word &= (uint64_t(1) << end) - 1;
+        out[first / 64] = word;
+    }
+#else
+    for (std::size_t first = 0; first < n; first += 64) {
+        const std::size_t end = std::min<std::size_t>(64, n - first);
+        uint64_t word = 0;
+        for (std::size_t i = 0; i != end; ++i)
+            word |= uint64_t(evaluate<Op>(values[first + i], lo, hi)) << i;
+        out[first / 64] = word;
+    }
+#endif
+}
+
+}
+
+template<typename T>
+void predicate::compare(const T *values, std::size_t n, Comparison op, T lo, T hi, uint64_t *out) {
+    // Dispatch once, so that the inner loops compare without branching on `op`
+    switch (op) {
+        case Comparison::Equal:        return compare_words<Comparison::Equal>(values, n, lo, hi, out);
+        case Comparison::NotEqual:     return compare_words<Comparison::NotEqual>(values, n, lo, hi, out);
+        case Comparison::Less:         return compare_words<Comparison::Less>(values, n, lo, hi, out);
+        case Comparison::LessEqual:    return compare_words<Comparison::LessEqual>(values, n, lo, hi, out);
+        case Comparison::Greater:      return compare_words<Comparison::Greater>(values, n, lo, hi, out);
+        case Comparison::GreaterEqual: return compare_words<Comparison::GreaterEqual>(values, n, lo, hi, out);
+        case Comparison::Between:      return compare_words<Comparison::Between>(values, n, lo, hi, out);
+    }
+}
+
+template void predicate::compare(const int8_t *, std::size_t, Comparison, int8_t, int8_t, uint64_t *);
+template void predicate::compare(const int16_t *, std::size_t, Comparison, int16_t, int16_t, uint64_t *);
+template void predicate::compare(const int32_t *, std::size_t, Comparison, int32_t, int32_t, uint64_t *);
+template void predicate::compare(const int64_t *, std::size_t, Comparison, int64_t, int64_t, uint64_t *);
+template void predicate::compare(const float *, std::size_t, Comparison, float, float, uint64_t *);
+template void predicate::compare(const double *, std::size_t, Comparison, double, double, uint64_t *);
+
+namespace {
+
+/** Compares integers of type `T` with constants of any range, by turning the comparison into one on the range of
+ * `T`. */
+template<typename T>
+void compare_clamped(const T *values, std::size_t n, Comparison op, int64_t lo, int64_t hi, uint64_t *out) {
+    constexpr int64_t MIN = std::numeric_limits<T>::min();
+    constexpr int64_t MAX = std::numeric_limits<T>::max();
+    const std::size_t num_words = (n + 63) / 64;
+    auto none = [&]() { std::fill(out, out + num_words, 0); };
+
+    if (op == Comparison::NotEqual) {
+        if (lo < MIN or lo > MAX)
+            return compare<T>(values, n, Comparison::GreaterEqual, MIN, MIN, out); // every value
+        return compare<T>(values, n, op, lo, lo, out);
+    }
+
+    // Every other comparison selects the values in [a, b]
+    int64_t a = std::numeric_limits<int64_t>::min(), b = std::numeric_limits<int64_t>::max();
+    switch (op) {
+        case Comparison::Equal:        a = b = lo; break;
+        case Comparison::Less:         if (lo == a) return none(); b = lo - 1; break;
+        case Comparison::LessEqual:    b = lo; break;
+        case Comparison::Greater:      if (lo == b) return none(); a = lo + 1; break;
+        case Comparison::GreaterEqual: a = lo; break;
+        case Comparison::Between:      a = lo; b = hi; break;
+        case Comparison::NotEqual:     break;
+    }
+    a = std::max(a, MIN);
+    b = std::min(b, MAX);
+    if (a > b) return none();
+
+    if (a == b) return compare<T>(values, n, Comparison::Equal, a, a, out);
+    if (a == MIN) return compare<T>(values, n, Comparison::LessEqual, b, b, out);
+    if (b == MAX) return compare<T>(values, n, Comparison::GreaterEqual, a, a, out);
+    compare<T>(values, n, Comparison::Between, a, b, out);
+}
+
+}
+
+void predicate::compare_integers(const void *values, std::size_t value_bytes, std::size_t n, Comparison op, int64_t lo,
+                                 int64_t hi, uint64_t *out) {
+    switch (value_bytes) {
+        case 1: return compare_clamped(reinterpret_cast<const int8_t *>(values), n, op, lo, hi, out);
+        case 2: return compare_clamped(reinterpret_cast<const int16_t *>(values), n, op, lo, hi, out);
+        case 4: return compare_clamped(reinterpret_cast<const int32_t *>(values), n, op, lo, hi, out);
+        default: return compare_clamped(reinterpret_cast<const int64_t *>(values), n, op, lo, hi, out);
+    }
+}
+
+void predicate::compare_chars(const char *values, std::size_t length, std::size_t n, Comparison op, const char *lo,
+                              const char *hi, uint64_t *out) {
+    std::fill(out, out + (n + 63) / 64, 0);
+
+    if (op == Comparison::Equal or op == Comparison::NotEqual) {
+        // A value equals `lo` iff their bytes up to and including the NUL of `lo` match, or all `length` bytes do
+        const std::size_t k = std::min(strlen(lo) + 1, length);
+        const uint64_t flip = op == Comparison::NotEqual;
+#ifdef __AVX2__
+        if (k <= 32) {
+            char pattern[32] = {};
+            memcpy(pattern, lo, std::min(strlen(lo), k));
+            const __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pattern));
+            const uint32_t relevant = k == 32 ? ~uint32_t(0) : (uint32_t(1) << k) - 1;
+            for (std::size_t i = 0; i != n; ++i) {
+                const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + i * length));
+                const uint32_t equal = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, p));
+                out[i / 64] |= (uint64_t((equal & relevant) == relevant) ^ flip) << (i % 64);
+            }
+            return;
+        }
+#endif
+        for (std::size_t i = 0; i != n; ++i)
+            out[i / 64] |= (uint64_t(memcmp(values + i * length, lo, k) == 0) ^ flip) << (i % 64);
+        return;
+    }
+
+    for (std::size_t i = 0; i != n; ++i) {
+        const int c = strncmp(values + i * length, lo, length);
+        bool result = false;
+        switch (op) {
+            case Comparison::Less:         result = c < 0; break;
+            case Comparison::LessEqual:    result = c <= 0; break;
+            case Comparison::Greater:      result = c > 0; break;
+            case Comparison::GreaterEqual: result = c >= 0; break;
+            case Comparison::Between:      result = c >= 0 and strncmp(values + i * length, hi, length) <= 0; break;
+            default: break;
+        }
+        out[i / 64] |= uint64_t(result) << (i % 64);
+    }
+}
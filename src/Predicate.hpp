@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+
+/* Kernels that compare the values of a column with constants.  They write one bit per value to `out`, bit `i % 64` of
+ * word `i / 64` for value `i`, and clear the bits past the last value in its word.  With AVX2, one instruction compares
+ * a whole register of values; `values` must then be aligned to 32 bytes and readable 32 bytes past the last value, as
+ * the columns of a `ColumnStore` are.  Without AVX2, scalar loops do the same. */
+namespace predicate {
+
+/** Comparison of a value `v` with the constants `lo` and `hi`. */
+enum class Comparison
+{
+    Equal,        ///< v = lo
+    NotEqual,     ///< v <> lo
+    Less,         ///< v < lo
+    LessEqual,    ///< v <= lo
+    Greater,      ///< v > lo
+    GreaterEqual, ///< v >= lo
+    Between,      ///< lo <= v <= hi
+};
+
+/** Compares the `n` values at `values` with `lo` and `hi`.  Instantiated for all signed integers, `float` and
+ * `double`. */
+template<typename T>
+void compare(const T *values, std::size_t n, Comparison op, T lo, T hi, uint64_t *out);
+
+/** Compares the `n` signed integers of `value_bytes` each at `values` with `lo` and `hi`, which may lie outside the
+ * range of the values. */
+void compare_integers(const void *values, std::size_t value_bytes, std::size_t n, Comparison op, int64_t lo,
+                      int64_t hi, uint64_t *out);
+
+/** Compares the `n` character sequences of `length` bytes each at `values`, terminated by NUL unless they take all
+ * `length` bytes, with the strings `lo` and `hi` like `strncmp()`.  Only (in)equality is vectorized, for `length` up
+ * to 32, and then needs 32 readable bytes past the start of the last value. */
+void compare_chars(const char *values, std::size_t length, std::size_t n, Comparison op, const char *lo,
+                   const char *hi, uint64_t *out);
+
+}
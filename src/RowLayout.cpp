@@ -0,0 +1,147 @@
+#include "RowLayout.hpp"
+#include <algorithm>
+
+
+namespace {
+
+// Marks the null bitmap in a list of attribute ids
+constexpr std::size_t NULL_BITMAP = std::numeric_limits<std::size_t>::max();
+
+/** An attribute or the null bitmap to place in a row, sizes in bits. */
+struct Item
+{
+    std::size_t id;
+    std::size_t size;
+    std::size_t alignment;
+};
+
+std::size_t align(std::size_t offset, std::size_t alignment) {
+    return alignment <= 1 ? offset : (offset + alignment - 1) / alignment * alignment;
+}
+
+/** Returns the distinct alignments of `items`, descending. */
+std::vector<std::size_t> alignments(const std::vector<Item> &items) {
+    std::vector<std::size_t> result;
+    for (const auto &i : items) result.push_back(i.alignment);
+    std::sort(result.begin(), result.end(), std::greater<>());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+/** Places all items with the alignments in the order of `classes` after `offset` and returns the end offset.  Appends
+ * pairs of id and offset of the placed items to `placed`, if given. */
+std::size_t place(const std::vector<Item> &items, const std::vector<std::size_t> &classes, std::size_t offset,
+                  std::vector<std::pair<std::size_t, std::size_t>> *placed) {
+    for (auto alignment : classes) {
+        for (const auto &i : items) {
+            if (i.alignment != alignment) continue;
+            offset = align(offset, i.alignment);
+            if (placed) placed->emplace_back(i.id, offset);
+            offset += i.size;
+        }
+    }
+    return offset;
+}
+
+}
+
+std::size_t RowLayout::padding_bits(const m::Table &table) const {
+    std::size_t used = has_null_bitmap ? table.size() : 0;
+    for (auto id : order) used += table[id].type->size();
+    return stride_bytes * 8 - used;
+}
+
+bool RowLayout::contains(std::size_t id) const {
+    return std::find(order.begin(), order.end(), id) != order.end();
+}
+
+std::size_t RowLayout::offset_of(std::size_t id) const {
+    auto it = std::find(order.begin(), order.end(), id);
+    return offsets[it - order.begin()];
+}
+
+RowLayout plan_row_layout(const m::Table &table, const RowLayoutOptions &options) {
+    // Split attributes into those placed first and the rest, the null bitmap is never hot
+    std::vector<Item> hot, cold;
+    std::size_t max_alignment = 1;
+    for (const auto &i : table) {
+        if (std::find(options.excluded_attributes.begin(), options.excluded_attributes.end(), i.name) !=
+            options.excluded_attributes.end())
+            continue;
+        const bool is_hot = std::find(options.hot_attributes.begin(), options.hot_attributes.end(), i.name) !=
+                            options.hot_attributes.end();
+        (is_hot ? hot : cold).push_back({i.id, i.type->size(), i.type->alignment()});
+        max_alignment = std::max<std::size_t>(max_alignment, i.type->alignment());
+    }
+    const Item bitmap{NULL_BITMAP, table.size(), 1};
+
+    auto hot_classes = alignments(hot);
+    auto cold_classes = alignments(cold);
+
+    if (options.policy == LayoutPolicy::MinimalPadding) {
+        // Try all orders of alignment classes, there are only a handful of them.  Within a class the order does not
+        // matter.  Start with alignment descending, so that it is kept unless another order is strictly better.
+        if (options.null_bitmap) {
+            cold.push_back(bitmap);
+            cold_classes = alignments(cold);
+        }
+
+        std::size_t best_end = std::numeric_limits<std::size_t>::max();
+        auto best_hot = hot_classes, best_cold = cold_classes;
+        do {
+            const auto hot_end = place(hot, hot_classes, 0, nullptr);
+            do {
+                const auto end = align(place(cold, cold_classes, hot_end, nullptr), max_alignment);
+                if (end < best_end) {
+                    best_end = end;
+                    best_hot = hot_classes;
+                    best_cold = cold_classes;
+                }
+            } while (std::prev_permutation(cold_classes.begin(), cold_classes.end()));
+        } while (std::prev_permutation(hot_classes.begin(), hot_classes.end()));
+        hot_classes = best_hot;
+        cold_classes = best_cold;
+    }
+
+    std::vector<std::pair<std::size_t, std::size_t>> placed;
+    auto end = place(cold, cold_classes, place(hot, hot_classes, 0, &placed), &placed);
+
+    RowLayout layout;
+    layout.has_null_bitmap = options.null_bitmap;
+    for (const auto &[id, offset] : placed) {
+        if (id == NULL_BITMAP) {
+            layout.bitmap_offset = offset;
+        } else {
+            layout.order.push_back(id);
+            layout.offsets.push_back(offset);
+        }
+    }
+    if (options.null_bitmap and options.policy != LayoutPolicy::MinimalPadding) {
+        // Null bitmap last
+        layout.bitmap_offset = end;
+        end += bitmap.size;
+    }
+
+    // Pad the row to the largest alignment, so that every row is aligned
+    const std::size_t row_bytes = (end + 7) / 8;
+    const std::size_t alignment_bytes = std::max<std::size_t>(1, max_alignment / 8);
+    layout.stride_bytes = align(row_bytes, alignment_bytes);
+    layout.alignment_bytes = alignment_bytes;
+
+    // Rows whose stride divides the cache line, or is a multiple of it, never cross a cache line once the first row
+    // starts at one.  Short rows still share a line with their neighbours.
+    if (options.max_cache_line_padding != 0) {
+        std::size_t padded = RowLayout::CACHE_LINE_BYTES;
+        if (layout.stride_bytes > RowLayout::CACHE_LINE_BYTES)
+            padded = align(layout.stride_bytes, RowLayout::CACHE_LINE_BYTES);
+        else
+            while (padded / 2 >= layout.stride_bytes) padded /= 2;
+
+        if (padded - layout.stride_bytes <= options.max_cache_line_padding) {
+            layout.stride_bytes = padded;
+            layout.alignment_bytes = RowLayout::CACHE_LINE_BYTES;
+        }
+    }
+
+    return layout;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <mutable/mutable.hpp>
+#include <string>
+#include <vector>
+
+
+/** How `plan_row_layout()` orders the attributes inside a row. */
+enum class LayoutPolicy
+{
+    Alignment,      ///< attributes with alignment descending, null bitmap last
+    MinimalPadding, ///< search for the order with the least padding, null bitmap wherever it fits best
+};
+
+/** Options for planning the layout of a row. */
+struct RowLayoutOptions
+{
+    LayoutPolicy policy = LayoutPolicy::Alignment;
+    /** Names of attributes to place first in the row, e.g. those that appear together in predicates. */
+    std::vector<std::string> hot_attributes;
+    /** Names of attributes not placed in the row at all, e.g. because they are stored in another row group. */
+    std::vector<std::string> excluded_attributes;
+    /** Bytes of padding per row spent at most to keep rows from crossing cache lines. */
+    std::size_t max_cache_line_padding = 0;
+    /** Reserve a null bitmap in the row.  Without it, no attribute of the table may ever be NULL. */
+    bool null_bitmap = true;
+};
+
+/** The placement of the attributes and the null bitmap inside a row. */
+struct RowLayout
+{
+    static constexpr std::size_t CACHE_LINE_BYTES = 64;
+
+    /** Ids of the attributes, in the order they are placed. */
+    std::vector<std::size_t> order;
+    /** Offset of each attribute in bits, indexed like `order`. */
+    std::vector<std::size_t> offsets;
+    /** Whether the row has a null bitmap, and its offset in bits. */
+    bool has_null_bitmap = true;
+    std::size_t bitmap_offset = 0;
+    /** Distance between two rows in bytes. */
+    std::size_t stride_bytes = 0;
+    /** Alignment the first row must have in bytes, for rows to stay within cache lines. */
+    std::size_t alignment_bytes = 1;
+
+    /** Returns the bits of a row that hold neither an attribute nor the null bitmap. */
+    std::size_t padding_bits(const m::Table &table) const;
+
+    /** Returns true iff the attribute with id `id` is placed in the row. */
+    bool contains(std::size_t id) const;
+
+    /** Returns the offset of the attribute with id `id` in bits. */
+    std::size_t offset_of(std::size_t id) const;
+};
+
+/** Plans the layout of a row of `table`. */
+RowLayout plan_row_layout(const m::Table &table, const RowLayoutOptions &options);
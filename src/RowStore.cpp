@@ -1,81 +1,148 @@
 #include "RowStore.hpp"
+#include "Bits.hpp"
+#include "Memory.hpp"
+#include <algorithm>
 #include <cstdlib>
+#include <stdexcept>
 
 using namespace rewire;
 
-// Custom compare method to make sure only to compare the first item in the tuple
-bool alignCompare(const std::tuple<size_t, size_t> &a, const std::tuple<size_t, size_t> &b) {
-    return std::get<0>(a) > std::get<0>(b);
-}
-
-RowStore::RowStore(const m::Table &table)
-        : Store(table) {
+RowStore::RowStore(const m::Table &table, const Options &options)
+        : Store(table), options(options), access_counts(table.size(), 0) {
     /* 1.2.1: Allocate memory. */
-    std::size_t numAttributes = table.size();  //amount of attributes
-    std::size_t current_offset = 0;
-    size_t current_biggest_align = 0;
-
     //Set first buffer to size of 10 rows
     storable_in_buffer = 10;
+    previous_buffer_size = storable_in_buffer;
 
-    size_t index_counter = 0;
-    // Check each attribute in table
-    for (const auto &i : table) {
-        // Attribute size added to current offset in bits
-        current_offset += i.type->size();
-
-        // Save a tuple containing the alignment size and index
-        toSort.push_back(std::make_tuple(i.type->alignment(), index_counter++));
-
-        // Save the largest attribute alignment
-        if (i.type->alignment() > current_biggest_align)
-            current_biggest_align = i.type->alignment();
+    // Place the attributes and the null bitmap inside the rows of each group
+    for (const auto &layout : plan_groups()) {
+        groups.emplace_back();
+        groups.back().layout = layout;
     }
 
-    // Sort attributes with alignment descending
-    std::sort(toSort.begin(), toSort.end(), alignCompare);
+    if (options.chunked) {
+        // The blocks of all groups hold the same rows, together they take about `block_bytes`
+        std::size_t stride_bytes = 0;
+        for (const auto &g : groups) stride_bytes += g.layout.stride_bytes;
+        rows_per_block = std::max<std::size_t>(1, options.block_bytes / stride_bytes);
+        num_blocks = 1;
+        storable_in_buffer = rows_per_block;
+    }
+    allocate(groups);
+    reset_zone_maps();
 
-    // Total size of a row consisting of the sum of each attributes size and the no. of attributes
-    size_t row_total_bits = current_offset + numAttributes;
-    // Ceiled value of the row bits in bytes
-    row_total_bytes = row_total_bits % 8 == 0 ? (row_total_bits / 8) : (row_total_bits / 8) + 1;
+    /* 1.2.2: Create linearization. */
+    createLin();
+}
 
-    // ?changes this to element of first?
-    auto bytes_first_elem = (size_t) ceil((double) current_biggest_align / 8);
-    auto paddRowSize = (bytes_first_elem - (row_total_bytes % bytes_first_elem)) % bytes_first_elem;
-    master_stride_bytes = row_total_bytes + paddRowSize;
+RowStore::~RowStore() {
+    /* 1.2.1: Free allocated memory. */
+    release(groups);
+    for (auto &free : unpublished) free();
+    delete version.load();
+}
 
-    // Allocate memory (just with an initial size)
-    address = malloc(master_stride_bytes * storable_in_buffer);
+/** Plans the layout of the rows of each group: the hot group with the null bitmap, and the cold group if any attribute
+ * is cold. */
+std::vector<RowLayout> RowStore::plan_groups() const {
+    auto hot_options = options.layout;
+    hot_options.excluded_attributes = options.cold_attributes;
+    std::vector<RowLayout> layouts{ plan_row_layout(table(), hot_options) };
+
+    auto cold_options = options.layout;
+    cold_options.null_bitmap = false;
+    for (const auto &i : table()) {
+        if (std::find(options.cold_attributes.begin(), options.cold_attributes.end(), i.name) ==
+            options.cold_attributes.end())
+            cold_options.excluded_attributes.emplace_back(i.name);
+    }
+    auto cold_layout = plan_row_layout(table(), cold_options);
+    if (not cold_layout.order.empty()) layouts.push_back(cold_layout);
 
-    /* 1.2.2: Create linearization. */
-    auto lin = std::make_unique<m::Linearization>(m::Linearization::CreateInfinite(1));
+    return layouts;
+}
 
-    // Create the row and add the correct attribute based on the sorted list
-    auto row = std::make_unique<m::Linearization>(m::Linearization::CreateFinite(numAttributes + 1, 1));
+/** Allocates the buffers of `new_groups` for `storable_in_buffer` rows, in chunked mode for `num_blocks` blocks. */
+void RowStore::allocate(std::vector<RowGroup> &new_groups) {
+    for (auto &g : new_groups) {
+        options.allocation.alignment = std::max(options.allocation.alignment, g.layout.alignment_bytes);
+
+        if (options.chunked) {
+            // Blocks start at page boundaries, so a block can be committed and released on its own
+            g.block_stride_bytes = memory::round_up(rows_per_block * g.layout.stride_bytes, memory::page_size());
+            g.reserved_bytes = std::max(options.max_bytes / g.block_stride_bytes, std::size_t(1)) * g.block_stride_bytes;
+            if (num_blocks * g.block_stride_bytes > g.reserved_bytes) throw std::bad_alloc();
+
+            // Reserve the address space for all blocks up front and commit only the blocks in use
+            g.address = memory::reserve(g.reserved_bytes);
+            if (options.allocation.huge_pages) memory::use_huge_pages(g.address, g.reserved_bytes);
+            memory::commit(g.address, num_blocks * g.block_stride_bytes);
+        } else {
+            // Allocate memory (just with an initial size)
+            g.address = memory::allocate(options.allocation, g.layout.stride_bytes * storable_in_buffer);
+        }
+    }
+}
 
-    size_t offset = 0;
-    for (const auto &i : toSort) {
-        row->add_sequence(offset, 0, table[std::get<1>(i)]);
-        offset += table[std::get<1>(i)].type->size();
+/** Frees the rows of `old_groups`, wherever they live, once no reader can scan them anymore. */
+void RowStore::release(std::vector<RowGroup> &old_groups) {
+    if (mapping) {
+        release_mapping();
+        return;
+    }
+    for (auto &g : old_groups) {
+        if (options.chunked) {
+            free_later([address = g.address, bytes = g.reserved_bytes]() { memory::release(address, bytes); });
+        } else {
+            free_later([allocation = options.allocation, address = g.address,
+                        bytes = g.layout.stride_bytes * storable_in_buffer]() {
+                memory::deallocate(allocation, address, bytes);
+            });
+        }
     }
+}
+
+/** Unmaps the snapshot the rows were restored from, once no reader can scan it anymore. */
+void RowStore::release_mapping() {
+    auto old = std::make_shared<snapshot::Mapping>();
+    std::swap(*old, mapping);
+    free_later([old]() { snapshot::unmap(*old); });
+}
 
-    // Add null bitmap
-    row->add_null_bitmap(offset, 0);
+/** Calls `free` right away, or, if the store has concurrent readers, once the next version is published and no
+ * reader can scan the memory it frees anymore. */
+void RowStore::free_later(std::function<void()> free) {
+    if (options.concurrent_readers)
+        unpublished.push_back(std::move(free));
+    else
+        free();
+}
 
-    // Finalize linearization at allocated memory
-    lin->add_sequence(uint64_t(reinterpret_cast<uintptr_t>(address)), master_stride_bytes, std::move(row));
-    linearization(std::move(lin));
+/** Resizes the buffer at `address` from `old_bytes` to `new_bytes`.  With concurrent readers, the rows are copied to a
+ * new buffer and the old one is freed once no reader can scan it anymore, instead of reallocating it in place. */
+void *RowStore::move_rows(void *address, std::size_t old_bytes, std::size_t new_bytes) {
+    if (not options.concurrent_readers)
+        return memory::reallocate(options.allocation, address, old_bytes, new_bytes, &stats.copied_bytes);
+
+    auto buffer = memory::allocate(options.allocation, new_bytes);
+    memcpy(buffer, address, std::min(old_bytes, new_bytes));
+    stats.copied_bytes += std::min(old_bytes, new_bytes);
+    free_later([allocation = options.allocation, address, old_bytes]() {
+        memory::deallocate(allocation, address, old_bytes);
+    });
+    return buffer;
 }
 
-RowStore::~RowStore() {
-    /* 1.2.1: Free allocated memory. */
-    free((void *) address);
+/** Returns the index of the group in `groups` that holds the attribute with id `id`. */
+std::size_t RowStore::group_of(const std::vector<RowGroup> &groups, std::size_t id) {
+    return std::find_if(groups.begin(), groups.end(), [id](const RowGroup &g) { return g.layout.contains(id); }) -
+           groups.begin();
 }
 
 std::size_t RowStore::num_rows() const {
     /* 1.2.1: Implement */
-    return rows_used;
+    // Writers appending concurrently publish their rows through the watermark only
+    return concurrent ? concurrent->watermark() : rows_used;
 }
 
 //Append another tuple row dynamically
@@ -83,66 +150,571 @@ void RowStore::append() {
     /* 1.2.1: Implement */
     // Increase row size
     rows_used++;
+    // mutable has written the rows before the new one
+    committed.store(rows_used - 1, std::memory_order_release);
+
+    // The previous rows are written now, summarize the block they completed
+    if (rows_used % ZoneMap::BLOCK_ROWS == 1) summarize(rows_used - 1);
 
     // if we have enough storage left in buffer -> all good
     if (rows_used < storable_in_buffer) return;
 
+    if (options.chunked) {
+        // Only commit the next block, rows already stored and the linearization stay untouched
+        grow(storable_in_buffer + rows_per_block);
+        return;
+    }
+
     //if not -> grow buffer size, 1.5*old_size (aka nearly golden ratio)
-    previous_buffer_size = storable_in_buffer;
-    storable_in_buffer = storable_in_buffer + (storable_in_buffer >> 1u);
+    grow(storable_in_buffer + (storable_in_buffer >> 1u));
+}
 
-    // realloc new memory and create a new linearization
-    address = realloc(address, master_stride_bytes * storable_in_buffer);
-    auto lin = std::make_unique<m::Linearization>(m::Linearization::CreateInfinite(1));
+void RowStore::reserve(std::size_t n) {
+    // Growth happens as soon as the last row is in use, so keep one row more than requested
+    if (n >= storable_in_buffer) grow(n + 1);
+}
+
+void RowStore::append(std::size_t n) {
+    commit_rows();
+    summarize(rows_used);
+    reserve(rows_used + n);
+    rows_used += n;
+}
+
+void RowStore::begin_concurrent_appends() {
+    if (not options.chunked) throw std::logic_error("concurrent appends need a chunked RowStore");
+    if (concurrent) throw std::logic_error("concurrent appends have begun already");
+
+    // The rows so far are written, summarize them before writers append behind them
+    summarize(rows_used);
+    std::size_t max_blocks = std::numeric_limits<std::size_t>::max();
+    for (const auto &g : groups) max_blocks = std::min(max_blocks, g.reserved_bytes / g.block_stride_bytes);
+    // Leave room for the spare row `append()` keeps after the last row
+    concurrent = std::make_unique<ConcurrentAppend>(rows_used, max_blocks * rows_per_block - 1, num_blocks);
+}
+
+std::size_t RowStore::claim_rows(std::size_t n) {
+    const auto first = concurrent->claim(n);
+    // Commit the blocks of the claimed rows, unless another writer did so already
+    concurrent->commit_units((first + n + rows_per_block - 1) / rows_per_block, [this](std::size_t block) {
+        for (const auto &g : groups)
+            memory::commit(reinterpret_cast<uint8_t *>(g.address) + block * g.block_stride_bytes, g.block_stride_bytes);
+    });
+    return first;
+}
+
+void RowStore::publish_rows(std::size_t first, std::size_t n) {
+    concurrent->publish(first, n);
+}
 
-    // Create the row and add the correct attribute based on the sorted list
-    auto row = std::make_unique<m::Linearization>(m::Linearization::CreateFinite(this->table().size() + 1, 1));
+void RowStore::end_concurrent_appends() {
+    if (not concurrent) return;
+    if (concurrent->watermark() != concurrent->claimed_rows())
+        throw std::logic_error("not all claimed rows are published");
+
+    num_blocks = concurrent->committed_units();
+    storable_in_buffer = num_blocks * rows_per_block;
+    rows_used = concurrent->watermark();
+    concurrent.reset();
+    commit_rows();
+    // Commit the spare row after the last row
+    reserve(rows_used);
+    summarize(rows_used);
+}
 
-    size_t offset = 0;
-    for (const auto &i : toSort) {
-        row->add_sequence(offset, 0, this->table()[std::get<1>(i)]);
-        offset += this->table()[std::get<1>(i)].type->size();
+/** Grows the buffers of all groups to hold at least `capacity` rows. */
+void RowStore::grow(std::size_t capacity) {
+    if (options.chunked) {
+        // Commit the next block of every group until `capacity` rows fit
+        while (storable_in_buffer < capacity) {
+            for (const auto &g : groups)
+                if ((num_blocks + 1) * g.block_stride_bytes > g.reserved_bytes) throw std::bad_alloc();
+            for (const auto &g : groups)
+                memory::commit(reinterpret_cast<uint8_t *>(g.address) + num_blocks * g.block_stride_bytes,
+                               g.block_stride_bytes);
+            ++num_blocks;
+            storable_in_buffer += rows_per_block;
+        }
+        return;
     }
 
-    // Add null bitmap
-    row->add_null_bitmap(offset, 0);
+    own_buffers();
+    previous_buffer_size = storable_in_buffer;
+    storable_in_buffer = capacity;
+
+    // realloc new memory and create a new linearization
+    for (auto &g : groups)
+        g.address = move_rows(g.address, g.layout.stride_bytes * previous_buffer_size,
+                              g.layout.stride_bytes * storable_in_buffer);
+    ++stats.grow_reallocations;
+    createLin();
+}
+
+/** Moves rows restored from a snapshot out of the mapped file, to memory of our own. */
+void RowStore::own_buffers() {
+    if (not mapping) return;
 
-    lin->add_sequence(uint64_t(reinterpret_cast<uintptr_t>(address)), master_stride_bytes, std::move(row));
-    linearization(std::move(lin));
+    for (auto &g : groups) {
+        const auto bytes = g.layout.stride_bytes * storable_in_buffer;
+        auto buffer = memory::allocate(options.allocation, bytes);
+        memcpy(buffer, g.address, bytes);
+        g.address = buffer;
+        stats.copied_bytes += bytes;
+    }
+    release_mapping();
 }
 
 void RowStore::drop() {
     /* 1.2.1: Implement */
     rows_used--;
+    committed.store(std::min(committed.load(), rows_used), std::memory_order_release);
+    dead_rows.forget(rows_used);
+    for (auto &z : zone_maps)
+        if (z) z->truncate(rows_used);
+
+    if (options.chunked) {
+        // Keep one empty block as spare, so alternating appends and drops at a block boundary do not thrash
+        if (num_blocks < 3 or rows_used > (num_blocks - 2) * rows_per_block) return;
+
+        --num_blocks;
+        for (const auto &g : groups)
+            memory::decommit(reinterpret_cast<uint8_t *>(g.address) + num_blocks * g.block_stride_bytes,
+                             g.block_stride_bytes);
+        storable_in_buffer -= rows_per_block;
+        return;
+    }
 
     // if we have enough storage left in buffer -> all good
     if (rows_used > previous_buffer_size) return;
 
-    //if not -> grow buffer size, 1.5*old_size (aka nearly golden ratio)
+    //if not -> shrink buffer size, old_size/1.5 (aka nearly golden ratio)
+    own_buffers();
+    const auto old_size = storable_in_buffer;
     storable_in_buffer = previous_buffer_size;
     previous_buffer_size = ceil(storable_in_buffer / 1.5);
 
     // realloc new memory and create a new linearization
-    address = realloc(address, master_stride_bytes * storable_in_buffer);
-    auto lin = std::make_unique<m::Linearization>(m::Linearization::CreateInfinite(1));
+    for (auto &g : groups)
+        g.address = move_rows(g.address, g.layout.stride_bytes * old_size, g.layout.stride_bytes * storable_in_buffer);
+    ++stats.shrink_reallocations;
+    createLin();
+}
+
+bool RowStore::erase(std::size_t row) {
+    if (row >= rows_used or not dead_rows.mark(row)) return false;
+
+    // Compact a little at a time, so that no single erase pays for compacting the whole store
+    if (dead_rows.size() > options.compaction_threshold * rows_used)
+        compact(options.compaction_step);
+    return true;
+}
 
-    // Create the row and add the correct attribute based on the sorted list
-    auto row = std::make_unique<m::Linearization>(m::Linearization::CreateFinite(this->table().size() + 1, 1));
+std::size_t RowStore::compact(std::size_t budget) {
+    return dead_rows.compact(rows_used, budget, [this](std::size_t from, std::size_t to) {
+        for (std::size_t group = 0; group != groups.size(); ++group)
+            memcpy(row_address(to, group), row_address(from, group), groups[group].layout.stride_bytes);
+        for (auto &z : zone_maps)
+            if (z) z->truncate(to);
+    }, [this]() { drop(); });
+}
 
-    size_t offset = 0;
-    for (const auto &i : toSort) {
-        row->add_sequence(offset, 0, this->table()[std::get<1>(i)]);
-        offset += this->table()[std::get<1>(i)].type->size();
+/** Creates the empty zone maps the options ask for. */
+void RowStore::reset_zone_maps() {
+    zone_maps.clear();
+    for (const auto &i : table()) {
+        const bool is_summarized = std::find(options.zone_map_attributes.begin(), options.zone_map_attributes.end(),
+                                             i.name) != options.zone_map_attributes.end();
+        if (is_summarized and not i.type->is_integral())
+            throw std::invalid_argument("only integer attributes can have a zone map");
+        zone_maps.emplace_back(is_summarized ? std::make_unique<ZoneMap>() : nullptr);
     }
+}
+
+/** Returns the address of the value of attribute `id` in row `row`. */
+const uint8_t *RowStore::value_address(std::size_t row, std::size_t id) const {
+    const auto group = group_of(groups, id);
+    return row_address(row, group) + groups[group].layout.offset_of(id) / 8;
+}
+
+BitAddress RowStore::value_location(std::size_t row, std::size_t id) const {
+    const auto group = group_of(groups, id);
+    return { row_address(row, group), groups[group].layout.offset_of(id) };
+}
+
+BitAddress RowStore::null_location(std::size_t row, std::size_t id) const {
+    const auto &hot = groups.front().layout;
+    if (not hot.has_null_bitmap) return { nullptr, 0 };
+    return { row_address(row), hot.bitmap_offset + id };
+}
 
-    // Add null bitmap
-    row->add_null_bitmap(offset, 0);
+/** Returns true iff attribute `id` of row `row` is NULL. */
+bool RowStore::is_null(std::size_t row, std::size_t id) const {
+    const auto &hot = groups.front().layout;
+    return hot.has_null_bitmap and get_bit(row_address(row), hot.bitmap_offset + id);
+}
 
-    lin->add_sequence(uint64_t(reinterpret_cast<uintptr_t>(address)), master_stride_bytes, std::move(row));
-    linearization(std::move(lin));
+/** Summarizes the blocks completed by the first `written_rows` rows in the zone maps. */
+void RowStore::summarize(std::size_t written_rows) {
+    for (const auto &i : table()) {
+        auto &z = zone_maps[i.id];
+        if (not z) continue;
+
+        const std::size_t value_bytes = i.type->size() / 8;
+        while (z->size() + ZoneMap::BLOCK_ROWS <= written_rows) {
+            ZoneMap::Zone zone;
+            for (std::size_t row = z->size(), end = row + ZoneMap::BLOCK_ROWS; row != end; ++row)
+                zone.add(load_integer(value_address(row, i.id), value_bytes), is_null(row, i.id));
+            z->append(zone);
+        }
+    }
+}
+
+Selection RowStore::select_range(std::size_t id, int64_t lo, int64_t hi, std::size_t *skipped_blocks) {
+    summarize(rows_used);
+
+    const std::size_t value_bytes = table()[id].type->size() / 8;
+    const ZoneMap *z = zone_maps[id].get();
+
+    Selection selection;
+    for (std::size_t first = 0; first < rows_used; first += ZoneMap::BLOCK_ROWS) {
+        const std::size_t block = first / ZoneMap::BLOCK_ROWS;
+        if (z and block < z->num_blocks() and not z->zone(block).overlaps(lo, hi)) {
+            if (skipped_blocks) ++*skipped_blocks;
+            continue;
+        }
+        for (std::size_t row = first, end = std::min(rows_used, first + ZoneMap::BLOCK_ROWS); row != end; ++row) {
+            if (dead_rows.is_dead(row) or is_null(row, id)) continue;
+            const auto value = load_integer(value_address(row, id), value_bytes);
+            if (lo <= value and value <= hi) selection.push_back(row);
+        }
+    }
+    return selection;
+}
+
+uint8_t *RowStore::row_address(std::size_t row, std::size_t group) const {
+    return row_address(groups[group], row, groups[group].layout.stride_bytes);
+}
+
+/** Returns the address of row `row` in `group` for rows of `stride_bytes`. */
+uint8_t *RowStore::row_address(const RowGroup &group, std::size_t row, std::size_t stride_bytes) const {
+    auto base = reinterpret_cast<uint8_t *>(group.address);
+    if (options.chunked)
+        return base + row / rows_per_block * group.block_stride_bytes + row % rows_per_block * stride_bytes;
+    return base + row * stride_bytes;
+}
+
+bool RowStore::drop_null_bitmap() {
+    auto &hot = groups.front();
+    if (not hot.layout.has_null_bitmap) return true;
+
+    // Only possible if no row contains a NULL
+    for (std::size_t row = 0; row != rows_used; ++row)
+        if (any_bit(row_address(row), hot.layout.bitmap_offset, table().size())) return false;
+
+    own_buffers();
+    options.layout.null_bitmap = false;
+    const RowLayout old_layout = hot.layout;
+    hot.layout = plan_groups().front();
+
+    // Rows only get shorter, so moving them front to back in place never overwrites a row not yet moved.  Blocks keep
+    // their number of rows.
+    const std::size_t old_stride_bytes = old_layout.stride_bytes;
+    std::vector<uint8_t> tmp(old_stride_bytes);
+    for (std::size_t row = 0; row != rows_used; ++row) {
+        memcpy(tmp.data(), row_address(hot, row, old_stride_bytes), old_stride_bytes);
+        auto dst = row_address(row);
+        for (auto id : hot.layout.order)
+            copy_bits(dst, hot.layout.offset_of(id), tmp.data(), old_layout.offset_of(id), table()[id].type->size());
+    }
+
+    // Give the memory freed at the end back
+    if (not options.chunked) {
+        hot.address = move_rows(hot.address, old_stride_bytes * storable_in_buffer,
+                                hot.layout.stride_bytes * storable_in_buffer);
+        ++stats.shrink_reallocations;
+    }
+
+    createLin();
+    return true;
+}
+
+bool RowStore::repartition() {
+    // Without any noted access, there is nothing to base the split on
+    const uint64_t max_accesses = *std::max_element(access_counts.begin(), access_counts.end());
+    if (max_accesses == 0) return false;
+
+    // Attributes accessed rarely compared to the most accessed one are cold
+    std::vector<std::string> cold_attributes;
+    for (const auto &i : table())
+        if (access_counts[i.id] <= options.cold_access_ratio * max_accesses) cold_attributes.emplace_back(i.name);
+
+    auto current = options.cold_attributes;
+    std::sort(current.begin(), current.end());
+    auto proposed = cold_attributes;
+    std::sort(proposed.begin(), proposed.end());
+    if (current == proposed) return false;
+
+    // Place the rows of the new groups next to the old ones
+    options.cold_attributes = cold_attributes;
+    std::vector<RowGroup> new_groups;
+    for (const auto &layout : plan_groups()) {
+        new_groups.emplace_back();
+        new_groups.back().layout = layout;
+    }
+    allocate(new_groups);
+
+    // Copy every attribute and the null bitmap from its old to its new group, row by row
+    struct Move { std::size_t from, from_offset, to, to_offset, bits; };
+    std::vector<Move> moves;
+    for (const auto &i : table()) {
+        const auto from = group_of(groups, i.id), to = group_of(new_groups, i.id);
+        moves.push_back({ from, groups[from].layout.offset_of(i.id), to, new_groups[to].layout.offset_of(i.id),
+                          i.type->size() });
+    }
+    if (groups.front().layout.has_null_bitmap)
+        moves.push_back({ 0, groups.front().layout.bitmap_offset, 0, new_groups.front().layout.bitmap_offset,
+                          table().size() });
+
+    for (std::size_t row = 0; row != rows_used; ++row) {
+        for (const auto &m : moves) {
+            const auto &from = groups[m.from], &to = new_groups[m.to];
+            copy_bits(row_address(to, row, to.layout.stride_bytes), m.to_offset,
+                      row_address(from, row, from.layout.stride_bytes), m.from_offset, m.bits);
+        }
+    }
+
+    release(groups);
+    groups = std::move(new_groups);
+
+    createLin();
+    return true;
+}
+
+bool RowStore::save(const char *path) {
+    compact();
+
+    snapshot::Contents contents;
+    contents.kind = snapshot::Kind::Row;
+    contents.num_rows = rows_used;
+    // One row more, since the store grows as soon as its last row is in use
+    contents.capacity = rows_used + 1;
+
+    // Row layout: stride and null bitmap of every group, then group and offset of every attribute in table order
+    contents.layout = { groups.size() };
+    for (const auto &g : groups) {
+        contents.layout.push_back(g.layout.stride_bytes);
+        contents.layout.push_back(g.layout.has_null_bitmap);
+        contents.layout.push_back(g.layout.bitmap_offset);
+    }
+    for (const auto &i : table()) {
+        const auto group = group_of(groups, i.id);
+        contents.layout.push_back(group);
+        contents.layout.push_back(groups[group].layout.offset_of(i.id));
+    }
+
+    // One segment per group, rows are written back to back and blocks of a chunked store are joined
+    std::size_t max_stride_bytes = 0;
+    for (const auto &g : groups) max_stride_bytes = std::max(max_stride_bytes, g.layout.stride_bytes);
+    const std::vector<uint8_t> empty_row(max_stride_bytes, 0);
+
+    std::vector<snapshot::Pieces> segments;
+    for (const auto &g : groups) {
+        const auto stride_bytes = g.layout.stride_bytes;
+        snapshot::Pieces rows;
+        if (options.chunked) {
+            for (std::size_t first = 0; first < rows_used; first += rows_per_block)
+                rows.emplace_back(row_address(g, first, stride_bytes),
+                                  std::min(rows_per_block, rows_used - first) * stride_bytes);
+        } else {
+            rows.emplace_back(g.address, rows_used * stride_bytes);
+        }
+        rows.emplace_back(empty_row.data(), stride_bytes);
+        segments.push_back(std::move(rows));
+    }
+
+    return snapshot::write(path, table(), contents, segments);
+}
+
+bool RowStore::restore(const char *path) {
+    if (rows_used != 0) return false;
+
+    auto restored = snapshot::map(path, table(), snapshot::Kind::Row);
+    if (not restored) return false;
+
+    const auto &contents = restored.contents;
+    const auto &layout = contents.layout;
+    const std::size_t num_restored_groups = layout.empty() ? 0 : layout[0];
+    bool valid = num_restored_groups >= 1 and num_restored_groups <= 2 and
+                 layout.size() == 1 + 3 * num_restored_groups + 2 * table().size() and
+                 restored.segments.size() == num_restored_groups;
+
+    // Adopt the row layout of every group of the snapshot, attributes ordered by their offset
+    std::vector<RowGroup> restored_groups(valid ? num_restored_groups : 0);
+    for (std::size_t idx = 0; idx != restored_groups.size(); ++idx) {
+        auto &g = restored_groups[idx];
+        g.layout.stride_bytes = layout[1 + 3 * idx];
+        g.layout.has_null_bitmap = layout[2 + 3 * idx];
+        g.layout.bitmap_offset = layout[3 + 3 * idx];
+        g.address = restored.segments[idx];
+        // Every value and bit the layout places must lie within the rows of the segment
+        const uint64_t stride_bits = 8 * uint64_t(g.layout.stride_bytes);
+        valid = valid and g.layout.stride_bytes != 0 and g.layout.stride_bytes <= restored.segment_bytes[idx] and
+                contents.capacity == restored.segment_bytes[idx] / g.layout.stride_bytes and
+                restored.segment_bytes[idx] % g.layout.stride_bytes == 0 and
+                (not g.layout.has_null_bitmap or (g.layout.bitmap_offset <= stride_bits and
+                                                  table().size() <= stride_bits - g.layout.bitmap_offset));
+    }
+    const auto attributes = layout.begin() + 1 + 3 * restored_groups.size();
+    std::vector<std::string> cold_attributes;
+    for (const auto &i : table()) {
+        if (not valid) break;
+        const auto group = attributes[2 * i.id];
+        valid = group < restored_groups.size();
+        if (not valid) break;
+        const uint64_t offset = attributes[2 * i.id + 1], stride_bits = 8 * restored_groups[group].layout.stride_bytes;
+        valid = offset <= stride_bits and i.type->size() <= stride_bits - offset;
+        if (not valid) break;
+        restored_groups[group].layout.order.push_back(i.id);
+        if (group != 0) cold_attributes.emplace_back(i.name);
+    }
+    if (not valid) {
+        snapshot::unmap(restored);
+        return false;
+    }
+    for (auto &g : restored_groups) {
+        auto &order = g.layout.order;
+        std::sort(order.begin(), order.end(),
+                  [&](std::size_t a, std::size_t b) { return attributes[2 * a + 1] < attributes[2 * b + 1]; });
+        for (auto id : order) g.layout.offsets.push_back(attributes[2 * id + 1]);
+    }
+
+    // The rows now live in the mapped file, as one contiguous buffer per group
+    release(groups);
+    options.chunked = false;
+    options.layout.null_bitmap = restored_groups.front().layout.has_null_bitmap;
+    options.cold_attributes = cold_attributes;
+    num_blocks = 0;
+
+    groups = std::move(restored_groups);
+    rows_used = contents.num_rows;
+    storable_in_buffer = contents.capacity;
+    previous_buffer_size = storable_in_buffer;
+    mapping = std::move(restored);
+    reset_zone_maps();
+    commit_rows();
+
+    createLin();
+    return true;
+}
+
+StoreStatistics RowStore::statistics() const {
+    StoreStatistics result = stats;
+    result.rows = rows_used;
+    result.live_rows = num_live_rows();
+    result.capacity = storable_in_buffer;
+    for (const auto &g : groups) {
+        result.bytes_per_row += g.layout.stride_bytes;
+        result.allocated_bytes += options.chunked ? num_blocks * g.block_stride_bytes
+                                                  : g.layout.stride_bytes * storable_in_buffer;
+    }
+    // The null bitmap shares the bytes of the hot row with the attributes, count the bytes it touches
+    if (groups.front().layout.has_null_bitmap) {
+        const auto first = groups.front().layout.bitmap_offset;
+        result.null_bitmap_bytes = ((first + table().size() + 7) / 8 - first / 8) * storable_in_buffer;
+    }
+    return result;
 }
 
 void RowStore::dump(std::ostream &out) const {
-    /* TODO 1.2: Print description of this store to `out`. */
-    out << "Some useful data" << std::endl;
+    out << "RowStore of table '" << table().name << "', " << groups.size() << " row group(s)"
+        << (options.chunked ? ", chunked" : "") << (mapping ? ", mapped from a snapshot" : "") << '\n';
+    statistics().print(out);
+}
+
+/** Creates the linearization of a single row, with the attributes placed as planned in `layout`. */
+std::unique_ptr<m::Linearization> RowStore::createRowLin(const RowLayout &layout) const {
+    // Create the row and add the attributes in the planned order
+    const std::size_t num_sequences = layout.order.size() + (layout.has_null_bitmap ? 1 : 0);
+    auto row = std::make_unique<m::Linearization>(m::Linearization::CreateFinite(num_sequences, 1));
+
+    for (std::size_t i = 0; i != layout.order.size(); ++i)
+        row->add_sequence(layout.offsets[i], 0, this->table()[layout.order[i]]);
+
+    // Add null bitmap, unless no attribute can be NULL
+    if (layout.has_null_bitmap)
+        row->add_null_bitmap(layout.bitmap_offset, 0);
+
+    return row;
+}
+
+/** Creates the linearization of the whole store and sets it. */
+void RowStore::createLin() {
+    const auto begin = std::chrono::steady_clock::now();
+    linearization(make_linearization());
+    ++stats.linearizations;
+    stats.linearization_time += std::chrono::steady_clock::now() - begin;
+    publish_version();
+}
+
+std::unique_ptr<m::Linearization> RowStore::make_linearization() const {
+    auto lin = std::make_unique<m::Linearization>(m::Linearization::CreateInfinite(groups.size()));
+
+    for (const auto &g : groups) {
+        const auto address = uint64_t(reinterpret_cast<uintptr_t>(g.address));
+        if (options.chunked) {
+            // Infinite sequence of finite blocks, each holding `rows_per_block` rows
+            auto block = std::make_unique<m::Linearization>(m::Linearization::CreateFinite(1, rows_per_block));
+            block->add_sequence(0, g.layout.stride_bytes, createRowLin(g.layout));
+            lin->add_sequence(address, g.block_stride_bytes, std::move(block));
+        } else {
+            // Finalize linearization at allocated memory
+            lin->add_sequence(address, g.layout.stride_bytes, createRowLin(g.layout));
+        }
+    }
+
+    return lin;
+}
+
+/** Publishes the current row groups to readers, the old version is freed once no reader can reach it anymore. */
+void RowStore::publish_version() {
+    auto old = version.exchange(new Version{ groups, options.chunked ? rows_per_block : 0 });
+    if (not options.concurrent_readers) {
+        delete old;
+        return;
+    }
+
+    // Readers pinned from now on find the new version, so the memory it replaced can be retired only now
+    if (old) epochs.retire([old]() { delete old; });
+    for (auto &free : unpublished)
+        epochs.retire(std::move(free));
+    unpublished.clear();
+}
+
+RowStore::ReadView RowStore::read_view() const {
+    ReadView view(epochs.pin());
+    // Rows committed before the version is read are in that version, which copied them if it moved them
+    view.rows = committed_rows();
+    view.version = version.load(std::memory_order_acquire);
+    return view;
+}
+
+/** Returns the address of row `row` in group `group` of the view. */
+uint8_t *RowStore::ReadView::row_address(std::size_t row, std::size_t group) const {
+    const auto &g = version->groups[group];
+    auto base = reinterpret_cast<uint8_t *>(g.address);
+    const auto rows_per_block = version->rows_per_block;
+    if (rows_per_block)
+        return base + row / rows_per_block * g.block_stride_bytes + row % rows_per_block * g.layout.stride_bytes;
+    return base + row * g.layout.stride_bytes;
+}
+
+BitAddress RowStore::ReadView::value_location(std::size_t row, std::size_t id) const {
+    const auto group = group_of(version->groups, id);
+    return { row_address(row, group), version->groups[group].layout.offset_of(id) };
+}
+
+BitAddress RowStore::ReadView::null_location(std::size_t row, std::size_t id) const {
+    const auto &hot = version->groups.front().layout;
+    if (not hot.has_null_bitmap) return { nullptr, 0 };
+    return { row_address(row, 0), hot.bitmap_offset + id };
 }
@@ -1,34 +1,255 @@
 #pragma once
 
+#include "Bits.hpp"
+#include "ConcurrentAppend.hpp"
+#include "Epoch.hpp"
+#include "Memory.hpp"
+#include "RowLayout.hpp"
+#include "Snapshot.hpp"
+#include "StoreStatistics.hpp"
+#include "Selection.hpp"
+#include "Tombstones.hpp"
+#include "ZoneMap.hpp"
 #include <mutable/mutable.hpp>
+#include <atomic>
+#include <functional>
+#include <limits>
 #include <mutable/util/memory.hpp>
+#include <string>
+#include <vector>
 
 struct RowStore : m::Store
 {
+    /** Options to configure the layout of rows and how a `RowStore` allocates and grows its memory. */
+    struct Options
+    {
+        /** Placement of the attributes inside a row. */
+        RowLayoutOptions layout;
+        /** Backend of the row buffer, unless `chunked`. */
+        memory::AllocationOptions allocation;
+        /** Let readers take `read_view()`s while a writer appends: growing copies the rows into a new buffer and frees
+         * the old one once no view can scan it anymore, instead of reallocating the buffer in place. */
+        bool concurrent_readers = false;
+        /** Grow by fixed-size blocks of rows that never move, instead of reallocating one buffer for all rows. */
+        bool chunked = false;
+        /** Approximate size of a block in bytes, rounded up to whole pages. */
+        std::size_t block_bytes = 1UL << 20;
+        /** Address space reserved for all blocks of a row group. */
+        std::size_t max_bytes = 1UL << 36;
+        /** Names of attributes stored in a cold row group of their own, so that scans of the other (hot) attributes do
+         * not drag them through the cache.  `repartition()` chooses them from the noted accesses. */
+        std::vector<std::string> cold_attributes;
+        /** `repartition()` makes attributes cold that are accessed at most this fraction as often as the most
+         * accessed attribute. */
+        double cold_access_ratio = 0.1;
+        /** `erase()` compacts the store by up to `compaction_step` rows whenever more than `compaction_threshold` of
+         * its rows are dead.  By default, every erase compacts at once.  mutable knows nothing of dead rows and scans
+         * them like live ones, so only stores whose dead rows are skipped by their own scans may defer compaction. */
+        double compaction_threshold = 0;
+        std::size_t compaction_step = 1024;
+        /** Names of integer attributes to summarize per block in zone maps, for `select_range()`. */
+        std::vector<std::string> zone_map_attributes;
+    };
+
     private:
+    /** Rows of a group of attributes.  Row `i` of the store consists of row `i` of every group. */
+    struct RowGroup
+    {
+        // Placement of the attributes (and the null bitmap) of the group inside a row
+        RowLayout layout;
+        void *address = nullptr;
+        // Chunked mode: distance between two blocks (rows + padding to whole pages) and address space reserved
+        std::size_t block_stride_bytes = 0;
+        std::size_t reserved_bytes = 0;
+    };
+
+    /** The row groups as a reader finds them, replaced whenever the rows move. */
+    struct Version
+    {
+        std::vector<RowGroup> groups;
+        // Rows per block in chunked mode, 0 otherwise
+        std::size_t rows_per_block;
+    };
+
     /* 1.2.1: Declare necessary fields. */
-    void* address;
     size_t rows_used = 0;
-    size_t row_total_bytes;
     size_t storable_in_buffer;
     size_t previous_buffer_size;
 
-    std::size_t master_stride_bytes;
-    // List of all attributes to be sorted
-    std::vector<std::tuple<size_t, size_t>> toSort;
+    // The hot group first, it holds the null bitmap.  The cold group, if any, second.
+    std::vector<RowGroup> groups;
+
+    Options options;
+    // Chunked mode: number of rows in a block and number of committed blocks, the same for all groups
+    std::size_t rows_per_block = 0;
+    std::size_t num_blocks = 0;
+    // Rows restored from a snapshot stay in the mapped file until the buffers are resized
+    snapshot::Mapping mapping;
+    // Number of accesses to each attribute, as noted by `note_access()`
+    std::vector<uint64_t> access_counts;
+    // Rows erased but not compacted yet
+    Tombstones dead_rows;
+    // Reallocations, copies and linearizations so far
+    StoreStatistics stats;
+    // Zone map of each attribute in `options.zone_map_attributes`, indexed by attribute id
+    std::vector<std::unique_ptr<ZoneMap>> zone_maps;
+    // Rows claimed and published by concurrent writers, between `begin_concurrent_appends()` and
+    // `end_concurrent_appends()`
+    std::unique_ptr<ConcurrentAppend> concurrent;
+    // Readers of `read_view()`s find the current row groups here, and pin the memory they read through `epochs`.  All
+    // rows before `committed` are written.
+    std::atomic<const Version *> version{ nullptr };
+    std::atomic<std::size_t> committed{ 0 };
+    mutable EpochManager epochs;
+    // Frees memory replaced since the current version was published.  That version still reaches the memory, so it is
+    // only retired once `publish_version()` replaced the version.
+    std::vector<std::function<void()>> unpublished;
 
     public:
-    RowStore(const m::Table &table);
+    RowStore(const m::Table &table) : RowStore(table, Options()) {}
+    RowStore(const m::Table &table, const Options &options);
     ~RowStore();
 
     std::size_t num_rows() const override;
     void append() override;
     void drop() override;
 
+    /** Makes room for at least `n` rows in total, so that appending up to `n` rows does not allocate. */
+    void reserve(std::size_t n);
+    /** Appends `n` rows at once. */
+    void append(std::size_t n);
+
+    /** Switches a chunked store to concurrent appends.  Until `end_concurrent_appends()`, writers on any thread
+     * `claim_rows()`, write them through `value_location()` and `null_location()`, and `publish_rows()`.
+     * `num_rows()` returns the watermark, below which all rows are written.  No other method may be called meanwhile,
+     * except `row_address()` of rows below the watermark.  Throws `std::logic_error` unless the store is chunked. */
+    void begin_concurrent_appends();
+    /** Claims `n` rows, commits their blocks and returns the first row.  Throws `std::bad_alloc` if the reserved
+     * address space is exhausted.  Safe to call from several threads at once. */
+    std::size_t claim_rows(std::size_t n);
+    /** Publishes the `n` claimed rows from `first` on, which must be written completely.  Safe to call from several
+     * threads at once. */
+    void publish_rows(std::size_t first, std::size_t n);
+    /** Ends concurrent appends, after all writers are done.  The published rows become ordinary rows of the store.
+     * Throws `std::logic_error` if some claimed rows are not published. */
+    void end_concurrent_appends();
+
+    /** The rows committed when the view was taken.  The memory of the view stays valid while a writer appends more
+     * rows, even if the store moves its rows meanwhile, until the view is destroyed. */
+    struct ReadView
+    {
+        /** Returns the number of rows in the view. */
+        std::size_t num_rows() const { return rows; }
+        /** Returns the location of the value of attribute `id` in row `row` of the view. */
+        BitAddress value_location(std::size_t row, std::size_t id) const;
+        /** Returns the location of the NULL bit of attribute `id` in row `row` of the view, with a `nullptr` base if
+         * the store has no null bitmap. */
+        BitAddress null_location(std::size_t row, std::size_t id) const;
+
+        private:
+        friend struct RowStore;
+        ReadView(EpochManager::Guard guard) : guard(std::move(guard)) {}
+        uint8_t *row_address(std::size_t row, std::size_t group) const;
+
+        EpochManager::Guard guard;
+        const Version *version = nullptr;
+        std::size_t rows = 0;
+    };
+    /** Returns a view of the committed rows.  Safe to call from any thread while one writer appends, if the store has
+     * `Options::concurrent_readers` or is chunked; rows are only erased, compacted, dropped or rearranged while no
+     * view exists.  mutable's queries read the linearization instead, which only a chunked store never replaces. */
+    ReadView read_view() const;
+    /** Returns the number of rows written completely, which a `read_view()` sees.  mutable writes the values of a row
+     * after appending it, so every `append()` commits the rows before the new one. */
+    std::size_t committed_rows() const {
+        return concurrent ? concurrent->watermark() : committed.load(std::memory_order_acquire);
+    }
+    /** Commits all rows appended so far, once their values are written. */
+    void commit_rows() { committed.store(rows_used, std::memory_order_release); }
+
+    /** Marks row `row` dead and compacts as `Options::compaction_threshold` asks, by default at once: the last row
+     * moves into its place.  Until compacted, a dead row keeps its place and stays visible to mutable.  Returns false
+     * if the row does not exist or is dead already. */
+    bool erase(std::size_t row);
+    /** Returns true iff row `row` exists and is not dead. */
+    bool is_live(std::size_t row) const { return row < rows_used and not dead_rows.is_dead(row); }
+    /** Returns the number of rows not dead. */
+    std::size_t num_live_rows() const { return rows_used - dead_rows.size(); }
+    /** Returns the dead rows, which scans must skip. */
+    const Tombstones &tombstones() const { return dead_rows; }
+    /** Moves up to `budget` live rows from the end of the store into the places of dead rows, drops all dead rows from
+     * the end and shrinks the buffers accordingly.  Moved rows change their index.  Returns the number of rows moved. */
+    std::size_t compact(std::size_t budget = std::numeric_limits<std::size_t>::max());
+
+    /** Returns the zone map of attribute `id`, or `nullptr` if it has none. */
+    const ZoneMap *zone_map(std::size_t id) const { return zone_maps[id].get(); }
+    /** Returns the live rows whose integer attribute `id` lies in [`lo`, `hi`].  Blocks whose zone rules out the range
+     * are skipped, their number is added to `*skipped_blocks`, if given. */
+    Selection select_range(std::size_t id, int64_t lo, int64_t hi, std::size_t *skipped_blocks = nullptr);
+
+    /** Returns the number of row groups, 2 if the store is split into a hot and a cold group. */
+    std::size_t num_groups() const { return groups.size(); }
+    /** Returns the placement of the attributes (and the null bitmap) inside a row of group `group`. */
+    const RowLayout &layout(std::size_t group = 0) const { return groups[group].layout; }
+
+    /** Returns the address of row `row` in group `group`. */
+    uint8_t *row_address(std::size_t row, std::size_t group = 0) const;
+    /** Returns the location of the value of attribute `id` in row `row`, which must have been appended. */
+    BitAddress value_location(std::size_t row, std::size_t id) const;
+    /** Returns the location of the NULL bit of attribute `id` in row `row`, with a `nullptr` base if the store has no
+     * null bitmap. */
+    BitAddress null_location(std::size_t row, std::size_t id) const;
+
+    /** Notes `n` accesses to the attribute with id `id`, e.g. because it is filtered on or projected by a query. */
+    void note_access(std::size_t id, uint64_t n = 1) { access_counts[id] += n; }
+    /** Returns the number of noted accesses to the attribute with id `id`. */
+    uint64_t accesses(std::size_t id) const { return access_counts[id]; }
+    /** Splits the rows into a hot and a cold group, choosing the cold attributes from the noted accesses, or merges
+     * the groups again if no attribute is cold.  Does nothing before any access was noted.  Returns true iff the rows
+     * were moved to new groups. */
+    bool repartition();
+
+    /** Removes the null bitmap from all rows and packs the rows tighter, if no row contains a NULL.  Afterwards, no
+     * attribute may be set to NULL anymore.  Returns true iff the store has no null bitmap (anymore). */
+    bool drop_null_bitmap();
+
+    /** Compacts the store, since snapshots hold no dead rows, and writes a snapshot of all rows to the file at `path`.
+     * Returns false if the file cannot be written. */
+    bool save(const char *path);
+    /** Replaces the rows of this empty store by the rows of the snapshot at `path`, by mapping the file into memory.
+     * Returns false if the store is not empty or the file is no row snapshot of a table with the same schema. */
+    bool restore(const char *path);
+
     void accept(m::StoreVisitor &v) override { v(*this); }
     void accept(m::ConstStoreVisitor &v) const override { v(*this); }
 
+    /** Returns a linearization of the rows where they are in memory right now, e.g. for a store that wraps this one.
+     * It is valid until the store replaces its own linearization. */
+    std::unique_ptr<m::Linearization> make_linearization() const;
+
+    /** Returns what the store holds in memory and what maintaining it has cost so far. */
+    StoreStatistics statistics() const;
+
     void dump(std::ostream &out) const override;
     using Store::dump;
 
+    private:
+    uint8_t *row_address(const RowGroup &group, std::size_t row, std::size_t stride_bytes) const;
+    static std::size_t group_of(const std::vector<RowGroup> &groups, std::size_t id);
+    std::vector<RowLayout> plan_groups() const;
+    void allocate(std::vector<RowGroup> &new_groups);
+    void release(std::vector<RowGroup> &old_groups);
+    void release_mapping();
+    void free_later(std::function<void()> free);
+    void grow(std::size_t capacity);
+    void *move_rows(void *address, std::size_t old_bytes, std::size_t new_bytes);
+    void publish_version();
+    void own_buffers();
+    void reset_zone_maps();
+    void summarize(std::size_t written_rows);
+    const uint8_t *value_address(std::size_t row, std::size_t id) const;
+    bool is_null(std::size_t row, std::size_t id) const;
+    std::unique_ptr<m::Linearization> createRowLin(const RowLayout &layout) const;
+    void createLin();
+
 };
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+/** Indices of the rows of a store that satisfy a predicate, ascending. */
+using Selection = std::vector<uint32_t>;
+
+/** One bit per row of a store, set iff the row satisfies a predicate.  Bitmaps of the same rows combine with `&=` and
+ * `|=` into conjunctions and disjunctions of their predicates.  Bits past the last row are always clear. */
+struct RowBitmap
+{
+    std::vector<uint64_t> words;
+    std::size_t num_rows = 0;
+
+    RowBitmap() = default;
+    explicit RowBitmap(std::size_t num_rows) : words((num_rows + 63) / 64, 0), num_rows(num_rows) {}
+
+    bool test(std::size_t row) const { return (words[row / 64] >> (row % 64)) & 1u; }
+    void set(std::size_t row) { words[row / 64] |= uint64_t(1) << (row % 64); }
+    void reset(std::size_t row) { words[row / 64] &= ~(uint64_t(1) << (row % 64)); }
+
+    RowBitmap &operator&=(const RowBitmap &other) {
+        for (std::size_t i = 0; i != words.size(); ++i) words[i] &= other.words[i];
+        return *this;
+    }
+    RowBitmap &operator|=(const RowBitmap &other) {
+        for (std::size_t i = 0; i != words.size(); ++i) words[i] |= other.words[i];
+        return *this;
+    }
+
+    /** Returns the number of rows set. */
+    std::size_t count() const {
+        std::size_t n = 0;
+        for (auto w : words) n += __builtin_popcountll(w);
+        return n;
+    }
+
+    /** Returns the rows set as selection vector. */
+    Selection to_selection() const {
+        Selection selection;
+        selection.reserve(count());
+        for (std::size_t i = 0; i != words.size(); ++i)
+            for (uint64_t w = words[i]; w; w &= w - 1)
+                selection.push_back(i * 64 + __builtin_ctzll(w));
+        return selection;
+    }
+};
@@ -0,0 +1,197 @@
+#include "Snapshot.hpp"
+#include "Memory.hpp"
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace {
+
+constexpr char MAGIC[6] = { 'D', 'B', 'S', 'N', 'A', 'P' };
+/** Version of the file format.  Snapshots of any other version are rejected, they must be taken again. */
+constexpr char VERSION[2] = { '0', '2' };
+
+/** Fixed-size start of every snapshot file.  Followed by, in this order: per attribute its size and alignment in bits
+ * and its name (length and characters), the layout parameters, and the offset and size of every segment. */
+struct Header
+{
+    char magic[6];
+    char version[2];
+    uint32_t kind;
+    uint32_t num_attributes;
+    uint64_t num_rows;
+    uint64_t capacity;
+    uint64_t num_layout;
+    uint64_t num_segments;
+};
+
+void write_u64(std::ostream &out, uint64_t value) {
+    out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+/** Reads values from the metadata of a mapped snapshot, remembering whether it ran past the end. */
+struct Reader
+{
+    const uint8_t *pos;
+    const uint8_t *end;
+    bool ok = true;
+
+    uint64_t u64() {
+        uint64_t value = 0;
+        if (end - pos < std::ptrdiff_t(sizeof(value))) {
+            ok = false;
+            return value;
+        }
+        memcpy(&value, pos, sizeof(value));
+        pos += sizeof(value);
+        return value;
+    }
+
+    std::string string() {
+        const auto length = u64();
+        if (not ok or uint64_t(end - pos) < length) {
+            ok = false;
+            return {};
+        }
+        std::string value(reinterpret_cast<const char *>(pos), length);
+        pos += length;
+        return value;
+    }
+};
+
+}
+
+bool snapshot::write(const char *path, const m::Table &table, const Contents &contents,
+                     const std::vector<Pieces> &segments) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (not out) return false;
+
+    Header header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    memcpy(header.version, VERSION, sizeof(VERSION));
+    header.kind = uint32_t(contents.kind);
+    header.num_attributes = table.size();
+    header.num_rows = contents.num_rows;
+    header.capacity = contents.capacity;
+    header.num_layout = contents.layout.size();
+    header.num_segments = segments.size();
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    // Schema, to check that a snapshot is restored into a matching table
+    std::size_t metadata_bytes = sizeof(header);
+    for (const auto &i : table) {
+        write_u64(out, i.type->size());
+        write_u64(out, i.type->alignment());
+        write_u64(out, strlen(i.name));
+        out.write(i.name, strlen(i.name));
+        metadata_bytes += 3 * sizeof(uint64_t) + strlen(i.name);
+    }
+
+    for (auto value : contents.layout)
+        write_u64(out, value);
+    metadata_bytes += contents.layout.size() * sizeof(uint64_t);
+
+    // Segment table, segments follow the metadata and start at page boundaries
+    metadata_bytes += segments.size() * 2 * sizeof(uint64_t);
+    std::size_t offset = memory::round_up(metadata_bytes, memory::page_size());
+    for (const auto &pieces : segments) {
+        std::size_t bytes = 0;
+        for (const auto &piece : pieces) bytes += piece.second;
+        write_u64(out, offset);
+        write_u64(out, bytes);
+        offset = memory::round_up(offset + bytes, memory::page_size());
+    }
+
+    // Segments
+    std::size_t written = metadata_bytes;
+    const std::vector<char> zeros(memory::page_size(), 0);
+    for (const auto &pieces : segments) {
+        const std::size_t padding = memory::round_up(written, memory::page_size()) - written;
+        out.write(zeros.data(), padding);
+        written += padding;
+        for (const auto &piece : pieces) {
+            out.write(reinterpret_cast<const char *>(piece.first), piece.second);
+            written += piece.second;
+        }
+    }
+
+    return bool(out);
+}
+
+bool snapshot::is_snapshot(const char *path) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[sizeof(MAGIC)];
+    return in.read(magic, sizeof(magic)) and memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+snapshot::Mapping snapshot::map(const char *path, const m::Table &table, Kind kind) {
+    Mapping mapping;
+
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) return mapping;
+    struct stat st;
+    if (fstat(fd, &st) != 0 or std::size_t(st.st_size) < sizeof(Header)) {
+        close(fd);
+        return mapping;
+    }
+
+    // Private mapping: the store may write to its rows, and the pages are only copied when it does
+    void *address = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) return mapping;
+
+    auto fail = [&]() {
+        munmap(address, st.st_size);
+        return Mapping();
+    };
+
+    Header header;
+    memcpy(&header, address, sizeof(header));
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 or memcmp(header.version, VERSION, sizeof(VERSION)) != 0 or
+        header.kind != uint32_t(kind) or header.num_attributes != table.size() or header.num_rows > header.capacity)
+        return fail();
+
+    Reader reader{reinterpret_cast<const uint8_t *>(address) + sizeof(header),
+                  reinterpret_cast<const uint8_t *>(address) + st.st_size};
+    for (const auto &i : table) {
+        const auto size = reader.u64();
+        const auto alignment = reader.u64();
+        const auto name = reader.string();
+        if (not reader.ok or size != i.type->size() or alignment != i.type->alignment() or name != i.name)
+            return fail();
+    }
+
+    // The counts come from the file, they cannot ask for more values than the rest of the file holds
+    const uint64_t size = st.st_size;
+    const uint64_t remaining = reader.end - reader.pos;
+    if (header.num_layout > remaining / sizeof(uint64_t) or
+        header.num_segments > (remaining - header.num_layout * sizeof(uint64_t)) / (2 * sizeof(uint64_t)))
+        return fail();
+
+    mapping.contents.kind = kind;
+    mapping.contents.num_rows = header.num_rows;
+    mapping.contents.capacity = header.capacity;
+    for (uint64_t i = 0; i != header.num_layout and reader.ok; ++i)
+        mapping.contents.layout.push_back(reader.u64());
+
+    for (uint64_t i = 0; i != header.num_segments; ++i) {
+        const auto offset = reader.u64();
+        const auto bytes = reader.u64();
+        if (not reader.ok or bytes > size or offset > size - bytes) return fail();
+        mapping.segments.push_back(reinterpret_cast<uint8_t *>(address) + offset);
+        mapping.segment_bytes.push_back(bytes);
+    }
+    if (not reader.ok) return fail();
+
+    mapping.address = address;
+    mapping.bytes = st.st_size;
+    return mapping;
+}
+
+void snapshot::unmap(Mapping &mapping) {
+    if (mapping.address) munmap(mapping.address, mapping.bytes);
+    mapping = Mapping();
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <mutable/mutable.hpp>
+#include <utility>
+#include <vector>
+
+
+/* Snapshots persist the buffers of a store in a file, which can later be mapped into memory again without any per-row
+ * work.  A snapshot file starts with a header, the schema of the table, store specific layout parameters, and a table
+ * of segments.  Every segment holds one buffer of the store and starts at a page boundary.  The header carries the
+ * version of the format, snapshots of another version cannot be mapped. */
+namespace snapshot {
+
+/** The kind of store a snapshot was taken of. */
+enum class Kind : uint32_t
+{
+    Row = 1,
+    Column = 2,
+};
+
+/** A segment to write, given as pieces of memory that are concatenated. */
+using Pieces = std::vector<std::pair<const void *, std::size_t>>;
+
+/** Contents of a snapshot. */
+struct Contents
+{
+    Kind kind;
+    /** Number of rows stored and number of rows the buffers have room for. */
+    uint64_t num_rows = 0;
+    uint64_t capacity = 0;
+    /** Layout parameters, specific to the kind of store. */
+    std::vector<uint64_t> layout;
+};
+
+/** A snapshot mapped into memory.  The mapping is private, writes to it never reach the file. */
+struct Mapping
+{
+    void *address = nullptr;
+    std::size_t bytes = 0;
+    Contents contents;
+    /** Start and size in bytes of each segment in the mapping. */
+    std::vector<void *> segments;
+    std::vector<std::size_t> segment_bytes;
+
+    explicit operator bool() const { return address != nullptr; }
+};
+
+/** Writes a snapshot of a store of `table` with `contents` and one segment per element of `segments` to `path`.
+ * Returns false if the file cannot be written. */
+bool write(const char *path, const m::Table &table, const Contents &contents, const std::vector<Pieces> &segments);
+
+/** Returns true iff the file at `path` is a snapshot. */
+bool is_snapshot(const char *path);
+
+/** Maps the snapshot at `path`, if it is a snapshot of the current version and of kind `kind` and matches the schema
+ * of `table`.  Returns an empty mapping otherwise. */
+Mapping map(const char *path, const m::Table &table, Kind kind);
+
+/** Unmaps `mapping` and leaves it empty. */
+void unmap(Mapping &mapping);
+
+}
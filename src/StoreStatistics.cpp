@@ -0,0 +1,29 @@
+#include "StoreStatistics.hpp"
+
+
+void StoreStatistics::print(std::ostream &out) const {
+    const double linearization_ms = std::chrono::duration<double, std::milli>(linearization_time).count();
+    out << "  rows: " << rows << " (" << live_rows << " live, " << rows - live_rows << " dead)\n"
+        << "  capacity: " << capacity << " rows, " << allocated_bytes << " bytes allocated\n"
+        << "  row: " << bytes_per_row << " bytes, null bitmaps: " << null_bitmap_bytes << " bytes in total\n"
+        << "  encoded columns: " << encoded_bytes << " bytes\n"
+        << "  reallocations: " << grow_reallocations << " to grow, " << shrink_reallocations << " to shrink, "
+        << copied_bytes << " bytes copied\n"
+        << "  linearizations: " << linearizations << " built in " << linearization_ms << " ms" << std::endl;
+}
+
+void StoreStatistics::print_json(std::ostream &out) const {
+    out << "{\"rows\":" << rows
+        << ",\"live_rows\":" << live_rows
+        << ",\"capacity\":" << capacity
+        << ",\"allocated_bytes\":" << allocated_bytes
+        << ",\"bytes_per_row\":" << bytes_per_row
+        << ",\"null_bitmap_bytes\":" << null_bitmap_bytes
+        << ",\"encoded_bytes\":" << encoded_bytes
+        << ",\"grow_reallocations\":" << grow_reallocations
+        << ",\"shrink_reallocations\":" << shrink_reallocations
+        << ",\"copied_bytes\":" << copied_bytes
+        << ",\"linearizations\":" << linearizations
+        << ",\"linearization_ns\":" << linearization_time.count()
+        << '}' << std::endl;
+}
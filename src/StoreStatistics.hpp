@@ -0,0 +1,36 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+
+
+/** What a store holds in memory and what maintaining its buffers has cost so far. */
+struct StoreStatistics
+{
+    /** Rows in the store, dead rows included, and rows not erased. */
+    std::size_t rows = 0;
+    std::size_t live_rows = 0;
+    /** Rows the allocated buffers have room for, and their size in bytes. */
+    std::size_t capacity = 0;
+    std::size_t allocated_bytes = 0;
+    /** Bytes a row takes, including padding and the null bitmap. */
+    std::size_t bytes_per_row = 0;
+    /** Bytes of the allocated buffers taken by null bitmaps. */
+    std::size_t null_bitmap_bytes = 0;
+    /** Bytes taken by encoded copies of columns, next to the buffers mutable reads. */
+    std::size_t encoded_bytes = 0;
+
+    /** Number of reallocations to grow and to shrink the buffers, and bytes copied to move buffers. */
+    std::size_t grow_reallocations = 0;
+    std::size_t shrink_reallocations = 0;
+    std::size_t copied_bytes = 0;
+    /** Number of linearizations built and the time spent building them. */
+    std::size_t linearizations = 0;
+    std::chrono::nanoseconds linearization_time{0};
+
+    /** Prints the statistics for humans, one line per topic. */
+    void print(std::ostream &out) const;
+    /** Prints the statistics as a single JSON object. */
+    void print_json(std::ostream &out) const;
+};
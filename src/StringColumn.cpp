@@ -0,0 +1,122 @@
+#include "StringColumn.hpp"
+#include <cstring>
+
+
+namespace {
+
+/** Returns the first `StringColumn::PREFIX_BYTES` bytes of the `length` bytes at `value`, zero padded, big endian. */
+uint32_t prefix_of(const char *value, std::size_t length) {
+    uint32_t prefix = 0;
+    for (std::size_t i = 0; i != StringColumn::PREFIX_BYTES; ++i)
+        prefix = prefix << 8 | (i < length ? uint8_t(value[i]) : 0);
+    return prefix;
+}
+
+/** A constant to compare rows with, split like the values of the column. */
+struct Key
+{
+    uint32_t prefix;
+    std::string rest;
+    std::size_t length;
+
+    Key(const std::string &s, std::size_t value_bytes) {
+        // Like `strncmp()` on the column, the constant ends at its first NUL and after the width of the column
+        length = strnlen(s.c_str(), value_bytes);
+        prefix = prefix_of(s.c_str(), length);
+        if (length > StringColumn::PREFIX_BYTES)
+            rest = s.substr(StringColumn::PREFIX_BYTES, length - StringColumn::PREFIX_BYTES);
+    }
+};
+
+}
+
+void StringColumn::append(const char *value) {
+    // CHAR values end at the first NUL byte, if shorter than the column
+    const std::size_t length = value ? strnlen(value, value_bytes) : 0;
+    prefixes.push_back(prefix_of(value, length));
+    references.push_back(uint64_t(heap.size()) << 16 | length);
+    if (length > PREFIX_BYTES) {
+        heap.insert(heap.end(), value + PREFIX_BYTES, value + length);
+        live_bytes += length - PREFIX_BYTES;
+    }
+}
+
+void StringColumn::truncate(std::size_t n) {
+    if (n >= size()) return;
+    for (std::size_t row = n; row != size(); ++row)
+        live_bytes -= length(row) > PREFIX_BYTES ? length(row) - PREFIX_BYTES : 0;
+    prefixes.resize(n);
+    references.resize(n);
+    if (n == 0) heap.clear();
+    if (2 * live_bytes < heap.size()) compact_heap();
+}
+
+void StringColumn::copy(std::size_t from, std::size_t to) {
+    const auto rest = [this](std::size_t row) { return length(row) > PREFIX_BYTES ? length(row) - PREFIX_BYTES : 0; };
+    live_bytes = live_bytes - rest(to) + rest(from);
+    prefixes[to] = prefixes[from];
+    references[to] = references[from];
+}
+
+std::string StringColumn::value(std::size_t row) const {
+    const std::size_t n = length(row);
+    std::string result;
+    result.reserve(n);
+    for (std::size_t i = 0; i != std::min(n, PREFIX_BYTES); ++i)
+        result.push_back(char(prefixes[row] >> (8 * (PREFIX_BYTES - 1 - i))));
+    if (n > PREFIX_BYTES) result.append(heap.data() + (references[row] >> 16), n - PREFIX_BYTES);
+    return result;
+}
+
+void StringColumn::compare(predicate::Comparison op, const std::string &lo, const std::string &hi,
+                           uint64_t *out) const {
+    using predicate::Comparison;
+    const Key lo_key(lo, value_bytes), hi_key(hi, value_bytes);
+
+    // Returns <0, 0 or >0 as the value of row `row` compares to `key`
+    auto compare_to = [this](std::size_t row, const Key &key) -> int {
+        if (prefixes[row] != key.prefix) return prefixes[row] < key.prefix ? -1 : 1;
+        const std::size_t n = length(row);
+        if (n <= PREFIX_BYTES and key.length <= PREFIX_BYTES) return 0; // equal prefixes hold the whole strings
+        const std::size_t rest = n > PREFIX_BYTES ? n - PREFIX_BYTES : 0;
+        const std::size_t common = std::min(rest, key.rest.size());
+        const int c = common ? memcmp(heap.data() + (references[row] >> 16), key.rest.data(), common) : 0;
+        return c != 0 ? c : int(rest > key.rest.size()) - int(rest < key.rest.size());
+    };
+    auto qualifies = [&](std::size_t row) {
+        switch (op) {
+            case Comparison::Equal:
+                return prefixes[row] == lo_key.prefix and length(row) == lo_key.length and compare_to(row, lo_key) == 0;
+            case Comparison::NotEqual:
+                return prefixes[row] != lo_key.prefix or length(row) != lo_key.length or compare_to(row, lo_key) != 0;
+            case Comparison::Less:         return compare_to(row, lo_key) < 0;
+            case Comparison::LessEqual:    return compare_to(row, lo_key) <= 0;
+            case Comparison::Greater:      return compare_to(row, lo_key) > 0;
+            case Comparison::GreaterEqual: return compare_to(row, lo_key) >= 0;
+            case Comparison::Between:      return compare_to(row, lo_key) >= 0 and compare_to(row, hi_key) <= 0;
+        }
+        return false;
+    };
+
+    for (std::size_t first = 0; first < size(); first += 64) {
+        uint64_t word = 0;
+        for (std::size_t row = first, end = std::min(first + 64, size()); row != end; ++row)
+            word |= uint64_t(qualifies(row)) << (row - first);
+        out[first / 64] = word;
+    }
+}
+
+/** Rewrites the heap with the bytes of the rows only, in row order. */
+void StringColumn::compact_heap() {
+    std::vector<char> compacted;
+    compacted.reserve(live_bytes);
+    for (std::size_t row = 0; row != size(); ++row) {
+        const std::size_t n = length(row);
+        const std::size_t offset = references[row] >> 16;
+        references[row] = uint64_t(compacted.size()) << 16 | n;
+        if (n > PREFIX_BYTES)
+            compacted.insert(compacted.end(), heap.data() + offset, heap.data() + offset + n - PREFIX_BYTES);
+    }
+    heap = std::move(compacted);
+    live_bytes = heap.size();
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Predicate.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+/** A CHAR column of variable length.  Every row keeps the first `PREFIX_BYTES` bytes of its value inline, zero padded
+ * and big endian, so that comparing prefixes as integers orders them like the strings.  The rest of the value lies in
+ * a contiguous heap, found through a reference of offset and length per row.  NULL is stored as the empty string.
+ * The heap is append-only: rows truncated or overwritten leave garbage, which is compacted away once it takes half of
+ * the heap. */
+struct StringColumn
+{
+    static constexpr std::size_t PREFIX_BYTES = 4;
+    /** Longest CHAR value a reference can hold. */
+    static constexpr std::size_t MAX_BYTES = (1U << 16) - 1;
+
+    private:
+    // Width of the CHAR values in bytes
+    std::size_t value_bytes;
+    // Prefix of every row, and its reference: offset of the rest of the value in `heap` << 16 | length of the value
+    std::vector<uint32_t> prefixes;
+    std::vector<uint64_t> references;
+    std::vector<char> heap;
+    // Bytes of `heap` referenced by rows, rows sharing bytes count them twice
+    std::size_t live_bytes = 0;
+
+    public:
+    explicit StringColumn(std::size_t value_bytes) : value_bytes(value_bytes) {}
+
+    /** Returns the number of encoded rows. */
+    std::size_t size() const { return prefixes.size(); }
+    /** Returns the bytes taken by the prefixes, references and heap. */
+    std::size_t bytes() const {
+        return prefixes.size() * sizeof(uint32_t) + references.size() * sizeof(uint64_t) + heap.size();
+    }
+    /** Returns the bytes taken by the heap, garbage included. */
+    std::size_t heap_bytes() const { return heap.size(); }
+
+    /** Appends the CHAR value at `value`, or NULL if `value` is `nullptr`. */
+    void append(const char *value);
+    /** Forgets all rows from `n` on. */
+    void truncate(std::size_t n);
+    /** Sets the value of row `to` to the value of row `from`, sharing its bytes in the heap. */
+    void copy(std::size_t from, std::size_t to);
+
+    /** Returns the length of the value of row `row`. */
+    std::size_t length(std::size_t row) const { return references[row] & MAX_BYTES; }
+    /** Returns the value of row `row`. */
+    std::string value(std::size_t row) const;
+
+    /** Compares the values of all rows with the strings `lo` and `hi` like `predicate::compare_chars()`, writing one
+     * bit per row to `out`.  Rows whose prefix differs from the constants' are decided without reading the heap. */
+    void compare(predicate::Comparison op, const std::string &lo, const std::string &hi, uint64_t *out) const;
+
+    private:
+    void compact_heap();
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+
+/** Marks deleted rows of a store, until compaction moves live rows from the end of the store into their place.  Row
+ * indices stay stable until then. */
+struct Tombstones
+{
+    private:
+    // One bit per row, set iff the row is dead
+    std::vector<uint64_t> words;
+    std::size_t num_dead = 0;
+    // No row below is dead
+    std::size_t lowest_dead = 0;
+
+    public:
+    /** Returns the number of dead rows. */
+    std::size_t size() const { return num_dead; }
+    bool empty() const { return num_dead == 0; }
+
+    /** Returns true iff `row` is dead. */
+    bool is_dead(std::size_t row) const {
+        return row / 64 < words.size() and (words[row / 64] >> (row % 64)) & 1u;
+    }
+
+    /** Marks `row` dead.  Returns false if it was dead already. */
+    bool mark(std::size_t row) {
+        if (is_dead(row)) return false;
+        if (row / 64 >= words.size()) words.resize(row / 64 + 1, 0);
+        words[row / 64] |= uint64_t(1) << (row % 64);
+        lowest_dead = std::min(lowest_dead, row);
+        ++num_dead;
+        return true;
+    }
+
+    /** Forgets `row`, e.g. because a live row was moved into its place or the row was dropped from the store. */
+    void forget(std::size_t row) {
+        if (not is_dead(row)) return;
+        words[row / 64] &= ~(uint64_t(1) << (row % 64));
+        --num_dead;
+    }
+
+    /** Returns the lowest dead row, or the maximum `std::size_t` if no row is dead. */
+    std::size_t first_dead() {
+        if (num_dead == 0) return std::numeric_limits<std::size_t>::max();
+        std::size_t word = lowest_dead / 64;
+        uint64_t bits = words[word] & (~uint64_t(0) << (lowest_dead % 64));
+        while (bits == 0) bits = words[++word];
+        return lowest_dead = word * 64 + __builtin_ctzll(bits);
+    }
+
+    /** Moves up to `budget` live rows from the end of a store with `num_rows` rows into the places of dead rows.
+     * `move_row(from, to)` copies a row and `drop_row()` removes the last row of the store.  Dead rows at the end are
+     * dropped without counting against the budget.  Returns the number of rows moved. */
+    template<typename Move, typename Drop>
+    std::size_t compact(std::size_t num_rows, std::size_t budget, Move &&move_row, Drop &&drop_row) {
+        std::size_t moved = 0;
+        while (num_dead != 0) {
+            const std::size_t last = num_rows - 1;
+            if (is_dead(last)) {
+                forget(last);
+            } else {
+                if (moved == budget) break;
+                const auto hole = first_dead();
+                move_row(last, hole);
+                forget(hole);
+                ++moved;
+            }
+            drop_row();
+            --num_rows;
+        }
+        return moved;
+    }
+};
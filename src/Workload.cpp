@@ -0,0 +1,150 @@
+#include "Workload.hpp"
+#include "AdaptiveStore.hpp"
+#include "RowStore.hpp"
+#include <cctype>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <strings.h>
+
+
+namespace {
+
+/** Returns the position after the string literal or comment at `pos` in `sql`, or `pos` if there is none. */
+std::size_t skip_literal_or_comment(const std::string &sql, std::size_t pos) {
+    const char c = sql[pos];
+    if (c == '\'' or c == '"') {
+        pos = sql.find(c, pos + 1);
+        return pos == std::string::npos ? sql.size() : pos + 1;
+    }
+    if (c == '-' and pos + 1 < sql.size() and sql[pos + 1] == '-') {
+        pos = sql.find('\n', pos);
+        return pos == std::string::npos ? sql.size() : pos;
+    }
+    return pos;
+}
+
+/** Reads the file at `path` into `sql`.  Returns false if it cannot be read. */
+bool read_file(const char *path, std::string &sql) {
+    std::ifstream in(path);
+    if (not in) return false;
+    std::stringstream contents;
+    contents << in.rdbuf();
+    sql = contents.str();
+    return true;
+}
+
+}
+
+std::vector<std::string> split_statements(const std::string &sql) {
+    std::vector<std::string> statements;
+    std::size_t begin = 0;
+    bool blank = true; // only whitespace and comments since `begin`
+    for (std::size_t pos = 0; pos < sql.size();) {
+        const auto next = skip_literal_or_comment(sql, pos);
+        if (next != pos) {
+            blank = blank and sql[pos] == '-';
+            pos = next;
+            continue;
+        }
+        if (sql[pos] == ';') {
+            if (not blank) statements.push_back(sql.substr(begin, pos + 1 - begin));
+            begin = pos + 1;
+            blank = true;
+        } else if (not std::isspace(sql[pos])) {
+            blank = false;
+        }
+        ++pos;
+    }
+    // A statement without `;` at the end of the file is left to the parser to complain about
+    if (not blank) statements.push_back(sql.substr(begin));
+    return statements;
+}
+
+std::vector<std::vector<std::size_t>> statement_attributes(const m::Table &table, const std::string &sql) {
+    std::vector<std::vector<std::size_t>> statements;
+    std::vector<bool> mentioned(table.size(), false);
+
+    // Collects the mentions of the statement just finished
+    auto end_statement = [&]() {
+        std::vector<std::size_t> ids;
+        for (std::size_t id = 0; id != mentioned.size(); ++id) {
+            if (mentioned[id]) ids.push_back(id);
+            mentioned[id] = false;
+        }
+        if (not ids.empty()) statements.push_back(std::move(ids));
+    };
+
+    std::string previous; // previous token, to tell `SELECT *` from a multiplication
+    for (std::size_t pos = 0; pos < sql.size();) {
+        const char c = sql[pos];
+        if (const auto next = skip_literal_or_comment(sql, pos); next != pos) {
+            // Skip string literals, and comments up to the end of the line
+            if (c != '-') previous.clear();
+            pos = next;
+        } else if (std::isalpha(c) or c == '_') {
+            const auto begin = pos;
+            while (pos < sql.size() and (std::isalnum(sql[pos]) or sql[pos] == '_')) ++pos;
+            previous = sql.substr(begin, pos - begin);
+            for (const auto &i : table)
+                if (previous == i.name) mentioned[i.id] = true;
+        } else {
+            if (c == ';') end_statement();
+            if (c == '*' and (strcasecmp(previous.c_str(), "SELECT") == 0 or previous == ","))
+                std::fill(mentioned.begin(), mentioned.end(), true);
+            if (not std::isspace(c)) previous = std::string(1, c);
+            ++pos;
+        }
+    }
+    end_statement();
+
+    return statements;
+}
+
+std::vector<uint64_t> count_attribute_mentions(const m::Table &table, const std::string &sql) {
+    std::vector<uint64_t> counts(table.size(), 0);
+    for (const auto &ids : statement_attributes(table, sql))
+        for (auto id : ids) ++counts[id];
+    return counts;
+}
+
+bool adapt_to_workload(m::Table &table, const char *path) {
+    auto row_store = dynamic_cast<RowStore *>(&table.store());
+    std::string sql;
+    if (not row_store or not read_file(path, sql)) return false;
+
+    // Split hot and cold attributes of the rows
+    const auto counts = count_attribute_mentions(table, sql);
+    for (std::size_t id = 0; id != counts.size(); ++id)
+        row_store->note_access(id, counts[id]);
+    return row_store->repartition();
+}
+
+bool execute_file_adaptively(m::Diagnostic &diag, m::Table &table, const char *path) {
+    auto adaptive_store = dynamic_cast<AdaptiveStore *>(&table.store());
+    if (not adaptive_store) {
+        m::execute_file(diag, path);
+        return true;
+    }
+
+    std::string sql;
+    if (not read_file(path, sql)) return false;
+    for (const auto &statement : split_statements(sql)) {
+        // The store reconsiders its layout with the statements so far, and swaps in a finished conversion
+        for (const auto &ids : statement_attributes(table, statement))
+            adaptive_store->note_query(ids);
+
+        // Like `m::execute_file()`, report a statement with errors and go on with the next one
+        const auto num_errors = diag.num_errors();
+        std::unique_ptr<m::Stmt> stmt;
+        try {
+            stmt = m::statement_from_string(diag, statement);
+        } catch (const std::exception &) {
+            continue;
+        }
+        if (not stmt or diag.num_errors() != num_errors) continue;
+        m::execute_statement(diag, *stmt);
+    }
+    return true;
+}
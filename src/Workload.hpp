@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutable/mutable.hpp>
+#include <string>
+#include <vector>
+
+
+/** Splits `sql` into its statements, each up to and including its `;`.  A `;` in a string literal or a comment ends no
+ * statement, and statements of nothing but whitespace and comments are left out. */
+std::vector<std::string> split_statements(const std::string &sql);
+
+/** Returns the ids of the attributes of `table` that each statement in `sql` mentions, in ascending order, for every
+ * statement that mentions any.  A `*` in a select list mentions all attributes.  String literals and comments are
+ * skipped. */
+std::vector<std::vector<std::size_t>> statement_attributes(const m::Table &table, const std::string &sql);
+
+/** Counts the statements in `sql` that mention each attribute of `table`, indexed by attribute id.  A `*` in a select
+ * list mentions all attributes.  String literals and comments are skipped. */
+std::vector<uint64_t> count_attribute_mentions(const m::Table &table, const std::string &sql);
+
+/** Notes the attributes of `table` mentioned by the statements in the SQL file at `path` as accesses to its store and
+ * splits its rows into hot and cold attributes, if it is a `RowStore`.  The split is static: it follows the whole file,
+ * before any statement runs.  Returns true iff the store changed. */
+bool adapt_to_workload(m::Table &table, const char *path);
+
+/** Executes the statements of the SQL file at `path`, like `m::execute_file()`.  If `table` is backed by an
+ * `AdaptiveStore`, the statements run one by one, and the attributes each one mentions are noted as a query right
+ * before it runs: the store adapts to the statements executed so far while the file executes.  Returns false if the
+ * file cannot be read. */
+bool execute_file_adaptively(m::Diagnostic &diag, m::Table &table, const char *path);
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+
+/** Summaries of the blocks of `BLOCK_ROWS` rows of an integer attribute: minimum and maximum value and number of NULLs
+ * per block.  A scan for a range of values skips every block whose summary lies outside the range. */
+struct ZoneMap
+{
+    static constexpr std::size_t BLOCK_ROWS = 1024;
+
+    struct Zone
+    {
+        int64_t min = std::numeric_limits<int64_t>::max();
+        int64_t max = std::numeric_limits<int64_t>::min();
+        uint32_t nulls = 0;
+
+        /** Adds a value, or a NULL, to the zone. */
+        void add(int64_t value, bool is_null) {
+            if (is_null) {
+                ++nulls;
+                return;
+            }
+            min = std::min(min, value);
+            max = std::max(max, value);
+        }
+
+        /** Returns true iff a value of the zone may lie in [`lo`, `hi`]. */
+        bool overlaps(int64_t lo, int64_t hi) const { return min <= hi and lo <= max; }
+    };
+
+    private:
+    std::vector<Zone> zones;
+
+    public:
+    /** Returns the number of summarized rows, always a multiple of `BLOCK_ROWS`. */
+    std::size_t size() const { return zones.size() * BLOCK_ROWS; }
+    std::size_t num_blocks() const { return zones.size(); }
+    const Zone &zone(std::size_t block) const { return zones[block]; }
+
+    /** Appends the summary of the next block. */
+    void append(const Zone &zone) { zones.push_back(zone); }
+    /** Forgets the summaries of all blocks that contain row `n` or later rows, e.g. because they changed. */
+    void truncate(std::size_t n) { zones.resize(std::min(zones.size(), n / BLOCK_ROWS)); }
+};
@@ -1,5 +1,9 @@
+#include "AdaptiveStore.hpp"
 #include "ColumnStore.hpp"
+#include "Loader.hpp"
+#include "PaxStore.hpp"
 #include "RowStore.hpp"
+#include "Workload.hpp"
 #include <cerrno>
 #include <cstddef>
 #include <cstdlib>
@@ -11,9 +15,18 @@
 
 int main(int argc, const char **argv)
 {
+    /* With `--no-nulls`, the caller promises that neither the data nor the SQL file contain NULLs. */
+    const char *program = argv[0];
+    const bool no_nulls = argc > 1 and streq(argv[1], "--no-nulls");
+    if (no_nulls) {
+        ++argv;
+        --argc;
+    }
+
     /* Check the number of parameters. */
-    if (argc != 4) {
-        std::cerr << "Usage: " << argv[0] << " <Layout> <CSV-File> <SQL-File>" << std::endl;
+    if (argc != 4 and argc != 5) {
+        std::cerr << "Usage: " << program << " [--no-nulls] <Layout> <CSV-File|Snapshot> <SQL-File> [<Snapshot-Out>]"
+                  << std::endl;
         exit(EXIT_FAILURE);
     }
 
@@ -26,11 +39,17 @@ int main(int argc, const char **argv)
     /* Register our store(s) and set the default store. */
     C.register_store<RowStore>(C.pool("MyRowStore"));
     C.register_store<ColumnStore>(C.pool("MyColStore"));
+    C.register_store<PaxStore>(C.pool("MyPaxStore"));
+    C.register_store<AdaptiveStore>(C.pool("MyAdaptiveStore"));
 
     if (streq(argv[1], "row"))
         C.default_store(C.pool("MyRowStore"));
     else if (streq(argv[1], "column"))
         C.default_store(C.pool("MyColStore"));
+    else if (streq(argv[1], "pax"))
+        C.default_store(C.pool("MyPaxStore"));
+    else if (streq(argv[1], "adaptive"))
+        C.default_store(C.pool("MyAdaptiveStore"));
     else {
         std::cerr << "Unknown data layout '" << argv[1] << '\'' << std::endl;
         exit(EXIT_FAILURE);
@@ -54,14 +73,35 @@ int main(int argc, const char **argv)
     /* Back the table with our store. */
     T.store(C.create_store(T));
 
-    /* Load CSV file into table 'T'. */
-    m::load_from_CSV(diag, T, argv[2], std::numeric_limits<std::size_t>::max(), true, false);
+    /* Restore table 'T' from a snapshot, or load the CSV file into it, presizing the store for its records. */
+    if (not load_CSV_or_snapshot(diag, T, argv[2])) {
+        std::cerr << "Snapshot '" << argv[2] << "' does not match table 'packages'" << std::endl;
+        exit(EXIT_FAILURE);
+    }
 
     if (diag.num_errors())
         exit(EXIT_FAILURE);
 
-    /* Process the SQL file. */
-    m::execute_file(diag, argv[3]);
+    /* Without NULLs, the store gets away without a null bitmap.  Only on request, as the SQL file may insert NULLs
+     * later, which a store without a null bitmap cannot hold. */
+    if (no_nulls)
+        drop_null_bitmap(T);
+
+    /* Move attributes the queries hardly access out of the way of those they scan, once for the whole SQL file. */
+    adapt_to_workload(T, argv[3]);
+
+    /* Write a snapshot, to skip parsing the CSV file next time. */
+    if (argc == 5 and not save_snapshot(T, argv[4])) {
+        std::cerr << "Cannot write snapshot '" << argv[4] << '\'' << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    /* Process the SQL file.  The adaptive store notes every statement as it runs and converts to a better layout on
+     * the way. */
+    if (not execute_file_adaptively(diag, T, argv[3])) {
+        std::cerr << "Cannot read SQL file '" << argv[3] << '\'' << std::endl;
+        exit(EXIT_FAILURE);
+    }
 
     exit(EXIT_SUCCESS);
 }
@@ -1,4 +1,6 @@
 #include "BPlusTree.hpp"
+#include "ColumnStore.hpp"
+#include "Loader.hpp"
 #include <memory>
 #include <mutable/mutable.hpp>
 #include <utility>
@@ -7,8 +9,8 @@
 int main(int argc, char **argv)
 {
     /* Check the number of parameters. */
-    if (argc != 4) {
-        std::cerr << "Usage: " << argv[0] << " <CSV-File> <SIZE-MIN> <SIZE-MAX>" << std::endl;
+    if (argc != 4 and argc != 5) {
+        std::cerr << "Usage: " << argv[0] << " <CSV-File|Snapshot> <SIZE-MIN> <SIZE-MAX> [<Snapshot-Out>]" << std::endl;
         exit(EXIT_FAILURE);
     }
 
@@ -26,6 +28,10 @@ int main(int argc, char **argv)
     /* Create a `m::Diagnostic` object. */
     m::Diagnostic diag(true, std::cout, std::cerr);
 
+    /* Register our column store, which can be restored from a snapshot, and make it the default store. */
+    C.register_store<ColumnStore>(C.pool("MyColStore"));
+    C.default_store(C.pool("MyColStore"));
+
     /* Create database 'dbsys20' and select it. */
     auto &DB = C.add_database(C.pool("dbsys20"));
     C.set_database_in_use(DB);
@@ -44,12 +50,21 @@ int main(int argc, char **argv)
     /* Back the table with our store. */
     T.store(C.create_store(T));
 
-    /* Load CSV file into table 'T'. */
-    m::load_from_CSV(diag, T, argv[1], std::numeric_limits<std::size_t>::max(), true, false);
+    /* Restore table 'T' from a snapshot, or load the CSV file into it, presizing the store for its records. */
+    if (not load_CSV_or_snapshot(diag, T, argv[1])) {
+        std::cerr << "Snapshot '" << argv[1] << "' does not match table 'packages'" << std::endl;
+        exit(EXIT_FAILURE);
+    }
 
     if (diag.num_errors())
         exit(EXIT_FAILURE);
 
+    /* Write a snapshot, to skip parsing the CSV file next time. */
+    if (argc == 5 and not save_snapshot(T, argv[4])) {
+        std::cerr << "Cannot write snapshot '" << argv[4] << '\'' << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
     /* Collect all (size,id) pairs. */
     std::vector<std::pair<int64_t, int32_t>> size2id;
 
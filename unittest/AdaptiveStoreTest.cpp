@@ -0,0 +1,172 @@
+#include "catch.hpp"
+
+#include "AdaptiveStore.hpp"
+#include <cstring>
+#include <mutable/mutable.hpp>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+/** Creates the table `test` with a 4 byte INT `a`, an 8 byte INT `b` and a CHAR(32) `c`, in a new catalog. */
+m::Table &create_table()
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("b"), m::Type::Get_Integer(m::Type::TY_Vector, 8));
+    table.push_back(C.pool("c"), m::Type::Get_Char(m::Type::TY_Vector, 32));
+    return table;
+}
+
+/** Returns the location of attribute `id` in row `row` of the store that currently holds the rows. */
+BitAddress value_location(const AdaptiveStore &store, std::size_t row, std::size_t id)
+{
+    if (store.layout() == AdaptiveStore::Layout::Column)
+        return static_cast<const ColumnStore&>(store.store()).value_location(id, row);
+    return static_cast<const RowStore&>(store.store()).value_location(row, id);
+}
+
+/** Like mutable, appends a row and writes its values afterwards. */
+void append_row(AdaptiveStore &store, int32_t i)
+{
+    store.append();
+    const std::size_t row = store.num_rows() - 1;
+    const int64_t b = int64_t(i) * 3;
+    const std::string c = "row " + std::to_string(i);
+    memcpy(value_location(store, row, 0).base, &i, sizeof(i));
+    memcpy(value_location(store, row, 1).base, &b, sizeof(b));
+    memcpy(value_location(store, row, 2).base, c.c_str(), c.size() + 1);
+}
+
+bool check_row(const AdaptiveStore &store, int32_t i)
+{
+    const std::string c = "row " + std::to_string(i);
+    return load_integer(value_location(store, i, 0).base, 4) == i and
+           load_integer(value_location(store, i, 1).base, 8) == int64_t(i) * 3 and
+           c == reinterpret_cast<const char*>(value_location(store, i, 2).base);
+}
+
+}
+
+TEST_CASE("AdaptiveStore/c'tor", "[milestone1]")
+{
+    auto &table = create_table();
+    table.store(std::make_unique<AdaptiveStore>(table));
+    auto &store = static_cast<AdaptiveStore&>(table.store());
+
+    CHECK(store.num_rows() == 0);
+    CHECK(store.layout() == AdaptiveStore::Layout::Row);
+    CHECK_FALSE(store.converting());
+    CHECK(store.transitions().empty());
+    CHECK(table.store().linearization().num_sequences() == store.store().linearization().num_sequences());
+
+    /* Without queries, there is nothing to adapt to. */
+    CHECK_FALSE(store.adapt(true));
+    CHECK(store.layout() == AdaptiveStore::Layout::Row);
+}
+
+TEST_CASE("AdaptiveStore/adapt", "[milestone1]")
+{
+    auto &table = create_table();
+    AdaptiveStore::Options options;
+    options.initial = AdaptiveStore::Layout::Column;
+    options.background = false;
+    table.store(std::make_unique<AdaptiveStore>(table, options));
+    auto &store = static_cast<AdaptiveStore&>(table.store());
+
+    constexpr int32_t NUM_ROWS = 1000;
+    for (int32_t i = 0; i != NUM_ROWS; ++i)
+        append_row(store, i);
+
+    /* Queries reading whole rows touch fewer bytes in rows than in columns stitched back together. */
+    for (std::size_t q = 0; q != options.min_queries - 1; ++q)
+        store.note_query({ 2, 0, 1 });
+    CHECK(store.layout() == AdaptiveStore::Layout::Column); // not reconsidered yet
+    store.note_query({ 0, 1, 2 });
+    CHECK(store.layout() == AdaptiveStore::Layout::Row);
+    CHECK(store.cost(AdaptiveStore::Layout::Row) <= (1 - options.min_gain) * store.cost(AdaptiveStore::Layout::Column));
+    REQUIRE(store.transitions().size() == 1);
+    CHECK(store.transitions()[0].from == AdaptiveStore::Layout::Column);
+    CHECK(store.transitions()[0].to == AdaptiveStore::Layout::Row);
+    CHECK(store.transitions()[0].rows == NUM_ROWS);
+    CHECK(table.store().linearization().num_sequences() == store.store().linearization().num_sequences());
+
+    /* The conversion keeps every row, and rows are appended to the new store. */
+    REQUIRE(store.num_rows() == NUM_ROWS);
+    append_row(store, NUM_ROWS);
+    for (int32_t i = 0; i <= NUM_ROWS; ++i)
+        REQUIRE(check_row(store, i));
+
+    /* Queries that read `a` far more often than `b` and never `c` move `b` and `c` out of the way. */
+    for (std::size_t q = 0; q != 20 * options.min_queries; ++q)
+        store.note_query({ 0 });
+    CHECK(store.layout() == AdaptiveStore::Layout::Hybrid);
+    CHECK(store.transitions().back().to == AdaptiveStore::Layout::Hybrid);
+    const auto num_transitions = store.transitions().size();
+    for (int32_t i = 0; i <= NUM_ROWS; ++i)
+        REQUIRE(check_row(store, i));
+
+    /* Once the layout fits, it stays. */
+    CHECK_FALSE(store.adapt(true));
+    CHECK(store.transitions().size() == num_transitions);
+}
+
+TEST_CASE("AdaptiveStore/background conversion", "[milestone1]")
+{
+    auto &table = create_table();
+    AdaptiveStore::Options options;
+    options.initial = AdaptiveStore::Layout::Column;
+    table.store(std::make_unique<AdaptiveStore>(table, options));
+    auto &store = static_cast<AdaptiveStore&>(table.store());
+
+    constexpr int32_t NUM_ROWS = 100000;
+    int32_t i = 0;
+    for (; i != NUM_ROWS / 2; ++i)
+        append_row(store, i);
+
+    /* Rows appended while the rows are copied in the background end up in the new store as well. */
+    for (std::size_t q = 0; q != options.min_queries; ++q)
+        store.note_query({ 0, 1, 2 });
+    for (; i != NUM_ROWS; ++i)
+        append_row(store, i);
+    store.adapt(true);
+    CHECK_FALSE(store.converting());
+    CHECK(store.layout() == AdaptiveStore::Layout::Row);
+    CHECK(store.transitions().size() == 1);
+
+    REQUIRE(store.num_rows() == NUM_ROWS);
+    for (int32_t row = 0; row != NUM_ROWS; ++row)
+        REQUIRE(check_row(store, row));
+}
+
+TEST_CASE("AdaptiveStore/drop while converting", "[milestone1]")
+{
+    auto &table = create_table();
+    AdaptiveStore::Options options;
+    options.row.chunked = true;
+    options.row.block_bytes = 1UL << 16;
+    table.store(std::make_unique<AdaptiveStore>(table, options));
+    auto &store = static_cast<AdaptiveStore&>(table.store());
+
+    constexpr int32_t NUM_ROWS = 100000;
+    for (int32_t i = 0; i != NUM_ROWS; ++i)
+        append_row(store, i);
+
+    /* Dropping releases whole blocks of the chunked store, so the first drop waits for the copy and swaps it in. */
+    for (std::size_t q = 0; q != options.min_queries; ++q)
+        store.note_query({ 0 });
+    for (int32_t i = 0; i != NUM_ROWS / 2; ++i)
+        store.drop();
+    CHECK_FALSE(store.converting());
+    CHECK(store.layout() != AdaptiveStore::Layout::Row);
+    REQUIRE(store.transitions().size() == 1);
+    CHECK(store.transitions()[0].rows == NUM_ROWS);
+
+    REQUIRE(store.num_rows() == NUM_ROWS / 2);
+    for (int32_t row = 0; row != NUM_ROWS / 2; ++row)
+        REQUIRE(check_row(store, row));
+}
@@ -0,0 +1,182 @@
+#include "catch.hpp"
+
+#include "Allocator.hpp"
+#include "BPlusTree.hpp"
+#include "ColumnStore.hpp"
+#include "RowStore.hpp"
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutable/mutable.hpp>
+#include <vector>
+
+
+namespace {
+
+bool is_aligned(const void *p, std::size_t alignment) { return reinterpret_cast<uintptr_t>(p) % alignment == 0; }
+
+}
+
+TEST_CASE("Allocator/arena", "[milestone1]")
+{
+    memory::ArenaAllocator arena(1UL << 16);
+
+    /* Small allocations are bumped back to back through a chunk. */
+    std::vector<void*> small;
+    for (int i = 0; i != 1000; ++i) {
+        void *p = arena.allocate(24, 8);
+        REQUIRE(is_aligned(p, 8));
+        memset(p, i, 24);
+        small.push_back(p);
+    }
+    CHECK(static_cast<uint8_t *>(small[1]) - static_cast<uint8_t *>(small[0]) == 24);
+    auto stats = arena.statistics();
+    CHECK(stats.allocations == 1000);
+    CHECK(stats.allocated_bytes == 24000);
+    CHECK(stats.peak_bytes == 24000);
+    CHECK(stats.reserved_bytes == 1UL << 16);
+    CHECK(stats.fragmentation() > 0);
+    CHECK(stats.fragmentation() < 1);
+
+    /* The last allocation grows in place and is taken back when freed. */
+    void *last = arena.allocate(100, 64);
+    CHECK(is_aligned(last, 64));
+    CHECK(arena.reallocate(last, 100, 200, 64) == last);
+    arena.deallocate(last, 200, 64);
+    CHECK(arena.allocate(50, 64) == last);
+
+    /* Large allocations get a mapping of their own, which grows without copying on Linux and is unmapped when freed. */
+    void *large = arena.allocate(1UL << 20, 64);
+    memset(large, 1, 1UL << 20);
+    std::size_t copied = 0;
+    large = arena.reallocate(large, 1UL << 20, 1UL << 22, 64, &copied);
+#ifdef __linux__
+    CHECK(copied == 0);
+#endif
+    CHECK(static_cast<uint8_t *>(large)[(1UL << 20) - 1] == 1);
+    const auto reserved = arena.statistics().reserved_bytes;
+    arena.deallocate(large, 1UL << 22, 64);
+    CHECK(arena.statistics().reserved_bytes == reserved - (1UL << 22));
+
+    /* Resetting frees everything at once. */
+    arena.reset();
+    stats = arena.statistics();
+    CHECK(stats.allocated_bytes == 0);
+    CHECK(stats.reserved_bytes == 1UL << 16);
+    CHECK(arena.frees_in_bulk());
+}
+
+TEST_CASE("Allocator/pool", "[milestone1]")
+{
+    CHECK(memory::PoolAllocator::size_class(1, 1) == memory::PoolAllocator::MIN_CLASS_BYTES);
+    CHECK(memory::PoolAllocator::size_class(17, 8) == 32);
+    CHECK(memory::PoolAllocator::size_class(20, 64) == 64);
+
+    memory::PoolAllocator pool(4096, 1UL << 16);
+
+    /* Freed blocks are reused by the next allocation of their class. */
+    void *p = pool.allocate(40, 8);
+    pool.deallocate(p, 40, 8);
+    CHECK(pool.allocate(60, 8) == p);
+
+    /* Resizing within a class never moves, resizing beyond it does. */
+    CHECK(pool.reallocate(p, 60, 64, 8) == p);
+    memset(p, 7, 64);
+    void *q = pool.reallocate(p, 64, 100, 8);
+    CHECK(q != p);
+    CHECK(static_cast<uint8_t *>(q)[63] == 7);
+
+    /* Allocations beyond the largest class come from the system. */
+    void *large = pool.allocate(10000, 64);
+    CHECK(is_aligned(large, 64));
+    memset(large, 0, 10000);
+    pool.deallocate(large, 10000, 64);
+    pool.deallocate(q, 100, 8);
+
+    auto stats = pool.statistics();
+    CHECK(stats.allocations == 3);
+    CHECK(stats.reallocations == 2);
+    CHECK(stats.deallocations == 3);
+    CHECK(stats.allocated_bytes == 0);
+    CHECK(stats.peak_bytes >= 10000);
+    CHECK(stats.fragmentation() == 1);
+}
+
+TEST_CASE("Allocator/system", "[milestone1]")
+{
+    memory::SystemAllocator allocator(memory::Backend::Mmap);
+    void *p = allocator.allocate(5000, 64);
+    CHECK(allocator.statistics().reserved_bytes == memory::round_up(5000, memory::page_size()));
+    p = allocator.reallocate(p, 5000, 100000, 64);
+    memset(p, 0, 100000);
+    allocator.deallocate(p, 100000, 64);
+
+    const auto stats = allocator.statistics();
+    CHECK(stats.allocated_bytes == 0);
+    CHECK(stats.reserved_bytes == 0);
+    CHECK(stats.peak_bytes == 100000);
+    CHECK_FALSE(allocator.frees_in_bulk());
+}
+
+TEST_CASE("Allocator/stores", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("b"), m::Type::Get_Integer(m::Type::TY_Vector, 8));
+
+    /* Both stores of a table draw their buffers from one arena. */
+    auto arena = std::make_shared<memory::ArenaAllocator>();
+    {
+        RowStore::Options row_options;
+        row_options.allocation.allocator = arena;
+        RowStore row_store(table, row_options);
+        ColumnStore::Options column_options;
+        column_options.allocation.allocator = arena;
+        ColumnStore column_store(table, column_options);
+
+        row_store.append(10000);
+        column_store.append(10000);
+        for (std::size_t row = 0; row != 10000; ++row) {
+            const int32_t a = int32_t(row);
+            const auto row_a = row_store.value_location(row, 0), column_a = column_store.value_location(0, row);
+            memcpy(row_a.base + row_a.bit / 8, &a, sizeof(a));
+            memcpy(column_a.base + column_a.bit / 8, &a, sizeof(a));
+        }
+        CHECK(is_aligned(column_store.values(0), ColumnStore::ALIGNMENT));
+        CHECK(arena->statistics().allocated_bytes >= 10000 * (4 + 8 + 4 + 8));
+        CHECK(arena->statistics().reallocations > 0);
+        for (std::size_t row = 0; row != 10000; row += 999) {
+            const auto row_a = row_store.value_location(row, 0);
+            CHECK(load_integer(row_a.base + row_a.bit / 8, 4) == int64_t(row));
+            CHECK(load_integer(column_store.values(0, row), 4) == int64_t(row));
+        }
+    }
+    CHECK(arena->statistics().allocated_bytes == 0);
+
+    /* A tree drawing its nodes from an arena leaves them to the arena. */
+    using btree_type = BPlusTree<int32_t, int32_t>;
+    std::vector<btree_type::value_type> data;
+    for (int32_t i = 0; i != 10000; ++i)
+        data.emplace_back(2 * i, i);
+    {
+        auto tree = btree_type::Bulkload(data, arena);
+        CHECK(tree.node_allocator() == arena);
+        CHECK(tree.size() == 10000);
+        CHECK(tree.find(2 * 4711)->second == 4711);
+        CHECK(tree.find(2 * 4711 + 1) == tree.end());
+    }
+    CHECK(arena->statistics().allocated_bytes > 0);
+
+    /* A pool takes the nodes back one by one. */
+    auto pool = std::make_shared<memory::PoolAllocator>();
+    {
+        auto tree = btree_type::Bulkload(data, pool);
+        CHECK(tree.size() == 10000);
+        CHECK(pool->statistics().allocations > 10000 / 8);
+    }
+    CHECK(pool->statistics().allocated_bytes == 0);
+}
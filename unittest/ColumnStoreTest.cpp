@@ -1,9 +1,19 @@
 #include "catch.hpp"
 
 #include "ColumnStore.hpp"
+#include "Loader.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
 #include <mutable/mutable.hpp>
 #include <sstream>
+#include <string>
+#include <thread>
 #include <utility>
+#include <vector>
 
 
 TEST_CASE("ColumnStore/c'tor", "[milestone1]")
@@ -145,3 +155,1176 @@ TEST_CASE("ColumnStore/access", "[milestone1]")
         REQUIRE(num_tuples == 3);
     }
 }
+
+TEST_CASE("ColumnStore/segmented", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("b"), m::Type::Get_Integer(m::Type::TY_Vector, 1));
+
+    ColumnStore::Options options;
+    options.segmented = true;
+    options.segment_rows = 1000; // rounded up to 1024
+    table.store(std::make_unique<ColumnStore>(table, options));
+
+    auto &lin = table.store().linearization();
+
+    /* Root must be an infinite sequence of segments per column and the null bitmap. */
+    CHECK(lin.num_tuples() == 0); // infinite sequence
+    REQUIRE(lin.num_sequences() == 3);
+
+    auto it = lin.begin();
+    const auto &seq_a = *it++;
+    REQUIRE(seq_a.is_linearization());
+    CHECK(seq_a.stride == 8192); // 1024 rows of 4 bytes and the padding, whole pages
+    CHECK(seq_a.as_linearization().num_tuples() == 1024);
+    CHECK((*seq_a.as_linearization().begin()).stride == 4);
+
+    /* Segments of narrower columns are smaller, but still start at page boundaries. */
+    const auto &seq_b = *it++;
+    REQUIRE(seq_b.is_linearization());
+    CHECK(seq_b.stride % 4096 == 0);
+    CHECK(seq_b.as_linearization().num_tuples() == 1024);
+    CHECK((*seq_b.as_linearization().begin()).stride == 1);
+
+    /* Fill several segments, the linearization must not be replaced and no column is copied. */
+    auto &store = static_cast<ColumnStore&>(table.store());
+    {
+        m::StoreWriter W(store);
+        m::Tuple tup(W.schema());
+        for (int32_t i = 0; i != 5000; ++i) {
+            tup.set(0, i);
+            tup.set(1, int8_t(i));
+            W.append(tup);
+        }
+    }
+    REQUIRE(store.num_rows() == 5000);
+    CHECK(&store.linearization() == &lin);
+    CHECK(store.statistics().capacity == 5 * 1024);
+    CHECK(store.statistics().copied_bytes == 0);
+    CHECK(store.statistics().linearizations == 1);
+
+    C.set_database_in_use(DB);
+    std::ostringstream out, err;
+    m::Diagnostic diag(false, out, err);
+
+    auto stmt = m::statement_from_string(diag, "SELECT a, b FROM test;");
+    REQUIRE(diag.num_errors() == 0);
+
+    int32_t expected = 0;
+    auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema&, const m::Tuple &T) {
+        CHECK(T.get(0).as_i() == expected);
+        CHECK(T.get(1).as_i() == int8_t(expected));
+        ++expected;
+    });
+
+    std::unique_ptr<m::SelectStmt> select_stmt(static_cast<m::SelectStmt*>(stmt.release()));
+    m::execute_query(diag, *select_stmt, std::move(callback));
+    REQUIRE(diag.num_errors() == 0);
+    REQUIRE(expected == 5000);
+
+    /* Rows in later segments are compacted into earlier ones. */
+    store.erase(10);
+    store.compact();
+    CHECK(store.num_rows() == 4999);
+    int64_t moved = 0;
+    store.scan(0, [&](std::size_t first, const int64_t *values, std::size_t n) {
+        if (first <= 10 and 10 < first + n) moved = values[10 - first];
+    });
+    CHECK(moved == 4999);
+
+    /* Dropping rows releases the trailing segments again, keeping one spare. */
+    while (store.num_rows() != 1000)
+        store.drop();
+    CHECK(store.statistics().capacity == 2 * 1024);
+    CHECK(&store.linearization() == &lin);
+}
+
+TEST_CASE("ColumnStore/concurrent appends", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("b"), m::Type::Get_Integer(m::Type::TY_Vector, 2));
+
+    /* Only a segmented store never moves its rows while writers fill them. */
+    {
+        ColumnStore plain(table);
+        CHECK_THROWS_AS(plain.begin_concurrent_appends(), std::logic_error);
+    }
+
+    ColumnStore::Options options;
+    options.segmented = true;
+    options.segment_rows = 1024;
+    table.store(std::make_unique<ColumnStore>(table, options));
+    auto &store = static_cast<ColumnStore&>(table.store());
+    auto &lin = store.linearization();
+    store.append(100);
+    for (std::size_t row = 0; row != 100; ++row) {
+        const int32_t a = -1;
+        memcpy(store.value_location(0, row).base, &a, sizeof(a));
+        auto null_b = store.null_location(1, row);
+        set_bit(null_b.base, null_b.bit, true);
+    }
+
+    /* Writers fill batches of rows independently, a reader sees only completely written rows below the watermark. */
+    constexpr int32_t NUM_THREADS = 4, NUM_BATCHES = 60, BATCH_ROWS = 37;
+    store.begin_concurrent_appends();
+    std::atomic<bool> done(false), torn(false), receded(false);
+    std::thread reader([&]() {
+        std::size_t seen = 0;
+        while (not done.load()) {
+            const std::size_t visible = store.num_rows();
+            if (visible < seen) receded = true;
+            for (std::size_t row = seen; row != visible; ++row)
+                if (load_integer(store.values(0, row), 4) == 0) torn = true;
+            seen = visible;
+        }
+    });
+    std::vector<std::thread> writers;
+    for (int32_t t = 0; t != NUM_THREADS; ++t) {
+        writers.emplace_back([&, t]() {
+            for (int32_t batch = 0; batch != NUM_BATCHES; ++batch) {
+                const auto first = store.claim_rows(BATCH_ROWS);
+                for (int32_t i = 0; i != BATCH_ROWS; ++i) {
+                    const int32_t a = (t * NUM_BATCHES + batch) * BATCH_ROWS + i + 1;
+                    const int16_t b = int16_t(i);
+                    memcpy(store.value_location(0, first + i).base, &a, sizeof(a));
+                    memcpy(store.value_location(1, first + i).base, &b, sizeof(b));
+                    auto null_a = store.null_location(0, first + i), null_b = store.null_location(1, first + i);
+                    set_bit(null_a.base, null_a.bit, false);
+                    set_bit(null_b.base, null_b.bit, i % 2 != 0);
+                }
+                store.publish_rows(first, BATCH_ROWS);
+            }
+        });
+    }
+    for (auto &w : writers) w.join();
+    done = true;
+    reader.join();
+    CHECK_FALSE(torn);
+    CHECK_FALSE(receded);
+
+    const std::size_t total = 100 + NUM_THREADS * NUM_BATCHES * BATCH_ROWS;
+    CHECK(store.num_rows() == total);
+    store.end_concurrent_appends();
+    REQUIRE(store.num_rows() == total);
+    CHECK(&store.linearization() == &lin);
+    CHECK(store.statistics().copied_bytes == 0);
+
+    /* Every value was appended exactly once, and the store keeps working as usual. */
+    std::vector<int64_t> values;
+    store.scan(0, [&](std::size_t, const int64_t *v, std::size_t n) { values.insert(values.end(), v, v + n); });
+    std::sort(values.begin(), values.end());
+    REQUIRE(values.size() == total);
+    CHECK(std::all_of(values.begin(), values.begin() + 100, [](int64_t v) { return v == -1; }));
+    for (std::size_t i = 100; i != total; ++i)
+        CHECK(values[i] == int64_t(i - 99));
+    CHECK(store.nulls(1)->count() == 100 + NUM_THREADS * NUM_BATCHES * (BATCH_ROWS / 2));
+    store.append();
+    CHECK(store.num_rows() == total + 1);
+}
+
+TEST_CASE("ColumnStore/read view", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("b"), m::Type::Get_Integer(m::Type::TY_Vector, 8));
+
+    ColumnStore::Options options;
+    options.concurrent_readers = true;
+    table.store(std::make_unique<ColumnStore>(table, options));
+    auto &store = static_cast<ColumnStore&>(table.store());
+
+    /* Like mutable, write the values of a row after appending it.  The rows before the last one are committed. */
+    auto append_row = [&store](int32_t i) {
+        store.append();
+        const int64_t b = int64_t(i) * 3;
+        memcpy(store.value_location(0, i).base, &i, sizeof(i));
+        memcpy(store.value_location(1, i).base, &b, sizeof(b));
+    };
+    for (int32_t i = 0; i != 3; ++i)
+        append_row(i);
+    CHECK(store.committed_rows() == 2);
+    store.commit_rows();
+    CHECK(store.committed_rows() == 3);
+
+    auto check_row = [](const ColumnStore::ReadView &view, std::size_t row) {
+        return load_integer(view.values(0, row), 4) == int64_t(row) and
+               load_integer(view.values(1, row), 8) == int64_t(row) * 3;
+    };
+
+    /* A view keeps reading the rows it saw, although the store moves them to grow. */
+    {
+        auto view = store.read_view();
+        REQUIRE(view.num_rows() == 3);
+        for (int32_t i = 3; i != 1000; ++i)
+            append_row(i);
+        CHECK(store.statistics().grow_reallocations > 5);
+        for (std::size_t row = 0; row != view.num_rows(); ++row)
+            CHECK(check_row(view, row));
+    }
+
+    /* Readers take views while a writer appends, and never see a row that is not written completely. */
+    constexpr int32_t NUM_ROWS = 200000;
+    std::atomic<bool> done(false), torn(false), receded(false);
+    std::vector<std::thread> readers;
+    for (int r = 0; r != 3; ++r) {
+        readers.emplace_back([&]() {
+            std::size_t seen = 0;
+            while (not done.load()) {
+                auto view = store.read_view();
+                const std::size_t rows = view.num_rows();
+                if (rows < seen) receded = true;
+                for (std::size_t row = seen; row < rows; row += 97)
+                    if (not check_row(view, row)) torn = true;
+                if (rows and not check_row(view, rows - 1)) torn = true;
+                seen = rows;
+            }
+        });
+    }
+    for (int32_t i = 1000; i != NUM_ROWS; ++i)
+        append_row(i);
+    store.commit_rows();
+    done = true;
+    for (auto &r : readers) r.join();
+    CHECK_FALSE(torn);
+    CHECK_FALSE(receded);
+
+    auto view = store.read_view();
+    REQUIRE(view.num_rows() == NUM_ROWS);
+    for (std::size_t row = 0; row != NUM_ROWS; ++row)
+        REQUIRE(check_row(view, row));
+}
+
+TEST_CASE("ColumnStore/read view stress", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+
+    /* Growing copies the rows to new buffers and unmaps the old ones.  A reader that took a view of an old buffer
+     * after it was retired would read unmapped memory. */
+    ColumnStore::Options options;
+    options.concurrent_readers = true;
+    options.allocation.backend = memory::Backend::Mmap;
+    for (int round = 0; round != 20; ++round) {
+        table.store(std::make_unique<ColumnStore>(table, options));
+        auto &store = static_cast<ColumnStore&>(table.store());
+
+        std::atomic<bool> done(false), torn(false);
+        std::size_t num_views = 0;
+        std::thread reader([&]() {
+            while (not done.load()) {
+                auto view = store.read_view();
+                const std::size_t rows = view.num_rows();
+                ++num_views;
+                if (rows and (load_integer(view.values(0, 0), 4) != 0 or
+                              load_integer(view.values(0, rows - 1), 4) != int64_t(rows - 1)))
+                    torn = true;
+            }
+        });
+        for (int32_t i = 0; i != 100000; ++i) {
+            store.append();
+            memcpy(store.value_location(0, i).base, &i, sizeof(i));
+        }
+        done = true;
+        reader.join();
+        CHECK_FALSE(torn);
+        CHECK(num_views > 0);
+        CHECK(store.statistics().grow_reallocations > 5);
+    }
+}
+
+TEST_CASE("ColumnStore/alignment", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 1));
+    table.push_back(C.pool("b"), m::Type::Get_Integer(m::Type::TY_Vector, 8));
+
+    ColumnStore::Options options;
+    SECTION("malloc") { }
+    SECTION("mmap") { options.allocation.backend = memory::Backend::Mmap; }
+    SECTION("segmented") { options.segmented = true; options.segment_rows = 1024; }
+    table.store(std::make_unique<ColumnStore>(table, options));
+    auto &store = static_cast<ColumnStore&>(table.store());
+
+    auto is_aligned = [](const void *p) { return reinterpret_cast<uintptr_t>(p) % ColumnStore::ALIGNMENT == 0; };
+
+    /* Columns stay aligned while growing, and so does every segment. */
+    m::StoreWriter W(store);
+    m::Tuple tup(W.schema());
+    for (int32_t i = 0; i != 3000; ++i) {
+        tup.set(0, int8_t(i));
+        tup.set(1, int64_t(i));
+        W.append(tup);
+        if (i % 500 == 0) {
+            CHECK(is_aligned(store.values(0)));
+            CHECK(is_aligned(store.values(1)));
+            CHECK(is_aligned(store.null_bitmap()));
+        }
+    }
+    CHECK(is_aligned(store.values(0, 2048)));
+    CHECK(is_aligned(store.values(1, 2048)));
+
+    /* Runs of contiguous rows end at segments, and the padding after them is readable. */
+    std::size_t row = 0;
+    int64_t sum = 0;
+    while (row != store.num_rows()) {
+        const auto n = store.contiguous_rows(row);
+        REQUIRE(n != 0);
+        auto values = reinterpret_cast<const int64_t *>(store.values(1, row));
+        for (std::size_t i = 0; i != n; ++i) sum += values[i];
+        volatile uint8_t past_end = store.values(0, row)[n + ColumnStore::PADDING_BYTES - 1];
+        (void) past_end;
+        row += n;
+    }
+    CHECK(sum == 3000 * 2999 / 2);
+}
+
+TEST_CASE("ColumnStore/filter", "[milestone1]")
+{
+    using predicate::Comparison;
+
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("id"), m::Type::Get_Integer(m::Type::TY_Vector, 2));
+    table.push_back(C.pool("size"), m::Type::Get_Double(m::Type::TY_Vector));
+    table.push_back(C.pool("repo"), m::Type::Get_Char(m::Type::TY_Vector, 10));
+    C.set_database_in_use(DB);
+
+    ColumnStore::Options options;
+    SECTION("contiguous") { }
+    SECTION("segmented") { options.segmented = true; options.segment_rows = 1024; }
+    table.store(std::make_unique<ColumnStore>(table, options));
+    auto &store = static_cast<ColumnStore&>(table.store());
+
+    std::ostringstream out, err;
+    m::Diagnostic diag(false, out, err);
+
+    /* Three repos, every fourth repo NULL, spanning several segments. */
+    const char *repos[] = { "\"core\"", "\"extra\"", "\"community\"", "NULL" };
+    constexpr int NUM_ROWS = 2500;
+    std::string insertions = "INSERT INTO test VALUES ";
+    for (int i = 0; i != NUM_ROWS; ++i)
+        insertions += (i ? ", (" : "(") + std::to_string(i) + ", " + std::to_string(i / 2.) + ", " + repos[i % 4] +
+                      ")";
+    m::execute_statement(diag, *m::statement_from_string(diag, insertions + ";"));
+    REQUIRE(diag.num_errors() == 0);
+
+    auto check = [&](const RowBitmap &bitmap, auto &&expected) {
+        REQUIRE(bitmap.num_rows == NUM_ROWS);
+        std::size_t n = 0;
+        for (int i = 0; i != NUM_ROWS; ++i) {
+            n += expected(i);
+            if (bitmap.test(i) != expected(i)) {
+                FAIL("row " << i);
+            }
+        }
+        CHECK(bitmap.count() == n);
+    };
+
+    check(store.filter(0, Comparison::Less, 100), [](int i) { return i < 100; });
+    check(store.filter(0, Comparison::Between, 1000, 2047), [](int i) { return 1000 <= i and i <= 2047; });
+    check(store.filter(0, Comparison::NotEqual, 7), [](int i) { return i != 7; });
+    check(store.filter(0, Comparison::Greater, int64_t(1) << 40), [](int) { return false; }); // beyond INT(2)
+    check(store.filter(0, Comparison::GreaterEqual, -(int64_t(1) << 40)), [](int) { return true; });
+    check(store.filter(1, Comparison::GreaterEqual, 1000.5), [](int i) { return i >= 2001; });
+    check(store.filter(2, Comparison::Equal, "extra"), [](int i) { return i % 4 == 1; });
+    check(store.filter(2, Comparison::NotEqual, "core"), [](int i) { return i % 4 == 1 or i % 4 == 2; }); // not NULL
+    check(store.filter(2, Comparison::Less, "d"), [](int i) { return i % 4 == 0 or i % 4 == 2; });
+    CHECK_THROWS_AS(store.filter(2, Comparison::Equal, 1), std::invalid_argument);
+
+    /* Bitmaps compose into conjunctions and disjunctions. */
+    auto conjunction = store.filter(2, Comparison::Equal, "core");
+    conjunction &= store.filter(0, Comparison::Less, 1000);
+    check(conjunction, [](int i) { return i % 4 == 0 and i < 1000; });
+    auto disjunction = store.filter(0, Comparison::Equal, 3);
+    disjunction |= store.filter(1, Comparison::Less, 1.);
+    const auto selection = disjunction.to_selection();
+    CHECK(selection == Selection{ 0, 1, 3 });
+
+    /* Dead rows never qualify. */
+    store.erase(5);
+    CHECK_FALSE(store.filter(2, Comparison::Equal, "extra").test(5));
+}
+
+TEST_CASE("ColumnStore/null columns", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("b"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.store(std::make_unique<ColumnStore>(table));
+    auto &store = static_cast<ColumnStore&>(table.store());
+
+    /* 'b' is NULL in every third row, 'a' never. */
+    {
+        m::StoreWriter W(store);
+        m::Tuple tup(W.schema());
+        for (int32_t i = 0; i != 300; ++i) {
+            tup.set(0, i);
+            if (i % 3 == 0)
+                tup.null(1);
+            else
+                tup.set(1, i);
+            W.append(tup);
+        }
+    }
+
+    /* Attributes without NULLs have no null bitmap of their own. */
+    CHECK(store.nulls(0) == nullptr);
+    const NullBitmap *nulls = store.nulls(1);
+    REQUIRE(nulls != nullptr);
+    CHECK(nulls->count() == 100);
+    CHECK(nulls->num_words() == 5);
+    for (int32_t i = 0; i != 300; ++i)
+        CHECK(nulls->is_null(i) == (i % 3 == 0));
+
+    /* Compaction moves the null bits along with the row: row 297 moves into row 1. */
+    store.erase(1);
+    store.erase(298);
+    store.erase(299);
+    store.compact();
+    REQUIRE(store.num_rows() == 297);
+    CHECK(store.nulls(1)->is_null(1));
+    CHECK(store.nulls(1)->count() == 100);
+
+    /* Dropping rows forgets their bits. */
+    for (int i = 0; i != 200; ++i)
+        store.drop();
+    CHECK(store.nulls(1)->count() == 34); // rows 0, 3, ..., 96 and row 1
+    CHECK(store.nulls(1)->num_words() == 2);
+}
+
+TEST_CASE("ColumnStore/project", "[milestone1]")
+{
+    using predicate::Comparison;
+
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("id"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("size"), m::Type::Get_Integer(m::Type::TY_Vector, 8));
+    table.push_back(C.pool("name"), m::Type::Get_Char(m::Type::TY_Vector, 8));
+    C.set_database_in_use(DB);
+
+    ColumnStore::Options options;
+    SECTION("contiguous") { }
+    SECTION("segmented") { options.segmented = true; options.segment_rows = 1024; }
+    table.store(std::make_unique<ColumnStore>(table, options));
+    auto &store = static_cast<ColumnStore&>(table.store());
+
+    std::ostringstream out, err;
+    m::Diagnostic diag(false, out, err);
+
+    /* Every tenth name is NULL. */
+    std::string insertions = "INSERT INTO test VALUES ";
+    for (int i = 0; i != 3000; ++i) {
+        const std::string name = i % 10 ? "\"n" + std::to_string(i) + "\"" : "NULL";
+        insertions += (i ? ", (" : "(") + std::to_string(i) + ", " + std::to_string(i * 1000) + ", " + name + ")";
+    }
+    m::execute_statement(diag, *m::statement_from_string(diag, insertions + ";"));
+    REQUIRE(diag.num_errors() == 0);
+
+    /* Filter on 'size', then gather 'id' and 'name' of the qualifying rows only. */
+    const auto projection = store.project(store.filter(1, Comparison::GreaterEqual, 2990 * 1000), { 0, 2 });
+    REQUIRE(projection.rows == Selection{ 2990, 2991, 2992, 2993, 2994, 2995, 2996, 2997, 2998, 2999 });
+    REQUIRE(projection.columns.size() == 2);
+    REQUIRE(projection.columns[0].size() == 10 * 4);
+    REQUIRE(projection.columns[1].size() == 10 * 8);
+    for (std::size_t j = 0; j != projection.rows.size(); ++j) {
+        int32_t id;
+        memcpy(&id, projection.columns[0].data() + 4 * j, 4);
+        CHECK(id == int32_t(projection.rows[j]));
+        if (j == 0) continue; // NULL
+        const std::string name(reinterpret_cast<const char *>(projection.columns[1].data() + 8 * j));
+        CHECK(name == "n" + std::to_string(projection.rows[j]));
+    }
+
+    /* Only attributes with NULLs get a null bitmap. */
+    CHECK(projection.nulls[0].words.empty());
+    REQUIRE(projection.nulls[1].num_rows == 10);
+    CHECK(projection.nulls[1].test(0));
+    CHECK(projection.nulls[1].count() == 1);
+
+    /* Sparse rows are gathered in the order of the selection. */
+    Selection every_seventh;
+    for (uint32_t row = 0; row < 3000; row += 7)
+        every_seventh.push_back(row);
+    std::vector<int64_t> sizes(every_seventh.size());
+    store.gather(1, every_seventh, sizes.data());
+    for (std::size_t j = 0; j != sizes.size(); ++j)
+        CHECK(sizes[j] == int64_t(every_seventh[j]) * 1000);
+}
+
+TEST_CASE("ColumnStore/reserve", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("b"), m::Type::Get_Double(m::Type::TY_Vector));
+    table.store(std::make_unique<ColumnStore>(table));
+
+    auto &store = static_cast<ColumnStore&>(table.store());
+    store.reserve(1000);
+    const auto address = (*store.linearization().begin()).offset;
+
+    /* Appending up to the reserved number of rows must not move the columns. */
+    store.append(600);
+    CHECK(store.num_rows() == 600);
+    for (int i = 0; i != 400; ++i)
+        store.append();
+    CHECK(store.num_rows() == 1000);
+    CHECK((*store.linearization().begin()).offset == address);
+
+    /* Appending beyond grows the store. */
+    store.append(1000);
+    CHECK(store.num_rows() == 2000);
+}
+
+TEST_CASE("ColumnStore/mmap", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("b"), m::Type::Get_Integer(m::Type::TY_Vector, 8));
+
+    ColumnStore::Options options;
+    options.allocation.backend = memory::Backend::Mmap;
+    options.allocation.huge_pages = true;
+    table.store(std::make_unique<ColumnStore>(table, options));
+
+    /* Grow the store across several remaps. */
+    auto &store = table.store();
+    m::StoreWriter W(store);
+    m::Tuple tup(W.schema());
+    for (int32_t i = 0; i != 100000; ++i) {
+        tup.set(0, i);
+        tup.set(1, int64_t(i) << 20);
+        W.append(tup);
+    }
+    REQUIRE(store.num_rows() == 100000);
+
+    C.set_database_in_use(DB);
+    std::ostringstream out, err;
+    m::Diagnostic diag(false, out, err);
+
+    auto stmt = m::statement_from_string(diag, "SELECT a, b FROM test;");
+    REQUIRE(diag.num_errors() == 0);
+
+    int32_t expected = 0;
+    auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema&, const m::Tuple &T) {
+        CHECK(T.get(0).as_i() == expected);
+        CHECK(T.get(1).as_i() == int64_t(expected) << 20);
+        ++expected;
+    });
+
+    std::unique_ptr<m::SelectStmt> select_stmt(static_cast<m::SelectStmt*>(stmt.release()));
+    m::execute_query(diag, *select_stmt, std::move(callback));
+    REQUIRE(diag.num_errors() == 0);
+    REQUIRE(expected == 100000);
+}
+
+TEST_CASE("ColumnStore/null bitmap", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    C.set_database_in_use(DB);
+
+    std::ostringstream out, err;
+    m::Diagnostic diag(false, out, err);
+
+    SECTION("declared NOT NULL")
+    {
+        ColumnStore::Options options;
+        options.null_bitmap = false;
+        table.store(std::make_unique<ColumnStore>(table, options));
+        CHECK(table.store().linearization().num_sequences() == 1); // attribute 'a' only
+    }
+
+    SECTION("observed NOT NULL")
+    {
+        table.store(std::make_unique<ColumnStore>(table));
+        auto &store = static_cast<ColumnStore&>(table.store());
+
+        auto insertions = m::statement_from_string(diag, "INSERT INTO test VALUES (1), (2), (3);");
+        m::execute_statement(diag, *insertions);
+        REQUIRE(diag.num_errors() == 0);
+
+        REQUIRE(store.drop_null_bitmap());
+        CHECK(store.linearization().num_sequences() == 1);
+    }
+
+    SECTION("observed NULL")
+    {
+        table.store(std::make_unique<ColumnStore>(table));
+        auto &store = static_cast<ColumnStore&>(table.store());
+
+        auto insertions = m::statement_from_string(diag, "INSERT INTO test VALUES (1), (NULL);");
+        m::execute_statement(diag, *insertions);
+        REQUIRE(diag.num_errors() == 0);
+
+        CHECK_FALSE(store.drop_null_bitmap());
+        CHECK(store.linearization().num_sequences() == 2);
+    }
+}
+
+TEST_CASE("ColumnStore/erase", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    C.set_database_in_use(DB);
+
+    /* Compact explicitly only. */
+    ColumnStore::Options options;
+    options.compaction_threshold = 1;
+    table.store(std::make_unique<ColumnStore>(table, options));
+    auto &store = static_cast<ColumnStore&>(table.store());
+    {
+        m::StoreWriter W(store);
+        m::Tuple tup(W.schema());
+        for (int32_t i = 0; i != 1000; ++i) {
+            tup.set(0, i);
+            W.append(tup);
+        }
+    }
+
+    /* Erase all even rows. */
+    for (std::size_t row = 0; row < 1000; row += 2)
+        REQUIRE(store.erase(row));
+    CHECK_FALSE(store.erase(0)); // dead already
+    CHECK_FALSE(store.erase(1000)); // does not exist
+    CHECK(store.num_rows() == 1000);
+    CHECK(store.num_live_rows() == 500);
+    CHECK_FALSE(store.is_live(0));
+    CHECK(store.is_live(1));
+
+    /* Compaction moves live rows into the holes, a step at a time. */
+    CHECK(store.compact(10) == 10);
+    CHECK(store.tombstones().size() == 480); // 10 holes filled, 10 dead rows dropped from the end
+    store.compact();
+    CHECK(store.tombstones().empty());
+    REQUIRE(store.num_rows() == 500);
+
+    std::ostringstream out, err;
+    m::Diagnostic diag(false, out, err);
+    auto stmt = m::statement_from_string(diag, "SELECT a FROM test;");
+    REQUIRE(diag.num_errors() == 0);
+
+    std::vector<int64_t> values;
+    auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema&, const m::Tuple &T) {
+        values.push_back(T.get(0).as_i());
+    });
+    std::unique_ptr<m::SelectStmt> select_stmt(static_cast<m::SelectStmt*>(stmt.release()));
+    m::execute_query(diag, *select_stmt, std::move(callback));
+    REQUIRE(diag.num_errors() == 0);
+
+    /* Exactly the odd rows survive, in any order. */
+    std::sort(values.begin(), values.end());
+    REQUIRE(values.size() == 500);
+    for (std::size_t idx = 0; idx != values.size(); ++idx)
+        CHECK(values[idx] == int64_t(2 * idx + 1));
+}
+
+TEST_CASE("ColumnStore/erase and query", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    C.set_database_in_use(DB);
+    table.store(std::make_unique<ColumnStore>(table));
+    auto &store = static_cast<ColumnStore&>(table.store());
+    {
+        m::StoreWriter W(store);
+        m::Tuple tup(W.schema());
+        for (int32_t i = 0; i != 300; ++i) {
+            tup.set(0, i);
+            W.append(tup);
+        }
+    }
+
+    /* By default, every erase compacts at once, so queries never see an erased row. */
+    for (int32_t i = 0; i < 300; i += 3) {
+        std::size_t row = 0;
+        while (load_integer(store.values(0, row), 4) != i) ++row;
+        REQUIRE(store.erase(row));
+    }
+    CHECK(store.num_rows() == 200);
+    CHECK(store.tombstones().empty());
+
+    std::ostringstream out, err;
+    m::Diagnostic diag(false, out, err);
+    auto stmt = m::statement_from_string(diag, "SELECT a FROM test;");
+    REQUIRE(diag.num_errors() == 0);
+
+    std::vector<int64_t> values;
+    auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema&, const m::Tuple &T) {
+        values.push_back(T.get(0).as_i());
+    });
+    std::unique_ptr<m::SelectStmt> select_stmt(static_cast<m::SelectStmt*>(stmt.release()));
+    m::execute_query(diag, *select_stmt, std::move(callback));
+    REQUIRE(diag.num_errors() == 0);
+
+    std::sort(values.begin(), values.end());
+    REQUIRE(values.size() == 200);
+    for (std::size_t idx = 0; idx != values.size(); ++idx)
+        CHECK(values[idx] == int64_t(idx / 2 * 3 + idx % 2 + 1));
+}
+
+TEST_CASE("ColumnStore/statistics", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.store(std::make_unique<ColumnStore>(table));
+
+    auto &store = static_cast<ColumnStore&>(table.store());
+    {
+        m::StoreWriter W(store);
+        m::Tuple tup(W.schema());
+        for (int32_t i = 0; i != 100; ++i) {
+            tup.set(0, i);
+            W.append(tup);
+        }
+    }
+    store.erase(7);
+
+    const auto stats = store.statistics();
+    CHECK(stats.rows == 100);
+    CHECK(stats.live_rows == 99);
+    CHECK(stats.capacity > 100);
+    CHECK(stats.bytes_per_row == 5); // 4 byte INT, 1 byte null bitmap
+    CHECK(stats.allocated_bytes == stats.capacity * stats.bytes_per_row + 2 * ColumnStore::PADDING_BYTES);
+    CHECK(stats.null_bitmap_bytes == stats.capacity + ColumnStore::PADDING_BYTES);
+    CHECK(stats.grow_reallocations > 0);
+    CHECK(stats.shrink_reallocations == 0);
+    CHECK(stats.linearizations == stats.grow_reallocations + 1); // built once more by the c'tor
+
+    std::ostringstream dump, json;
+    store.dump(dump);
+    CHECK(dump.str().find("ColumnStore of table 'test'") == 0);
+    stats.print_json(json);
+    CHECK(json.str().find("{\"rows\":100,\"live_rows\":99,") == 0);
+}
+
+TEST_CASE("ColumnStore/dictionary", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("id"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("repo"), m::Type::Get_Char(m::Type::TY_Vector, 10));
+    C.set_database_in_use(DB);
+
+    ColumnStore::Options options;
+    options.dictionary_attributes = { "repo" };
+    table.store(std::make_unique<ColumnStore>(table, options));
+    auto &store = static_cast<ColumnStore&>(table.store());
+    REQUIRE(store.dictionary(0) == nullptr);
+    REQUIRE(store.dictionary(1) != nullptr);
+
+    std::ostringstream out, err;
+    m::Diagnostic diag(false, out, err);
+
+    /* Three repos, every fourth row NULL. */
+    const char *repos[] = { "\"core\"", "\"extra\"", "\"community\"", "NULL" };
+    std::string insertions = "INSERT INTO test VALUES ";
+    for (int i = 0; i != 400; ++i)
+        insertions += (i ? ", (" : "(") + std::to_string(i) + ", " + repos[i % 4] + ")";
+    m::execute_statement(diag, *m::statement_from_string(diag, insertions + ";"));
+    REQUIRE(diag.num_errors() == 0);
+
+    /* Predicates encode the rows appended so far first. */
+    auto extra = store.select_equal(1, "extra");
+    REQUIRE(extra.size() == 100);
+    for (std::size_t idx = 0; idx != extra.size(); ++idx)
+        CHECK(extra[idx] == 4 * idx + 1);
+
+    const auto &dictionary = *store.dictionary(1);
+    CHECK(dictionary.size() == 400);
+    CHECK(dictionary.num_values() == 3);
+    CHECK(dictionary.width() == 1);
+    CHECK(dictionary.code(3) == DictionaryColumn::NULL_CODE);
+    CHECK(dictionary.value(dictionary.code(2)) == "community");
+
+    CHECK(store.select_in(1, { "core", "community", "testing" }).size() == 200);
+    CHECK(store.select_equal(1, "testing").empty());
+
+    /* Dead rows are skipped. */
+    store.erase(1);
+    CHECK(store.select_equal(1, "extra").size() == 99);
+
+    /* Codes widen once there are more than 255 distinct values. */
+    insertions = "INSERT INTO test VALUES ";
+    for (int i = 0; i != 300; ++i)
+        insertions += (i ? ", (" : "(") + std::to_string(i) + ", \"r" + std::to_string(i) + "\")";
+    m::execute_statement(diag, *m::statement_from_string(diag, insertions + ";"));
+    REQUIRE(diag.num_errors() == 0);
+
+    REQUIRE(store.select_equal(1, "r299") == Selection{ 699 });
+    CHECK(dictionary.width() == 2);
+    CHECK(store.select_equal(1, "extra").size() == 99);
+}
+
+TEST_CASE("ColumnStore/string heap", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("id"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("description"), m::Type::Get_Char(m::Type::TY_Vector, 40));
+    C.set_database_in_use(DB);
+
+    ColumnStore::Options options;
+    options.string_heap_attributes = { "description" };
+    table.store(std::make_unique<ColumnStore>(table, options));
+    auto &store = static_cast<ColumnStore&>(table.store());
+    REQUIRE(store.string_heap(0) == nullptr);
+    REQUIRE(store.string_heap(1) != nullptr);
+
+    std::ostringstream out, err;
+    m::Diagnostic diag(false, out, err);
+
+    /* Two values share their prefix, one fits into it, every fourth row is NULL. */
+    const char *descriptions[] = { "\"A tiny library\"", "\"A tiny library for sizes\"", "\"Zip\"", "NULL" };
+    std::string insertions = "INSERT INTO test VALUES ";
+    for (int i = 0; i != 400; ++i)
+        insertions += (i ? ", (" : "(") + std::to_string(i) + ", " + descriptions[i % 4] + ")";
+    m::execute_statement(diag, *m::statement_from_string(diag, insertions + ";"));
+    REQUIRE(diag.num_errors() == 0);
+
+    using predicate::Comparison;
+    /* Filters encode the rows appended so far first. */
+    CHECK(store.filter(1, Comparison::Equal, std::string("A tiny library")).count() == 100);
+    const auto &heap = *store.string_heap(1);
+    REQUIRE(heap.size() == 400);
+    CHECK(heap.value(1) == "A tiny library for sizes");
+    CHECK(heap.value(2) == "Zip");
+    CHECK(heap.length(3) == 0);
+    CHECK(heap.heap_bytes() == 100 * (14 - StringColumn::PREFIX_BYTES) + 100 * (24 - StringColumn::PREFIX_BYTES));
+
+    /* Comparisons order like the plain column, and NULLs never qualify. */
+    CHECK(store.filter(1, Comparison::Less, std::string("A tiny library for")).count() == 100);
+    CHECK(store.filter(1, Comparison::Greater, std::string("A tiny library")).count() == 200);
+    CHECK(store.filter(1, Comparison::NotEqual, std::string("Zip")).count() == 200);
+    CHECK(store.filter(1, Comparison::Between, std::string("A tiny library f"), std::string("Zip")).count() == 200);
+
+    /* Compaction moves the values of rows, which share their bytes in the heap. */
+    for (std::size_t row = 0; row != 400; row += 4)
+        store.erase(row);
+    store.compact();
+    REQUIRE(store.num_rows() == 300);
+    CHECK(store.filter(1, Comparison::Equal, std::string("A tiny library")).count() == 0);
+    CHECK(store.filter(1, Comparison::Equal, std::string("A tiny library for sizes")).count() == 100);
+
+    /* The heap takes less than the plain column. */
+    CHECK(store.statistics().encoded_bytes < 300 * 40);
+}
+
+TEST_CASE("ColumnStore/packed", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("id"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("size"), m::Type::Get_Integer(m::Type::TY_Vector, 8));
+
+    ColumnStore::Options options;
+    options.packed_attributes = { "id", "size" };
+    table.store(std::make_unique<ColumnStore>(table, options));
+    auto &store = static_cast<ColumnStore&>(table.store());
+
+    /* Block 0 of 'size' packs with 20 bits, block 1 spans all of INT(8) and stays plain, block 2 is constant. */
+    auto size_of = [](int64_t i) -> int64_t {
+        if (i < 1024) return 1000 * i;
+        if (i < 2048) return i % 2 ? std::numeric_limits<int64_t>::max() - i : std::numeric_limits<int64_t>::min() + i;
+        return 42;
+    };
+    constexpr int32_t NUM_ROWS = 3 * PackedColumn::BLOCK_ROWS + 28;
+    {
+        m::StoreWriter W(store);
+        m::Tuple tup(W.schema());
+        for (int32_t i = 0; i != NUM_ROWS; ++i) {
+            tup.set(0, i - 500);
+            tup.set(1, size_of(i));
+            W.append(tup);
+        }
+    }
+
+    /* Scanning packs all whole blocks first. */
+    std::vector<int64_t> ids, sizes;
+    store.scan(0, [&](std::size_t first, const int64_t *values, std::size_t n) {
+        CHECK(first == ids.size());
+        ids.insert(ids.end(), values, values + n);
+    });
+    store.scan(1, [&](std::size_t first, const int64_t *values, std::size_t n) {
+        CHECK(first == sizes.size());
+        sizes.insert(sizes.end(), values, values + n);
+    });
+    REQUIRE(ids.size() == NUM_ROWS);
+    REQUIRE(sizes.size() == NUM_ROWS);
+    for (int32_t i = 0; i != NUM_ROWS; ++i) {
+        CHECK(ids[i] == i - 500);
+        CHECK(sizes[i] == size_of(i));
+    }
+
+    const auto &packed_ids = *store.packed_column(0);
+    const auto &packed_sizes = *store.packed_column(1);
+    REQUIRE(packed_ids.num_blocks() == 3);
+    CHECK(packed_ids.bits(0) == 10);
+    REQUIRE(packed_sizes.num_blocks() == 3);
+    CHECK(packed_sizes.bits(0) == 20);
+    CHECK(packed_sizes.bits(1) == 64);
+    CHECK(packed_sizes.bits(2) == 0);
+    CHECK(store.statistics().encoded_bytes < NUM_ROWS * 12);
+
+    /* Dropping rows forgets the blocks they were in. */
+    for (int i = 0; i != 100; ++i)
+        store.drop();
+    CHECK(packed_ids.num_blocks() == 2);
+}
+
+TEST_CASE("ColumnStore/zone map", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("sorted"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("unsorted"), m::Type::Get_Integer(m::Type::TY_Vector, 8));
+
+    ColumnStore::Options options;
+    options.zone_map_attributes = { "sorted", "unsorted" };
+    table.store(std::make_unique<ColumnStore>(table, options));
+    auto &store = static_cast<ColumnStore&>(table.store());
+
+    constexpr int32_t NUM_ROWS = 8 * ZoneMap::BLOCK_ROWS + 100;
+    {
+        m::StoreWriter W(store);
+        m::Tuple tup(W.schema());
+        for (int32_t i = 0; i != NUM_ROWS; ++i) {
+            tup.set(0, i);
+            tup.set(1, int64_t(i * 7919 % NUM_ROWS));
+            W.append(tup);
+        }
+    }
+
+    /* Blocks are summarized once all their rows are written. */
+    std::size_t skipped = 0;
+    auto selection = store.select_range(0, 3000, 3999, &skipped);
+    REQUIRE(store.zone_map(0)->num_blocks() == 8);
+    CHECK(store.zone_map(0)->zone(1).min == 1024);
+    CHECK(store.zone_map(0)->zone(1).max == 2047);
+    CHECK(skipped == 6); // only blocks 2 and 3 may contain the range, the unsummarized tail is scanned
+    REQUIRE(selection.size() == 1000);
+    for (std::size_t i = 0; i != selection.size(); ++i)
+        CHECK(selection[i] == 3000 + i);
+
+    /* Unsorted values span every block, nothing is skipped but the result is still right. */
+    skipped = 0;
+    selection = store.select_range(1, 0, 99, &skipped);
+    CHECK(skipped == 0);
+    CHECK(selection.size() == 100);
+
+    /* Dead rows are not selected, dropped rows forget their block. */
+    store.erase(3000);
+    CHECK(store.select_range(0, 3000, 3999).size() == 999);
+    for (int i = 0; i != 200; ++i)
+        store.drop();
+    CHECK(store.zone_map(0)->num_blocks() == 7);
+    CHECK(store.select_range(0, 7000, NUM_ROWS).size() == NUM_ROWS - 200 - 7000);
+}
+
+TEST_CASE("ColumnStore/snapshot", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("b"), m::Type::Get_Integer(m::Type::TY_Vector, 8));
+    table.store(std::make_unique<ColumnStore>(table));
+
+    auto &copy = DB.add_table(C.pool("copy"));
+    copy.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    copy.push_back(C.pool("b"), m::Type::Get_Integer(m::Type::TY_Vector, 8));
+    copy.store(std::make_unique<ColumnStore>(copy));
+
+    {
+        m::StoreWriter W(table.store());
+        m::Tuple tup(W.schema());
+        for (int32_t i = 0; i != 1000; ++i) {
+            tup.set(0, i);
+            tup.set(1, int64_t(i) << 20);
+            W.append(tup);
+        }
+    }
+
+    const auto path = (std::filesystem::temp_directory_path() / "ColumnStoreTest.snapshot").string();
+    REQUIRE(static_cast<ColumnStore&>(table.store()).save(path.c_str()));
+
+    /* Restore into the empty store of a table with the same schema. */
+    auto &store = static_cast<ColumnStore&>(copy.store());
+    REQUIRE(store.restore(path.c_str()));
+    std::filesystem::remove(path);
+    REQUIRE(store.num_rows() == 1000);
+
+    /* The file holds the padding after the last row of every column, too. */
+    CHECK(store.statistics().capacity == 1001);
+    CHECK(store.values(1, 1000)[8 + ColumnStore::PADDING_BYTES - 1] == 0);
+
+    /* A non-empty store cannot be restored. */
+    CHECK_FALSE(store.restore(path.c_str()));
+
+    /* Appending grows the store out of the snapshot. */
+    {
+        m::StoreWriter W(store);
+        m::Tuple tup(W.schema());
+        for (int32_t i = 1000; i != 2000; ++i) {
+            tup.set(0, i);
+            tup.set(1, int64_t(i) << 20);
+            W.append(tup);
+        }
+    }
+    REQUIRE(store.num_rows() == 2000);
+
+    C.set_database_in_use(DB);
+    std::ostringstream out, err;
+    m::Diagnostic diag(false, out, err);
+
+    auto stmt = m::statement_from_string(diag, "SELECT a, b FROM copy;");
+    REQUIRE(diag.num_errors() == 0);
+
+    int32_t expected = 0;
+    auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema&, const m::Tuple &T) {
+        CHECK(T.get(0).as_i() == expected);
+        CHECK(T.get(1).as_i() == int64_t(expected) << 20);
+        ++expected;
+    });
+
+    std::unique_ptr<m::SelectStmt> select_stmt(static_cast<m::SelectStmt*>(stmt.release()));
+    m::execute_query(diag, *select_stmt, std::move(callback));
+    REQUIRE(diag.num_errors() == 0);
+    REQUIRE(expected == 2000);
+}
+
+TEST_CASE("ColumnStore/parallel CSV", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("id"),    m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("flag"),  m::Type::Get_Boolean(m::Type::TY_Vector));
+    table.push_back(C.pool("price"), m::Type::Get_Double(m::Type::TY_Vector));
+    table.push_back(C.pool("name"),  m::Type::Get_Char(m::Type::TY_Vector, 12));
+    table.store(std::make_unique<ColumnStore>(table));
+
+    /* The header orders the columns differently, and quoted names contain commas, newlines and quotes, doubled or
+     * escaped with a backslash. */
+    constexpr int32_t NUM_RECORDS = 300;
+    const auto path = (std::filesystem::temp_directory_path() / "ColumnStoreTest.csv").string();
+    {
+        std::ofstream out(path);
+        out << "name,id,price,flag\r\n";
+        for (int32_t i = 0; i != NUM_RECORDS; ++i) {
+            if (i % 10 == 0)
+                out << "\"a, \"\"b\"\"\n\"";
+            else if (i % 5 == 0)
+                out << "\"a, \\\"b\\\"\n\"";
+            else
+                out << 'n' << i;
+            out << ',' << i << ',';
+            if (i % 7) out << i * .5;
+            out << ',' << (i % 2 ? "TRUE" : "FALSE") << '\n';
+        }
+    }
+
+    std::ostringstream out, err;
+    m::Diagnostic diag(false, out, err);
+    /* Tiny ranges, so that records and quoted fields span several of them. */
+    REQUIRE(load_CSV_parallel(diag, table, path.c_str(), true, 4, 64));
+    std::filesystem::remove(path);
+    REQUIRE(diag.num_errors() == 0);
+    REQUIRE(table.store().num_rows() == NUM_RECORDS);
+
+    C.set_database_in_use(DB);
+    auto stmt = m::statement_from_string(diag, "SELECT id, flag, price, name FROM test;");
+    REQUIRE(diag.num_errors() == 0);
+
+    int32_t expected = 0;
+    auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema&, const m::Tuple &T) {
+        CHECK(T.get(0).as_i() == expected);
+        CHECK(T.get(1).as_b() == bool(expected % 2));
+        if (expected % 7) {
+            REQUIRE_FALSE(T.is_null(2));
+            CHECK(T.get(2).as_d() == expected * .5);
+        } else {
+            CHECK(T.is_null(2));
+        }
+        const std::string name = expected % 5 ? "n" + std::to_string(expected) : "a, \"b\"\n";
+        CHECK(name == reinterpret_cast<char*>(T.get(3).as_p()));
+        ++expected;
+    });
+
+    std::unique_ptr<m::SelectStmt> select_stmt(static_cast<m::SelectStmt*>(stmt.release()));
+    m::execute_query(diag, *select_stmt, std::move(callback));
+    REQUIRE(diag.num_errors() == 0);
+    REQUIRE(expected == NUM_RECORDS);
+}
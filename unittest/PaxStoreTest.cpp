@@ -0,0 +1,257 @@
+#include "catch.hpp"
+
+#include "PaxStore.hpp"
+#include <mutable/mutable.hpp>
+#include <sstream>
+#include <utility>
+
+
+TEST_CASE("PaxStore/c'tor", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("b"), m::Type::Get_Double(m::Type::TY_Vector));
+    table.store(std::make_unique<PaxStore>(table));
+    auto &lin = table.store().linearization();
+
+    /* Root must be an infinite sequence of blocks. */
+    CHECK(lin.num_tuples() == 0); // infinite sequence
+    REQUIRE(lin.num_sequences() == 1); // of single block
+
+    const auto &seq_block = *lin.begin();
+    REQUIRE(seq_block.is_linearization());
+    CHECK(seq_block.offset != 0); // address of first block
+    CHECK(seq_block.stride == 4096); // a block is a page
+
+    /* A block holds as many rows as fit into a page: 4 byte INT, 8 byte DOUBLE, 1 byte null bitmap. */
+    const auto &block = seq_block.as_linearization();
+    CHECK(block.num_tuples() == 4096 / 13);
+    REQUIRE(block.num_sequences() == 3); // minipages of 'a', 'b', and null bitmap
+
+    auto block_it = block.begin();
+    {
+        /* Check minipage of 'a', placed after 'b' due to its smaller alignment. */
+        const auto &seq_a = *block_it++;
+        REQUIRE(seq_a.is_linearization());
+        CHECK(seq_a.offset == 8 * block.num_tuples());
+        CHECK(seq_a.stride == 4);
+        const auto &a = *seq_a.as_linearization().begin();
+        REQUIRE(a.is_attribute());
+        CHECK(a.as_attribute().name == C.pool("a"));
+    }
+
+    {
+        /* Check minipage of 'b', placed first. */
+        const auto &seq_b = *block_it++;
+        REQUIRE(seq_b.is_linearization());
+        CHECK(seq_b.offset == 0);
+        CHECK(seq_b.stride == 8);
+        const auto &b = *seq_b.as_linearization().begin();
+        REQUIRE(b.is_attribute());
+        CHECK(b.as_attribute().name == C.pool("b"));
+    }
+
+    {
+        /* Check minipage of null bitmaps, placed last. */
+        const auto &seq_bitmap = *block_it++;
+        REQUIRE(seq_bitmap.is_linearization());
+        CHECK(seq_bitmap.offset == 12 * block.num_tuples());
+        CHECK(seq_bitmap.stride == 1);
+        CHECK((*seq_bitmap.as_linearization().begin()).is_null_bitmap());
+    }
+}
+
+TEST_CASE("PaxStore/access", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+
+    const std::pair<const char*, const m::PrimitiveType*> Attributes[] = {
+        { "a_i4",   m::Type::Get_Integer(m::Type::TY_Vector, 4) },
+        { "b_f",    m::Type::Get_Float(m::Type::TY_Vector) },
+        { "c_i2",   m::Type::Get_Integer(m::Type::TY_Vector, 2) },
+        { "d_b",    m::Type::Get_Boolean(m::Type::TY_Vector) },
+        { "e_d",    m::Type::Get_Double(m::Type::TY_Vector) },
+        { "f_b",    m::Type::Get_Boolean(m::Type::TY_Vector) },
+        { "g_c",    m::Type::Get_Char(m::Type::TY_Vector, 7) },
+        { "h_b",    m::Type::Get_Boolean(m::Type::TY_Vector) },
+        { "i_b",    m::Type::Get_Boolean(m::Type::TY_Vector) },
+    };
+    for (auto &attr : Attributes)
+        table.push_back(C.pool(attr.first), attr.second);
+
+    /* Create and set store. */
+    table.store(std::make_unique<PaxStore>(table));
+
+    /* Process queries. */
+    C.set_database_in_use(DB);
+
+    std::ostringstream out, err;
+    m::Diagnostic diag(false, out, err);
+
+    {
+        auto stmt = m::statement_from_string(diag, "SELECT * FROM test;");
+        REQUIRE(diag.num_errors() == 0);
+        REQUIRE(err.str().empty());
+
+        std::size_t num_tuples = 0;
+        auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema&, const m::Tuple&) {
+            ++num_tuples;
+        });
+
+        std::unique_ptr<m::SelectStmt> select_stmt(static_cast<m::SelectStmt*>(stmt.release()));
+        m::execute_query(diag, *select_stmt, std::move(callback));
+        REQUIRE(diag.num_errors() == 0);
+        REQUIRE(err.str().empty());
+        REQUIRE(num_tuples == 0);
+    }
+
+    {
+        auto insertions = m::statement_from_string(diag, "INSERT INTO test VALUES \
+                ( 42, 3.14, 1337, TRUE, 2.71828, FALSE, \"female\", TRUE, NULL ), \
+                ( NULL, 6.62607015, -137, NULL, 6.241509074, FALSE, NULL, TRUE, FALSE ), \
+                ( 13, 2.718, 137, NULL, 0.51099895000, TRUE, \"unicorn\", FALSE, TRUE );");
+        m::execute_statement(diag, *insertions);
+
+        auto stmt = m::statement_from_string(diag, "SELECT * FROM test;");
+        REQUIRE(diag.num_errors() == 0);
+        REQUIRE(err.str().empty());
+
+#define IDX(ATTR) S[C.pool(ATTR)].first
+#define CHECK_VALUE(ATTR, TYPE, VALUE) \
+    REQUIRE_FALSE(T.is_null(IDX(ATTR))); \
+    CHECK((VALUE) == T.get(IDX(ATTR)).as_##TYPE())
+#define CHECK_CHAR(ATTR, VALUE) \
+    REQUIRE_FALSE(T.is_null(IDX(ATTR))); \
+    CHECK(std::string(VALUE) == reinterpret_cast<char*>(T.get(IDX(ATTR)).as_p()))
+
+        std::size_t num_tuples = 0;
+        auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema &S, const m::Tuple &T) {
+            switch (num_tuples) {
+                case 0: {
+                    CHECK_VALUE("a_i4", i, 42);
+                    CHECK_VALUE("b_f",  f, 3.14f);
+                    CHECK_VALUE("c_i2", i, 1337);
+                    CHECK_VALUE("d_b",  b, true);
+                    CHECK_VALUE("e_d",  d, 2.71828);
+                    CHECK_VALUE("f_b",  b, false);
+                    CHECK_VALUE("h_b",  b, true);
+                    CHECK_CHAR("g_c", "female");
+                    CHECK(T.is_null(IDX("i_b")));
+                    break;
+                }
+
+                case 1: {
+                    CHECK(T.is_null(IDX("a_i4")));
+                    CHECK_VALUE("b_f",  f, 6.62607015f);
+                    CHECK_VALUE("c_i2", i, -137);
+                    CHECK(T.is_null(IDX("d_b")));
+                    CHECK_VALUE("e_d",  d, 6.241509074);
+                    CHECK_VALUE("f_b",  b, false);
+                    CHECK(T.is_null(IDX("g_c")));
+                    CHECK_VALUE("h_b",  b, true);
+                    CHECK_VALUE("i_b", b, false);
+                    break;
+                }
+
+                case 2: {
+                    CHECK_VALUE("a_i4", i, 13);
+                    CHECK_VALUE("b_f",  f, 2.718f);
+                    CHECK_VALUE("c_i2", i, 137);
+                    CHECK(T.is_null(IDX("d_b")));
+                    CHECK_VALUE("e_d", d, 0.51099895000);
+                    CHECK_VALUE("f_b", b, true);
+                    CHECK_CHAR("g_c", "unicorn");
+                    CHECK_VALUE("h_b", b, false);
+                    CHECK_VALUE("i_b", b, true);
+                    break;
+                }
+
+                default:
+                    REQUIRE(false);
+            }
+            ++num_tuples;
+        });
+
+        std::unique_ptr<m::SelectStmt> select_stmt(static_cast<m::SelectStmt*>(stmt.release()));
+        m::execute_query(diag, *select_stmt, std::move(callback));
+        REQUIRE(diag.num_errors() == 0);
+        REQUIRE(err.str().empty());
+        REQUIRE(num_tuples == 3);
+    }
+}
+
+TEST_CASE("PaxStore/blocks", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+
+    /* Tiny blocks of 12 rows each, so that many blocks are filled. */
+    PaxStore::Options options;
+    options.block_bytes = 64;
+    table.store(std::make_unique<PaxStore>(table, options));
+    auto &store = table.store();
+    REQUIRE(static_cast<PaxStore&>(store).block_size() == 12);
+
+    m::StoreWriter W(store);
+    m::Tuple tup(W.schema());
+    for (int32_t i = 0; i != 1000; ++i) {
+        tup.set(0, i);
+        W.append(tup);
+    }
+    REQUIRE(store.num_rows() == 1000);
+
+    C.set_database_in_use(DB);
+    std::ostringstream out, err;
+    m::Diagnostic diag(false, out, err);
+
+    auto stmt = m::statement_from_string(diag, "SELECT a FROM test;");
+    REQUIRE(diag.num_errors() == 0);
+
+    int32_t expected = 0;
+    auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema&, const m::Tuple &T) {
+        CHECK(T.get(0).as_i() == expected);
+        ++expected;
+    });
+
+    std::unique_ptr<m::SelectStmt> select_stmt(static_cast<m::SelectStmt*>(stmt.release()));
+    m::execute_query(diag, *select_stmt, std::move(callback));
+    REQUIRE(diag.num_errors() == 0);
+    REQUIRE(expected == 1000);
+}
+
+TEST_CASE("PaxStore/wide rows", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 8));
+    table.push_back(C.pool("b"), m::Type::Get_Integer(m::Type::TY_Vector, 1));
+
+    /* A row of 10 bytes does not fit into a block of 4 bytes, blocks grow to one row, rounded up to the 8 byte
+     * alignment of 'a', so that the minipage of 'a' stays aligned in every block. */
+    PaxStore::Options options;
+    options.block_bytes = 4;
+    table.store(std::make_unique<PaxStore>(table, options));
+    auto &lin = table.store().linearization();
+    REQUIRE(static_cast<PaxStore&>(table.store()).block_size() == 1);
+
+    const auto &seq_block = *lin.begin();
+    REQUIRE(seq_block.is_linearization());
+    CHECK(seq_block.stride == 16);
+    CHECK(seq_block.offset % 8 == 0);
+}
@@ -1,9 +1,18 @@
 #include "catch.hpp"
 
 #include "RowStore.hpp"
+#include "Loader.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <mutable/mutable.hpp>
 #include <sstream>
+#include <string>
+#include <thread>
 #include <utility>
+#include <vector>
 
 
 TEST_CASE("RowStore/c'tor", "[milestone1]")
@@ -418,3 +427,971 @@ TEST_CASE("RowStore/access", "[milestone1]")
         REQUIRE(num_tuples == 3);
     }
 }
+
+TEST_CASE("RowStore/chunked", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+
+    RowStore::Options options;
+    options.chunked = true;
+    options.block_bytes = 4096;
+    table.store(std::make_unique<RowStore>(table, options));
+
+    auto &lin = table.store().linearization();
+
+    /* Root must be an infinite sequence of blocks. */
+    CHECK(lin.num_tuples() == 0); // infinite sequence
+    REQUIRE(lin.num_sequences() == 1); // of single block
+
+    const auto &seq_block = *lin.begin();
+    REQUIRE(seq_block.is_linearization());
+    CHECK(seq_block.offset != 0); // address of first block
+    CHECK(seq_block.stride % 4096 == 0); // blocks start at page boundaries
+
+    /* A block must be a finite sequence of rows. */
+    const auto &block = seq_block.as_linearization();
+    CHECK(block.num_tuples() == 512); // 4096 bytes per block, 8 bytes per row
+    REQUIRE(block.num_sequences() == 1);
+
+    const auto &seq_row = *block.begin();
+    REQUIRE(seq_row.is_linearization());
+    CHECK(seq_row.offset == 0); // first row at the beginning of the block
+    CHECK(seq_row.stride == 8); // 4 byte INT, 1 bit null bitmap, padding
+    CHECK(seq_row.as_linearization().num_tuples() == 1);
+
+    /* Fill several blocks, the linearization must not be replaced. */
+    auto &store = table.store();
+    m::StoreWriter W(store);
+    m::Tuple tup(W.schema());
+    for (int32_t i = 0; i != 2000; ++i) {
+        tup.set(0, i);
+        W.append(tup);
+    }
+    REQUIRE(store.num_rows() == 2000);
+    CHECK(&store.linearization() == &lin);
+
+    C.set_database_in_use(DB);
+    std::ostringstream out, err;
+    m::Diagnostic diag(false, out, err);
+
+    auto stmt = m::statement_from_string(diag, "SELECT a FROM test;");
+    REQUIRE(diag.num_errors() == 0);
+
+    int32_t expected = 0;
+    auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema&, const m::Tuple &T) {
+        CHECK(T.get(0).as_i() == expected);
+        ++expected;
+    });
+
+    std::unique_ptr<m::SelectStmt> select_stmt(static_cast<m::SelectStmt*>(stmt.release()));
+    m::execute_query(diag, *select_stmt, std::move(callback));
+    REQUIRE(diag.num_errors() == 0);
+    REQUIRE(expected == 2000);
+
+    /* Dropping rows releases the trailing blocks again. */
+    while (store.num_rows() != 0)
+        store.drop();
+    CHECK(store.num_rows() == 0);
+}
+
+TEST_CASE("RowStore/concurrent appends", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("b"), m::Type::Get_Boolean(m::Type::TY_Vector));
+
+    /* Only a chunked store never moves its rows while writers fill them. */
+    {
+        RowStore plain(table);
+        CHECK_THROWS_AS(plain.begin_concurrent_appends(), std::logic_error);
+    }
+
+    RowStore::Options options;
+    options.chunked = true;
+    options.block_bytes = 4096;
+    table.store(std::make_unique<RowStore>(table, options));
+    auto &store = static_cast<RowStore&>(table.store());
+    auto &lin = store.linearization();
+
+    /* Writers fill batches of rows independently, a reader sees only completely written rows below the watermark. */
+    constexpr int32_t NUM_THREADS = 4, NUM_BATCHES = 60, BATCH_ROWS = 37;
+    store.begin_concurrent_appends();
+    std::atomic<bool> done(false), torn(false), receded(false);
+    std::thread reader([&]() {
+        std::size_t seen = 0;
+        while (not done.load()) {
+            const std::size_t visible = store.num_rows();
+            if (visible < seen) receded = true;
+            for (std::size_t row = seen; row != visible; ++row) {
+                const auto loc_a = store.value_location(row, 0);
+                if (load_integer(loc_a.base + loc_a.bit / 8, 4) == 0) torn = true;
+            }
+            seen = visible;
+        }
+    });
+    std::vector<std::thread> writers;
+    for (int32_t t = 0; t != NUM_THREADS; ++t) {
+        writers.emplace_back([&, t]() {
+            for (int32_t batch = 0; batch != NUM_BATCHES; ++batch) {
+                const auto first = store.claim_rows(BATCH_ROWS);
+                for (int32_t i = 0; i != BATCH_ROWS; ++i) {
+                    const int32_t a = (t * NUM_BATCHES + batch) * BATCH_ROWS + i + 1;
+                    auto loc_a = store.value_location(first + i, 0), loc_b = store.value_location(first + i, 1);
+                    memcpy(loc_a.base + loc_a.bit / 8, &a, sizeof(a));
+                    set_bit(loc_b.base, loc_b.bit, a % 2 == 0);
+                    auto null_a = store.null_location(first + i, 0), null_b = store.null_location(first + i, 1);
+                    set_bit(null_a.base, null_a.bit, false);
+                    set_bit(null_b.base, null_b.bit, i % 3 == 0);
+                }
+                store.publish_rows(first, BATCH_ROWS);
+            }
+        });
+    }
+    for (auto &w : writers) w.join();
+    done = true;
+    reader.join();
+    CHECK_FALSE(torn);
+    CHECK_FALSE(receded);
+
+    const std::size_t total = NUM_THREADS * NUM_BATCHES * BATCH_ROWS;
+    store.end_concurrent_appends();
+    REQUIRE(store.num_rows() == total);
+    CHECK(&store.linearization() == &lin);
+
+    /* Every value was appended exactly once, and mutable reads the rows as usual. */
+    C.set_database_in_use(DB);
+    std::ostringstream out, err;
+    m::Diagnostic diag(false, out, err);
+
+    auto stmt = m::statement_from_string(diag, "SELECT a, b FROM test;");
+    REQUIRE(diag.num_errors() == 0);
+
+    std::vector<int64_t> values;
+    std::size_t nulls = 0;
+    auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema&, const m::Tuple &T) {
+        values.push_back(T.get(0).as_i());
+        if (T.is_null(1))
+            ++nulls;
+        else
+            CHECK(T.get(1).as_b() == (values.back() % 2 == 0));
+    });
+
+    std::unique_ptr<m::SelectStmt> select_stmt(static_cast<m::SelectStmt*>(stmt.release()));
+    m::execute_query(diag, *select_stmt, std::move(callback));
+    REQUIRE(diag.num_errors() == 0);
+    std::sort(values.begin(), values.end());
+    REQUIRE(values.size() == total);
+    for (std::size_t i = 0; i != total; ++i)
+        CHECK(values[i] == int64_t(i + 1));
+    CHECK(nulls == NUM_THREADS * NUM_BATCHES * (BATCH_ROWS / 3 + 1));
+
+    store.append();
+    CHECK(store.num_rows() == total + 1);
+}
+
+TEST_CASE("RowStore/read view", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("b"), m::Type::Get_Integer(m::Type::TY_Vector, 8));
+
+    RowStore::Options options;
+    options.concurrent_readers = true;
+    table.store(std::make_unique<RowStore>(table, options));
+    auto &store = static_cast<RowStore&>(table.store());
+
+    /* Like mutable, write the values of a row after appending it.  The rows before the last one are committed. */
+    auto append_row = [&store](int32_t i) {
+        store.append();
+        const int64_t b = int64_t(i) * 3;
+        const auto loc_a = store.value_location(i, 0), loc_b = store.value_location(i, 1);
+        memcpy(loc_a.base + loc_a.bit / 8, &i, sizeof(i));
+        memcpy(loc_b.base + loc_b.bit / 8, &b, sizeof(b));
+    };
+    for (int32_t i = 0; i != 3; ++i)
+        append_row(i);
+    CHECK(store.committed_rows() == 2);
+    store.commit_rows();
+    CHECK(store.committed_rows() == 3);
+
+    auto check_row = [](const RowStore::ReadView &view, std::size_t row) {
+        const auto loc_a = view.value_location(row, 0), loc_b = view.value_location(row, 1);
+        return load_integer(loc_a.base + loc_a.bit / 8, 4) == int64_t(row) and
+               load_integer(loc_b.base + loc_b.bit / 8, 8) == int64_t(row) * 3;
+    };
+
+    /* A view keeps reading the rows it saw, although the store moves them to grow. */
+    {
+        auto view = store.read_view();
+        REQUIRE(view.num_rows() == 3);
+        for (int32_t i = 3; i != 1000; ++i)
+            append_row(i);
+        CHECK(store.statistics().grow_reallocations > 5);
+        for (std::size_t row = 0; row != view.num_rows(); ++row)
+            CHECK(check_row(view, row));
+    }
+
+    /* Readers take views while a writer appends, and never see a row that is not written completely. */
+    constexpr int32_t NUM_ROWS = 200000;
+    std::atomic<bool> done(false), torn(false), receded(false);
+    std::vector<std::thread> readers;
+    for (int r = 0; r != 3; ++r) {
+        readers.emplace_back([&]() {
+            std::size_t seen = 0;
+            while (not done.load()) {
+                auto view = store.read_view();
+                const std::size_t rows = view.num_rows();
+                if (rows < seen) receded = true;
+                for (std::size_t row = seen; row < rows; row += 97)
+                    if (not check_row(view, row)) torn = true;
+                if (rows and not check_row(view, rows - 1)) torn = true;
+                seen = rows;
+            }
+        });
+    }
+    for (int32_t i = 1000; i != NUM_ROWS; ++i)
+        append_row(i);
+    store.commit_rows();
+    done = true;
+    for (auto &r : readers) r.join();
+    CHECK_FALSE(torn);
+    CHECK_FALSE(receded);
+
+    auto view = store.read_view();
+    REQUIRE(view.num_rows() == NUM_ROWS);
+    for (std::size_t row = 0; row != NUM_ROWS; ++row)
+        REQUIRE(check_row(view, row));
+}
+
+TEST_CASE("RowStore/read view stress", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+
+    /* Growing copies the rows to new buffers and unmaps the old ones.  A reader that took a view of an old buffer
+     * after it was retired would read unmapped memory. */
+    RowStore::Options options;
+    options.concurrent_readers = true;
+    options.allocation.backend = memory::Backend::Mmap;
+    for (int round = 0; round != 20; ++round) {
+        table.store(std::make_unique<RowStore>(table, options));
+        auto &store = static_cast<RowStore&>(table.store());
+
+        std::atomic<bool> done(false), torn(false);
+        std::size_t num_views = 0;
+        auto value = [](const RowStore::ReadView &view, std::size_t row) {
+            const auto loc = view.value_location(row, 0);
+            return load_integer(loc.base + loc.bit / 8, 4);
+        };
+        std::thread reader([&]() {
+            while (not done.load()) {
+                auto view = store.read_view();
+                const std::size_t rows = view.num_rows();
+                ++num_views;
+                if (rows and (value(view, 0) != 0 or value(view, rows - 1) != int64_t(rows - 1)))
+                    torn = true;
+            }
+        });
+        for (int32_t i = 0; i != 100000; ++i) {
+            store.append();
+            const auto loc = store.value_location(i, 0);
+            memcpy(loc.base + loc.bit / 8, &i, sizeof(i));
+        }
+        done = true;
+        reader.join();
+        CHECK_FALSE(torn);
+        CHECK(num_views > 0);
+        CHECK(store.statistics().grow_reallocations > 5);
+    }
+}
+
+TEST_CASE("RowStore/reserve", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.store(std::make_unique<RowStore>(table));
+
+    auto &store = static_cast<RowStore&>(table.store());
+    store.reserve(1000);
+    const auto address = (*store.linearization().begin()).offset;
+
+    /* Appending up to the reserved number of rows must not move the rows. */
+    store.append(600);
+    CHECK(store.num_rows() == 600);
+    for (int i = 0; i != 400; ++i)
+        store.append();
+    CHECK(store.num_rows() == 1000);
+    CHECK((*store.linearization().begin()).offset == address);
+
+    /* Appending beyond grows the store. */
+    store.append(1000);
+    CHECK(store.num_rows() == 2000);
+}
+
+TEST_CASE("RowStore/mmap", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("b"), m::Type::Get_Integer(m::Type::TY_Vector, 8));
+
+    RowStore::Options options;
+    options.allocation.backend = memory::Backend::Mmap;
+    options.allocation.huge_pages = true;
+    table.store(std::make_unique<RowStore>(table, options));
+
+    /* Grow the store across several remaps. */
+    auto &store = table.store();
+    m::StoreWriter W(store);
+    m::Tuple tup(W.schema());
+    for (int32_t i = 0; i != 100000; ++i) {
+        tup.set(0, i);
+        tup.set(1, int64_t(i) << 20);
+        W.append(tup);
+    }
+    REQUIRE(store.num_rows() == 100000);
+
+    C.set_database_in_use(DB);
+    std::ostringstream out, err;
+    m::Diagnostic diag(false, out, err);
+
+    auto stmt = m::statement_from_string(diag, "SELECT a, b FROM test;");
+    REQUIRE(diag.num_errors() == 0);
+
+    int32_t expected = 0;
+    auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema&, const m::Tuple &T) {
+        CHECK(T.get(0).as_i() == expected);
+        CHECK(T.get(1).as_i() == int64_t(expected) << 20);
+        ++expected;
+    });
+
+    std::unique_ptr<m::SelectStmt> select_stmt(static_cast<m::SelectStmt*>(stmt.release()));
+    m::execute_query(diag, *select_stmt, std::move(callback));
+    REQUIRE(diag.num_errors() == 0);
+    REQUIRE(expected == 100000);
+}
+
+TEST_CASE("RowStore/layout", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+
+    SECTION("hot attributes first")
+    {
+        table.push_back(C.pool("a"), m::Type::Get_Boolean(m::Type::TY_Vector));
+        table.push_back(C.pool("b"), m::Type::Get_Double(m::Type::TY_Vector));
+
+        RowLayoutOptions options;
+        options.hot_attributes = { "a" };
+
+        /* Alignment descending after the hot BOOL wastes most of the first 8 bytes. */
+        auto layout = plan_row_layout(table, options);
+        REQUIRE(layout.order.size() == 2);
+        CHECK(layout.order[0] == 0);
+        CHECK(layout.offsets[0] == 0);
+        CHECK(layout.offsets[1] == 64);
+        CHECK(layout.bitmap_offset == 128);
+        CHECK(layout.stride_bytes == 24);
+
+        /* The search moves the null bitmap into the gap after the hot BOOL. */
+        options.policy = LayoutPolicy::MinimalPadding;
+        layout = plan_row_layout(table, options);
+        REQUIRE(layout.order.size() == 2);
+        CHECK(layout.order[0] == 0);
+        CHECK(layout.offsets[0] == 0);
+        CHECK(layout.bitmap_offset == 1);
+        CHECK(layout.offsets[1] == 64);
+        CHECK(layout.stride_bytes == 16);
+        CHECK(layout.padding_bits(table) == 128 - 65 - 2);
+    }
+
+    SECTION("cache line padding")
+    {
+        table.push_back(C.pool("a"), m::Type::Get_Char(m::Type::TY_Vector, 40));
+
+        RowLayoutOptions options;
+        CHECK(plan_row_layout(table, options).stride_bytes == 41);
+
+        /* Padding to a cache line costs 23 bytes. */
+        options.max_cache_line_padding = 16;
+        CHECK(plan_row_layout(table, options).stride_bytes == 41);
+
+        options.max_cache_line_padding = 32;
+        auto layout = plan_row_layout(table, options);
+        CHECK(layout.stride_bytes == 64);
+        CHECK(layout.alignment_bytes == 64);
+
+        /* The store places its rows accordingly. */
+        RowStore::Options store_options;
+        store_options.layout = options;
+        table.store(std::make_unique<RowStore>(table, store_options));
+        const auto &seq_row = *table.store().linearization().begin();
+        CHECK(seq_row.stride == 64);
+        CHECK(seq_row.offset % 64 == 0);
+    }
+}
+
+TEST_CASE("RowStore/null bitmap", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    C.set_database_in_use(DB);
+
+    std::ostringstream out, err;
+    m::Diagnostic diag(false, out, err);
+
+    SECTION("declared NOT NULL")
+    {
+        RowStore::Options options;
+        options.layout.null_bitmap = false;
+        table.store(std::make_unique<RowStore>(table, options));
+
+        const auto &seq_row = *table.store().linearization().begin();
+        CHECK(seq_row.stride == 4); // 4 byte INT, no null bitmap
+        CHECK(seq_row.as_linearization().num_sequences() == 1); // attribute 'a' only
+    }
+
+    SECTION("observed NOT NULL")
+    {
+        table.store(std::make_unique<RowStore>(table));
+        auto &store = static_cast<RowStore&>(table.store());
+
+        auto insertions = m::statement_from_string(diag, "INSERT INTO test VALUES (1), (2), (3);");
+        m::execute_statement(diag, *insertions);
+        REQUIRE(diag.num_errors() == 0);
+
+        REQUIRE(store.drop_null_bitmap());
+        const auto &seq_row = *store.linearization().begin();
+        CHECK(seq_row.stride == 4);
+
+        /* Rows must have been moved to the tighter layout. */
+        auto stmt = m::statement_from_string(diag, "SELECT a FROM test;");
+        int64_t expected = 1;
+        auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema&, const m::Tuple &T) {
+            CHECK(T.get(0).as_i() == expected++);
+        });
+        std::unique_ptr<m::SelectStmt> select_stmt(static_cast<m::SelectStmt*>(stmt.release()));
+        m::execute_query(diag, *select_stmt, std::move(callback));
+        REQUIRE(diag.num_errors() == 0);
+        CHECK(expected == 4);
+    }
+
+    SECTION("observed NULL")
+    {
+        table.store(std::make_unique<RowStore>(table));
+        auto &store = static_cast<RowStore&>(table.store());
+
+        auto insertions = m::statement_from_string(diag, "INSERT INTO test VALUES (1), (NULL);");
+        m::execute_statement(diag, *insertions);
+        REQUIRE(diag.num_errors() == 0);
+
+        CHECK_FALSE(store.drop_null_bitmap());
+        CHECK((*store.linearization().begin()).stride == 8);
+    }
+}
+
+TEST_CASE("RowStore/hot cold", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 8));
+    table.push_back(C.pool("b"), m::Type::Get_Char(m::Type::TY_Vector, 40));
+    table.push_back(C.pool("c"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.store(std::make_unique<RowStore>(table));
+    C.set_database_in_use(DB);
+
+    std::ostringstream out, err;
+    m::Diagnostic diag(false, out, err);
+
+    /* Every other row has a NULL, which must survive moving the rows between groups. */
+    std::string insertions = "INSERT INTO test VALUES ";
+    for (int32_t i = 0; i != 100; ++i) {
+        insertions += (i ? ", (" : "(") + std::to_string(int64_t(i) << 20) + ", \"row\", ";
+        insertions += (i % 2 ? std::string("NULL") : std::to_string(i)) + ")";
+    }
+    m::execute_statement(diag, *m::statement_from_string(diag, insertions + ";"));
+    REQUIRE(diag.num_errors() == 0);
+
+    auto &store = static_cast<RowStore&>(table.store());
+    REQUIRE(store.num_rows() == 100);
+    REQUIRE(store.num_groups() == 1);
+
+    /* Nothing to split without any noted access. */
+    CHECK_FALSE(store.repartition());
+
+    /* Attribute 'b' is hardly ever accessed. */
+    store.note_access(0, 100);
+    store.note_access(1, 2);
+    store.note_access(2, 50);
+    REQUIRE(store.repartition());
+    REQUIRE(store.num_groups() == 2);
+    CHECK(store.layout(0).contains(0));
+    CHECK(store.layout(0).contains(2));
+    CHECK(store.layout(0).has_null_bitmap);
+    CHECK(store.layout(1).order == std::vector<std::size_t>{ 1 });
+    CHECK_FALSE(store.layout(1).has_null_bitmap);
+    CHECK(store.layout(0).stride_bytes == 16); // 8 byte INT, 4 byte INT, null bitmap, padding
+    CHECK(store.layout(1).stride_bytes == 40);
+    CHECK(store.linearization().num_sequences() == 2); // one sequence per group
+
+    /* Same accesses, same split. */
+    CHECK_FALSE(store.repartition());
+
+    auto check_rows = [&]() {
+        auto stmt = m::statement_from_string(diag, "SELECT a, b, c FROM test;");
+        REQUIRE(diag.num_errors() == 0);
+
+        int32_t expected = 0;
+        auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema&, const m::Tuple &T) {
+            CHECK(T.get(0).as_i() == int64_t(expected) << 20);
+            CHECK(std::string(reinterpret_cast<const char*>(T.get(1).as_p())) == "row");
+            if (expected % 2) CHECK(T.is_null(2)); else CHECK(T.get(2).as_i() == expected);
+            ++expected;
+        });
+        std::unique_ptr<m::SelectStmt> select_stmt(static_cast<m::SelectStmt*>(stmt.release()));
+        m::execute_query(diag, *select_stmt, std::move(callback));
+        REQUIRE(diag.num_errors() == 0);
+        CHECK(expected == 100);
+    };
+    check_rows();
+
+    /* Once 'b' is accessed as often as the others, the groups are merged again. */
+    store.note_access(1, 100);
+    REQUIRE(store.repartition());
+    CHECK(store.num_groups() == 1);
+    check_rows();
+}
+
+TEST_CASE("RowStore/erase", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    C.set_database_in_use(DB);
+
+    /* Compact explicitly only. */
+    RowStore::Options options;
+    options.compaction_threshold = 1;
+    table.store(std::make_unique<RowStore>(table, options));
+    auto &store = static_cast<RowStore&>(table.store());
+    {
+        m::StoreWriter W(store);
+        m::Tuple tup(W.schema());
+        for (int32_t i = 0; i != 1000; ++i) {
+            tup.set(0, i);
+            W.append(tup);
+        }
+    }
+
+    /* Erase all even rows. */
+    for (std::size_t row = 0; row < 1000; row += 2)
+        REQUIRE(store.erase(row));
+    CHECK_FALSE(store.erase(0)); // dead already
+    CHECK_FALSE(store.erase(1000)); // does not exist
+    CHECK(store.num_rows() == 1000);
+    CHECK(store.num_live_rows() == 500);
+    CHECK_FALSE(store.is_live(0));
+    CHECK(store.is_live(1));
+
+    /* Compaction moves live rows into the holes, a step at a time. */
+    CHECK(store.compact(10) == 10);
+    CHECK(store.tombstones().size() == 480); // 10 holes filled, 10 dead rows dropped from the end
+    store.compact();
+    CHECK(store.tombstones().empty());
+    REQUIRE(store.num_rows() == 500);
+
+    std::ostringstream out, err;
+    m::Diagnostic diag(false, out, err);
+    auto stmt = m::statement_from_string(diag, "SELECT a FROM test;");
+    REQUIRE(diag.num_errors() == 0);
+
+    std::vector<int64_t> values;
+    auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema&, const m::Tuple &T) {
+        values.push_back(T.get(0).as_i());
+    });
+    std::unique_ptr<m::SelectStmt> select_stmt(static_cast<m::SelectStmt*>(stmt.release()));
+    m::execute_query(diag, *select_stmt, std::move(callback));
+    REQUIRE(diag.num_errors() == 0);
+
+    /* Exactly the odd rows survive, in any order. */
+    std::sort(values.begin(), values.end());
+    REQUIRE(values.size() == 500);
+    for (std::size_t idx = 0; idx != values.size(); ++idx)
+        CHECK(values[idx] == int64_t(2 * idx + 1));
+}
+
+TEST_CASE("RowStore/erase and query", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    C.set_database_in_use(DB);
+    table.store(std::make_unique<RowStore>(table));
+    auto &store = static_cast<RowStore&>(table.store());
+    {
+        m::StoreWriter W(store);
+        m::Tuple tup(W.schema());
+        for (int32_t i = 0; i != 300; ++i) {
+            tup.set(0, i);
+            W.append(tup);
+        }
+    }
+
+    /* By default, every erase compacts at once, so queries never see an erased row. */
+    for (int32_t i = 0; i < 300; i += 3) {
+        std::size_t row = 0;
+        auto value = [&]() { const auto loc = store.value_location(row, 0); return loc.base + loc.bit / 8; };
+        while (load_integer(value(), 4) != i) ++row;
+        REQUIRE(store.erase(row));
+    }
+    CHECK(store.num_rows() == 200);
+    CHECK(store.tombstones().empty());
+
+    std::ostringstream out, err;
+    m::Diagnostic diag(false, out, err);
+    auto stmt = m::statement_from_string(diag, "SELECT a FROM test;");
+    REQUIRE(diag.num_errors() == 0);
+
+    std::vector<int64_t> values;
+    auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema&, const m::Tuple &T) {
+        values.push_back(T.get(0).as_i());
+    });
+    std::unique_ptr<m::SelectStmt> select_stmt(static_cast<m::SelectStmt*>(stmt.release()));
+    m::execute_query(diag, *select_stmt, std::move(callback));
+    REQUIRE(diag.num_errors() == 0);
+
+    std::sort(values.begin(), values.end());
+    REQUIRE(values.size() == 200);
+    for (std::size_t idx = 0; idx != values.size(); ++idx)
+        CHECK(values[idx] == int64_t(idx / 2 * 3 + idx % 2 + 1));
+}
+
+TEST_CASE("RowStore/statistics", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.store(std::make_unique<RowStore>(table));
+
+    auto &store = static_cast<RowStore&>(table.store());
+    {
+        m::StoreWriter W(store);
+        m::Tuple tup(W.schema());
+        for (int32_t i = 0; i != 100; ++i) {
+            tup.set(0, i);
+            W.append(tup);
+        }
+    }
+    store.erase(7);
+
+    const auto stats = store.statistics();
+    CHECK(stats.rows == 100);
+    CHECK(stats.live_rows == 99);
+    CHECK(stats.capacity > 100);
+    CHECK(stats.bytes_per_row == 8); // 4 byte INT, 1 bit null bitmap, padding
+    CHECK(stats.allocated_bytes == stats.capacity * stats.bytes_per_row);
+    CHECK(stats.null_bitmap_bytes == stats.capacity);
+    CHECK(stats.grow_reallocations > 0);
+    CHECK(stats.shrink_reallocations == 0);
+    CHECK(stats.linearizations == stats.grow_reallocations + 1); // built once more by the c'tor
+
+    std::ostringstream dump, json;
+    store.dump(dump);
+    CHECK(dump.str().find("RowStore of table 'test'") == 0);
+    stats.print_json(json);
+    CHECK(json.str().find("{\"rows\":100,\"live_rows\":99,") == 0);
+}
+
+TEST_CASE("RowStore/zone map", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("sorted"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("unsorted"), m::Type::Get_Integer(m::Type::TY_Vector, 8));
+
+    RowStore::Options options;
+    options.zone_map_attributes = { "sorted", "unsorted" };
+    table.store(std::make_unique<RowStore>(table, options));
+    auto &store = static_cast<RowStore&>(table.store());
+
+    constexpr int32_t NUM_ROWS = 8 * ZoneMap::BLOCK_ROWS + 100;
+    {
+        m::StoreWriter W(store);
+        m::Tuple tup(W.schema());
+        for (int32_t i = 0; i != NUM_ROWS; ++i) {
+            tup.set(0, i);
+            tup.set(1, int64_t(i * 7919 % NUM_ROWS));
+            W.append(tup);
+        }
+    }
+
+    /* Blocks are summarized once all their rows are written. */
+    std::size_t skipped = 0;
+    auto selection = store.select_range(0, 3000, 3999, &skipped);
+    REQUIRE(store.zone_map(0)->num_blocks() == 8);
+    CHECK(store.zone_map(0)->zone(1).min == 1024);
+    CHECK(store.zone_map(0)->zone(1).max == 2047);
+    CHECK(skipped == 6); // only blocks 2 and 3 may contain the range, the unsummarized tail is scanned
+    REQUIRE(selection.size() == 1000);
+    for (std::size_t i = 0; i != selection.size(); ++i)
+        CHECK(selection[i] == 3000 + i);
+
+    /* Unsorted values span every block, nothing is skipped but the result is still right. */
+    skipped = 0;
+    selection = store.select_range(1, 0, 99, &skipped);
+    CHECK(skipped == 0);
+    CHECK(selection.size() == 100);
+
+    /* Dead rows are not selected, dropped rows forget their block. */
+    store.erase(3000);
+    CHECK(store.select_range(0, 3000, 3999).size() == 999);
+    for (int i = 0; i != 200; ++i)
+        store.drop();
+    CHECK(store.zone_map(0)->num_blocks() == 7);
+    CHECK(store.select_range(0, 7000, NUM_ROWS).size() == NUM_ROWS - 200 - 7000);
+}
+
+TEST_CASE("RowStore/snapshot", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("b"), m::Type::Get_Integer(m::Type::TY_Vector, 8));
+    table.store(std::make_unique<RowStore>(table));
+
+    auto &copy = DB.add_table(C.pool("copy"));
+    copy.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    copy.push_back(C.pool("b"), m::Type::Get_Integer(m::Type::TY_Vector, 8));
+    copy.store(std::make_unique<RowStore>(copy));
+
+    {
+        m::StoreWriter W(table.store());
+        m::Tuple tup(W.schema());
+        for (int32_t i = 0; i != 1000; ++i) {
+            tup.set(0, i);
+            tup.set(1, int64_t(i) << 20);
+            W.append(tup);
+        }
+    }
+
+    const auto path = (std::filesystem::temp_directory_path() / "RowStoreTest.snapshot").string();
+    REQUIRE(static_cast<RowStore&>(table.store()).save(path.c_str()));
+
+    /* Restore into the empty store of a table with the same schema. */
+    auto &store = static_cast<RowStore&>(copy.store());
+    REQUIRE(store.restore(path.c_str()));
+    std::filesystem::remove(path);
+    REQUIRE(store.num_rows() == 1000);
+
+    /* A non-empty store cannot be restored. */
+    CHECK_FALSE(store.restore(path.c_str()));
+
+    /* Appending grows the store out of the snapshot. */
+    {
+        m::StoreWriter W(store);
+        m::Tuple tup(W.schema());
+        for (int32_t i = 1000; i != 2000; ++i) {
+            tup.set(0, i);
+            tup.set(1, int64_t(i) << 20);
+            W.append(tup);
+        }
+    }
+    REQUIRE(store.num_rows() == 2000);
+
+    C.set_database_in_use(DB);
+    std::ostringstream out, err;
+    m::Diagnostic diag(false, out, err);
+
+    auto stmt = m::statement_from_string(diag, "SELECT a, b FROM copy;");
+    REQUIRE(diag.num_errors() == 0);
+
+    int32_t expected = 0;
+    auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema&, const m::Tuple &T) {
+        CHECK(T.get(0).as_i() == expected);
+        CHECK(T.get(1).as_i() == int64_t(expected) << 20);
+        ++expected;
+    });
+
+    std::unique_ptr<m::SelectStmt> select_stmt(static_cast<m::SelectStmt*>(stmt.release()));
+    m::execute_query(diag, *select_stmt, std::move(callback));
+    REQUIRE(diag.num_errors() == 0);
+    REQUIRE(expected == 2000);
+}
+
+TEST_CASE("RowStore/snapshot validation", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("b"), m::Type::Get_Integer(m::Type::TY_Vector, 8));
+    table.store(std::make_unique<RowStore>(table));
+    auto &store = static_cast<RowStore&>(table.store());
+
+    store.append(100);
+    for (std::size_t row = 0; row != 100; ++row) {
+        const int32_t a = int32_t(row);
+        const auto loc = store.value_location(row, 0);
+        memcpy(loc.base + loc.bit / 8, &a, sizeof(a));
+    }
+
+    /* Saving compacts the store, erased rows do not come back. */
+    REQUIRE(store.erase(10));
+    const auto path = (std::filesystem::temp_directory_path() / "RowStoreTest.snapshot").string();
+    REQUIRE(store.save(path.c_str()));
+    CHECK(store.tombstones().size() == 0);
+    CHECK(store.num_rows() == 99);
+
+    /* Restores the snapshot into a new store, returns its number of rows or -1 if the snapshot is rejected. */
+    auto &copy = DB.add_table(C.pool("copy"));
+    copy.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    copy.push_back(C.pool("b"), m::Type::Get_Integer(m::Type::TY_Vector, 8));
+    auto restore = [&]() {
+        copy.store(std::make_unique<RowStore>(copy));
+        if (not static_cast<RowStore&>(copy.store()).restore(path.c_str())) return std::size_t(-1);
+        return copy.store().num_rows();
+    };
+    REQUIRE(restore() == 99);
+
+    /* Overwrites the 8 bytes at `offset` of the snapshot. */
+    auto patch = [&](std::size_t offset, uint64_t value) {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(offset);
+        file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    /* The header takes 48 bytes, both attributes 25 bytes each, followed by the groups and offsets of the layout. */
+    constexpr std::size_t NUM_SEGMENTS = 40, LAYOUT = 48 + 2 * 25, OFFSET_OF_B = LAYOUT + 7 * 8;
+
+    SECTION("segment count beyond the file")
+    {
+        patch(NUM_SEGMENTS, uint64_t(1) << 60);
+        CHECK(restore() == std::size_t(-1));
+    }
+
+    SECTION("offset beyond the row")
+    {
+        patch(OFFSET_OF_B, 8 * 4096);
+        CHECK(restore() == std::size_t(-1));
+        patch(OFFSET_OF_B, uint64_t(-8));
+        CHECK(restore() == std::size_t(-1));
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("RowStore/parallel CSV", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("id"),    m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("flag"),  m::Type::Get_Boolean(m::Type::TY_Vector));
+    table.push_back(C.pool("price"), m::Type::Get_Double(m::Type::TY_Vector));
+    table.push_back(C.pool("name"),  m::Type::Get_Char(m::Type::TY_Vector, 12));
+    table.store(std::make_unique<RowStore>(table));
+
+    /* The header orders the columns differently, and quoted names contain commas, newlines and quotes, doubled or
+     * escaped with a backslash. */
+    constexpr int32_t NUM_RECORDS = 300;
+    const auto path = (std::filesystem::temp_directory_path() / "RowStoreTest.csv").string();
+    {
+        std::ofstream out(path);
+        out << "name,id,price,flag\r\n";
+        for (int32_t i = 0; i != NUM_RECORDS; ++i) {
+            if (i % 10 == 0)
+                out << "\"a, \"\"b\"\"\n\"";
+            else if (i % 5 == 0)
+                out << "\"a, \\\"b\\\"\n\"";
+            else
+                out << 'n' << i;
+            out << ',' << i << ',';
+            if (i % 7) out << i * .5;
+            out << ',' << (i % 2 ? "TRUE" : "FALSE") << '\n';
+        }
+    }
+
+    std::ostringstream out, err;
+    m::Diagnostic diag(false, out, err);
+    /* Tiny ranges, so that records and quoted fields span several of them. */
+    REQUIRE(load_CSV_parallel(diag, table, path.c_str(), true, 4, 64));
+    std::filesystem::remove(path);
+    REQUIRE(diag.num_errors() == 0);
+    REQUIRE(table.store().num_rows() == NUM_RECORDS);
+
+    C.set_database_in_use(DB);
+    auto stmt = m::statement_from_string(diag, "SELECT id, flag, price, name FROM test;");
+    REQUIRE(diag.num_errors() == 0);
+
+    int32_t expected = 0;
+    auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema&, const m::Tuple &T) {
+        CHECK(T.get(0).as_i() == expected);
+        CHECK(T.get(1).as_b() == bool(expected % 2));
+        if (expected % 7) {
+            REQUIRE_FALSE(T.is_null(2));
+            CHECK(T.get(2).as_d() == expected * .5);
+        } else {
+            CHECK(T.is_null(2));
+        }
+        const std::string name = expected % 5 ? "n" + std::to_string(expected) : "a, \"b\"\n";
+        CHECK(name == reinterpret_cast<char*>(T.get(3).as_p()));
+        ++expected;
+    });
+
+    std::unique_ptr<m::SelectStmt> select_stmt(static_cast<m::SelectStmt*>(stmt.release()));
+    m::execute_query(diag, *select_stmt, std::move(callback));
+    REQUIRE(diag.num_errors() == 0);
+    REQUIRE(expected == NUM_RECORDS);
+}